@@ -0,0 +1,122 @@
+/*
+ * background_model.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef BACKGROUNDMODEL_H_
+#define BACKGROUNDMODEL_H_
+
+#include <unordered_map>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/segmentation/supervoxel_clustering.h>
+
+#include "cloud_types.h"
+#include "color_utilities.h"
+
+struct backgroundStats {
+
+    backgroundStats() :
+    points(0), changed_points(0), supervoxels(0), carried_supervoxels(0) {
+    }
+    size_t points, changed_points, supervoxels, carried_supervoxels;
+};
+
+/**
+ * Voxel-level model of the static background seen by a fixed camera. 
+ * 
+ * The model stores the mean color of every voxel of a reference frame together
+ * with the supervoxel segmentation computed for it. Voxels are taken in the 
+ * same space as the ones of the supervoxels, that is after the single camera 
+ * transform if it is used. For every new frame, the 
+ * voxels whose occupancy and color did not change are marked as unchanged; the
+ * supervoxels of the reference frame made only of unchanged voxels are carried
+ * over, while all remaining points need to be segmented again and linked to 
+ * the carried supervoxels.
+ */
+class BackgroundModel {
+
+    struct backgroundVoxel {
+        float rgb[3];
+        uint32_t label;
+    };
+
+    typedef std::unordered_map<uint64_t, backgroundVoxel> VoxelMapT;
+
+    float resolution, color_tolerance, learning_rate;
+    bool camera_transform;
+    VoxelMapT voxels;
+    ClusteringT segments, carried;
+    AdjacencyMapT adjacency;
+    uint32_t max_label;
+    backgroundStats stats;
+
+    uint64_t key(const PointT &p) const;
+    static uint64_t neighbor_key(uint64_t k, int dx, int dy, int dz);
+
+public:
+
+    BackgroundModel(float res, float tolerance, bool transform = true);
+
+    /**
+     * Check if a reference frame has already been stored
+     * 
+     * @return true if the model contains a background segmentation
+     */
+    bool has_background() const {
+        return !segments.empty();
+    }
+
+    /**
+     * Get the statistics of the last classified frame
+     * 
+     * @return the number of changed points and carried supervoxels
+     */
+    backgroundStats get_stats() const {
+        return stats;
+    }
+
+    void set_background(PointCloudT::Ptr cloud, PointLCloudT::Ptr labels,
+            const ClusteringT &supervoxels, const AdjacencyMapT &adj);
+    PointCloudT::Ptr classify(PointCloudT::Ptr cloud,
+            std::vector<int> &indices);
+    void link(ClusteringT &supervoxels, AdjacencyMapT &adj) const;
+    ClusteringT get_carried() const;
+    void clear();
+};
+
+#endif /* BACKGROUNDMODEL_H_ */
@@ -0,0 +1,75 @@
+/*
+ * cloud_types.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef CLOUD_TYPES_H_
+#define CLOUD_TYPES_H_
+
+#include <stdint.h>
+
+#include <map>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/segmentation/supervoxel_clustering.h>
+
+/*
+ * Point and pointcloud types shared by the whole pipeline: colored points are
+ * segmented, labelled points hold segmentations and groundtruths, and the
+ * input files have both a color and a label for each point
+ */
+typedef pcl::Normal Normal;
+typedef pcl::PointXYZRGBA PointT;
+typedef pcl::PointXYZL PointLT;
+typedef pcl::PointXYZRGBL PointLCT;
+typedef pcl::PointNormal PointNT;
+typedef pcl::PointCloud<Normal> NormalCloudT;
+typedef pcl::PointCloud<PointT> PointCloudT;
+typedef pcl::PointCloud<PointLT> PointLCloudT;
+typedef pcl::PointCloud<PointLCT> PointLCCloudT;
+typedef pcl::PointCloud<PointNT> PointNCloudT;
+
+/*
+ * Supervoxels and their adjacency
+ */
+typedef pcl::Supervoxel<PointT> SupervoxelT;
+typedef std::map<uint32_t, SupervoxelT::Ptr> ClusteringT;
+typedef std::multimap<uint32_t, uint32_t> AdjacencyMapT;
+
+#endif /* CLOUD_TYPES_H_ */
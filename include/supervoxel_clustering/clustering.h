@@ -44,19 +44,14 @@
 #include <pcl/point_types.h>
 #include <pcl/segmentation/supervoxel_clustering.h>
 
+#include "cloud_types.h"
 #include "color_utilities.h"
 #include "clustering_state.h"
+#include "segment_index.h"
+#include "temporal_cache.h"
 #include "testing.h"
+#include "thread_pool.h"
 
-typedef pcl::Normal Normal;
-typedef pcl::PointXYZRGBA PointT;
-typedef pcl::PointXYZL PointLT;
-typedef pcl::PointXYZRGBL PointLCT;
-typedef pcl::PointCloud<PointT> PointCloudT;
-typedef pcl::PointCloud<PointLT> PointLCloudT;
-typedef pcl::Supervoxel<PointT> SupervoxelT;
-typedef std::map<uint32_t, SupervoxelT::Ptr> ClusteringT;
-typedef std::multimap<uint32_t, uint32_t> AdjacencyMapT;
 typedef std::multiset<float> DeltasDistribT;
 
 enum ColorDistance {
@@ -80,6 +75,13 @@ enum MergingCriterion {
  *     using supervoxels with geometry and color for 3D scene understanding," in 
  *     IEEE International Conference on Multimedia and Expo (ICME 2017), Hong 
  *     Kong, 2017, pp. 1285–1290.
+ * 
+ * The prepared initial state (regions, edge weights and merging parameters) 
+ * is kept apart from the state of each clustering run: once 'prepare' has 
+ * been called, 'run' only touches the state it is given, so many threads can
+ * cluster the same initial state at different thresholds at the same time. 
+ * The 'cluster' method and the getters without a state argument work on an 
+ * internal state, and are not meant for concurrent use.
  */
 class Clustering {
     ColorDistance delta_c_type;
@@ -88,30 +90,54 @@ class Clustering {
     float lambda;
     short bins_num;
     std::map<short, float> cdf_c, cdf_g;
-    bool set_initial_state, init_initial_weights;
+    bool set_initial_state, init_initial_weights, voxel_normals;
     ClusteringState initial_state, state;
+    TemporalCache * temporal_cache;
+    ThreadPool * pool;
+    SegmentIndex segment_index;
 
     bool is_convex(Normal norm1, PointT centroid1, Normal norm2,
             PointT centroid2) const;
     float normals_diff(Normal norm1, PointT centroid1, Normal norm2,
             PointT centroid2) const;
     std::pair<float, float> delta_c_g(SupervoxelT::Ptr supvox1,
-            SupervoxelT::Ptr supvox2) const;
-    float delta(SupervoxelT::Ptr supvox1, SupervoxelT::Ptr supvox2) const;
-    AdjacencyMapT weight2adj(WeightMapT w_map) const;
-    WeightMapT adj2weight(ClusteringT segm, AdjacencyMapT adj_map) const;
+            SupervoxelT::Ptr supvox2, const segmentMoments *moments1 = NULL,
+            const segmentMoments *moments2 = NULL) const;
+    float delta(SupervoxelT::Ptr supvox1, SupervoxelT::Ptr supvox2,
+            const segmentMoments *moments1 = NULL,
+            const segmentMoments *moments2 = NULL) const;
+    void weight2adj(const WeightMapT &w_map, AdjacencyMapT &adj_map) const;
+    void adj2weight(const AdjacencyMapT &adj_map, WeightMapT &w_map) const;
+    void compute_deltas(
+            const std::vector<std::pair<uint32_t, uint32_t> > *edges,
+            const std::vector<char> *cached,
+            std::vector<std::pair<float, float> > *deltas, size_t begin,
+            size_t end) const;
     void init_weights();
-    void init_merging_parameters(DeltasDistribT deltas_c,
-            DeltasDistribT deltas_g);
-    std::map<short, float> compute_cdf(DeltasDistribT dist);
+    void init_merging_parameters(const DeltasDistribT &deltas_c,
+            const DeltasDistribT &deltas_g);
+    std::map<short, float> compute_cdf(const DeltasDistribT &dist);
     float t_c(float delta_c) const;
     float t_g(float delta_g) const;
-    void cluster(ClusteringState start, float threshold);
-    void merge(std::pair<uint32_t, uint32_t> supvox_ids);
+    void merge(ClusteringState &state,
+            std::pair<uint32_t, uint32_t> supvox_ids,
+            bool merge_voxels = true) const;
+
+    void evaluate_range(PointLCloudT::Ptr ground_truth,
+            const std::vector<float> *t_values, size_t begin, size_t end,
+            std::vector<performanceSet> *performances,
+            ClusteringState *final_state) const;
 
-    static void clear_adjacency(AdjacencyMapT * adjacency);
-    static bool contains(WeightMapT w, uint32_t i1, uint32_t i2);
-    static float deltas_mean(DeltasDistribT deltas);
+    static const segmentMoments & get_moments(ClusteringState &state,
+            uint32_t label, SupervoxelT::Ptr segment);
+    static float deltas_mean(const DeltasDistribT &deltas);
+    static void mean_color(SupervoxelT::Ptr s, const segmentMoments *moments,
+            float rgb[3]);
+    static size_t color_slot(uint32_t rgba, size_t capacity);
+    template <typename PointLabelT>
+    static void label2color_range(
+            const pcl::PointCloud<PointLabelT> *label_cloud,
+            PointCloudT *colored_cloud, size_t begin, size_t end);
 
 public:
 
@@ -139,7 +165,20 @@ public:
     void set_merging(MergingCriterion m);
     void set_lambda(float l);
     void set_bins_num(short b);
-    void set_initialstate(ClusteringT segm, AdjacencyMapT adj);
+    void set_initialstate(const ClusteringT &segm, const AdjacencyMapT &adj);
+    void set_temporal_cache(TemporalCache * cache);
+    void set_thread_pool(ThreadPool * thread_pool);
+
+    /**
+     * Set whether the normals of the voxels come from the sensor. If so, the
+     * normal of a merged region is the mean of the normals of its two parts,
+     * weighted by their size, instead of being fitted to its voxels.
+     * 
+     * @param v true if the normals of the voxels come from the sensor
+     */
+    void set_voxel_normals(bool v) {
+        voxel_normals = v;
+    }
 
     /**
      * Get the type of color distance used
@@ -188,12 +227,24 @@ public:
     }
 
     std::pair<ClusteringT, AdjacencyMapT> get_currentstate() const;
+    void get_adjacency(AdjacencyMapT &adjacency) const;
 
     PointCloudT::Ptr get_colored_cloud() const;
     PointLCloudT::Ptr get_labeled_cloud() const;
+    void get_labeled_cloud(PointLCloudT &label_cloud) const;
+
+    void prepare();
+    const ClusteringState & get_initialstate() const;
+    void run(ClusteringState &run_state, float threshold,
+            std::vector<WeightedPairT> *merges = NULL,
+            bool merge_voxels = true) const;
+    void hierarchy(std::vector<WeightedPairT> &merges) const;
 
     void cluster(float threshold);
 
+    const SegmentIndex & get_segment_index();
+    std::vector<segmentDescriptor> get_descriptors() const;
+
     std::map<float, performanceSet> all_thresh(
             PointLCloudT::Ptr ground_truth, float start_thresh,
             float end_thresh, float step_thresh);
@@ -206,9 +257,21 @@ public:
     void test_all() const;
 
     static PointCloudT::Ptr label2color(
-            PointLCloudT::Ptr label_cloud);
+            PointLCloudT::Ptr label_cloud, ThreadPool *pool = NULL);
     static PointLCloudT::Ptr color2label(
             PointCloudT::Ptr colored_cloud);
+    template <typename PointLabelT>
+    static void label2color(const pcl::PointCloud<PointLabelT> &label_cloud,
+            PointCloudT &colored_cloud, ThreadPool *pool = NULL);
+    template <typename PointColorT>
+    static void color2label(const pcl::PointCloud<PointColorT> &colored_cloud,
+            PointLCloudT &label_cloud);
+    static PointCloudT::Ptr state2color(const ClusteringState &state,
+            ThreadPool *pool = NULL);
+    static void state2label(const ClusteringState &state,
+            PointLCloudT &label_cloud);
+    static std::vector<segmentDescriptor> state2descriptors(
+            const ClusteringState &state);
 };
 
 #endif /* CLUSTERING_H_ */
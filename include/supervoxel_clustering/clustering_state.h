@@ -44,11 +44,12 @@
 #include <pcl/point_types.h>
 #include <pcl/segmentation/supervoxel_clustering.h>
 
-typedef pcl::PointXYZRGBA PointT;
-typedef pcl::Supervoxel<PointT> SupervoxelT;
-typedef std::map<uint32_t, SupervoxelT::Ptr> ClusteringT;
+#include "cloud_types.h"
+#include "segment_moments.h"
+
 typedef std::multimap<float, std::pair<uint32_t, uint32_t> > WeightMapT;
 typedef std::pair<float, std::pair<uint32_t, uint32_t> > WeightedPairT;
+typedef std::map<uint32_t, segmentMoments> MomentsMapT;
 
 /**
  * Data structure representing a state of the clustering process. It holds 
@@ -59,12 +60,16 @@ typedef std::pair<float, std::pair<uint32_t, uint32_t> > WeightedPairT;
  * Edge weights are represented as a map where the cell addressed by two labels 
  * contains the weight of the edge connecting the nodes identified by those 
  * labels. This map is sorted from the smallest weight to the biggest.
+ * 
+ * The summed moments of the voxels of each node are kept along, so that the 
+ * descriptors of the regions can be computed without visiting their voxels.
  */
 class ClusteringState {
     friend class Clustering;
 
     ClusteringT segments;
     WeightMapT weight_map;
+    MomentsMapT moments;
 
 public:
 
@@ -91,6 +96,7 @@ public:
      */
     void set_segments(ClusteringT s) {
         segments = s;
+        moments.clear();
     }
 
     /**
@@ -111,6 +117,18 @@ public:
         weight_map = w;
     }
 
+    /**
+     * Get the summed moments of the voxels of the nodes; they are computed by
+     * the Clustering class, and missing for the nodes of a state built 
+     * elsewhere
+     * 
+     * @return a map containing the moments of each region, identified by its
+     *         label
+     */
+    const MomentsMapT & get_moments() const {
+        return moments;
+    }
+
     /**
      * Get the pair of nodes connected by the edge having the smallest weight
      * 
@@ -120,6 +138,18 @@ public:
     WeightedPairT get_first_weight() const {
         return *(weight_map.begin());
     }
+
+    /**
+     * Exchange the nodes, edges and moments of two states without copying 
+     * them
+     * 
+     * @param other the state to exchange the contents with
+     */
+    void swap(ClusteringState &other) {
+        segments.swap(other.segments);
+        weight_map.swap(other.weight_map);
+        moments.swap(other.moments);
+    }
 };
 
 #endif /* CLUSTERINGSTATE_H_ */
@@ -51,14 +51,14 @@
 #include <iostream>
 #include <fstream>
 #include <math.h>
+#include <vector>
+
+#include "cloud_types.h"
 
 struct Color {
     uint8_t data[3];
 };
 
-typedef pcl::PointXYZRGBA PointT;
-typedef pcl::Supervoxel<PointT> SupervoxelT;
-
 const float RGB_RANGE = 441.672943;
 const float LAB_RANGE = 137.3607;
 
@@ -68,6 +68,7 @@ const float LAB_RANGE = 137.3607;
  */
 class ColorUtilities {
     static float * color_conversion(float in[3], int code);
+    static void color_conversion(const float in[3], int code, float out[3]);
     static float ciede00_test(float L1, float a1, float b1, float L2, float a2,
             float b2, float result);
 
@@ -77,9 +78,14 @@ class ColorUtilities {
 public:
         
     static uint8_t * get_glasbey(uint32_t label);
+    static void get_glasbey(uint32_t label, uint8_t rgb[3]);
+    static const std::vector<uint32_t> & glasbey_table();
     static float * mean_color(SupervoxelT::Ptr s);
+    static void mean_color(SupervoxelT::Ptr s, float mean[3]);
     static float * rgb2lab(float rgb[3]);
+    static void rgb2lab(const float rgb[3], float lab[3]);
     static float * lab2rgb(float lab[3]);
+    static void lab2rgb(const float lab[3], float rgb[3]);
     static float lab_ciede00(float lab1[3], float lab2[3], double kL = 1.0,
             double kC = 1.0, double kH = 1.0);
     static float rgb_eucl(float rgb1[3], float rgb2[3]);
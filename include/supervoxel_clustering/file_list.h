@@ -0,0 +1,62 @@
+/*
+ * file_list.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef FILE_LIST_H_
+#define FILE_LIST_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * Utility class ordering the files of a sequence of frames. Files are sorted
+ * in natural order, comparing the runs of digits in their names by their 
+ * numeric value, so that frame2.pcd comes before frame10.pcd.
+ */
+class FileList {
+
+    FileList() {
+    }
+
+public:
+
+    static bool natural_less(const std::string &a, const std::string &b);
+    static void sort(std::vector<std::string> &files);
+};
+
+#endif /* FILE_LIST_H_ */
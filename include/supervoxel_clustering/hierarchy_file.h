@@ -0,0 +1,202 @@
+/*
+ * hierarchy_file.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef HIERARCHY_FILE_H_
+#define HIERARCHY_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "cloud_types.h"
+#include "clustering_state.h"
+
+#define HIERARCHY_MAGIC 0x52454948
+#define HIERARCHY_VERSION 1
+
+/**
+ * Header of a hierarchy file
+ */
+struct hierarchyHeader {
+    uint32_t magic, version, segments, padding;
+    uint64_t voxels, merges;
+};
+
+/**
+ * Voxel of a hierarchy file
+ */
+struct hierarchyVoxel {
+    float x, y, z;
+};
+
+/**
+ * Merge of a hierarchy file: the regions holding the initial segments of 
+ * index first and second are merged, at the given weight, in a region keeping
+ * the label of first
+ */
+struct hierarchyMerge {
+    float weight;
+    uint32_t first, second;
+};
+
+/**
+ * This class reads a hierarchy file, a compact binary file holding the whole
+ * hierarchy of a clustering: the voxels of each initial supervoxel and the 
+ * complete sequence of merges, down to a single region, with their weights.
+ * 
+ * Clustering at a threshold performs the merges of the sequence in order, 
+ * until the first one whose weight is not below the threshold, so the 
+ * segmentation at any threshold can be cut from the file in time linear in
+ * the number of voxels and merges, without computing any distance.
+ * 
+ * The file is made of, in little-endian order:
+ * 
+ * - a hierarchyHeader;
+ * - segments + 1 uint64_t offsets, the voxels of initial segment i being
+ *   those in [offsets[i], offsets[i + 1]);
+ * - segments uint32_t labels of the initial supervoxels, in increasing order,
+ *   padded to a multiple of 8 bytes;
+ * - voxels hierarchyVoxel;
+ * - merges hierarchyMerge.
+ * 
+ * The reader maps the file in memory and reads all arrays in place.
+ */
+class HierarchyFile {
+    void *memory;
+    size_t size;
+    const hierarchyHeader *header;
+    const uint64_t *offsets;
+    const uint32_t *labels;
+    const hierarchyVoxel *voxels;
+    const hierarchyMerge *merges;
+
+    HierarchyFile(const HierarchyFile &);
+    HierarchyFile & operator=(const HierarchyFile &);
+
+public:
+
+    HierarchyFile(std::string filename);
+    ~HierarchyFile();
+
+    /**
+     * Get the number of initial supervoxels
+     * 
+     * @return the number of initial supervoxels
+     */
+    size_t get_segments_num() const {
+        return header->segments;
+    }
+
+    /**
+     * Get the number of voxels
+     * 
+     * @return the number of voxels
+     */
+    size_t get_voxels_num() const {
+        return header->voxels;
+    }
+
+    /**
+     * Get the number of merges
+     * 
+     * @return the number of merges
+     */
+    size_t get_merges_num() const {
+        return header->merges;
+    }
+
+    /**
+     * Get a merge of the sequence
+     * 
+     * @param i the index of the merge, in [0, get_merges_num())
+     * 
+     * @return the merge
+     */
+    const hierarchyMerge & get_merge(size_t i) const {
+        return merges[i];
+    }
+
+    /**
+     * Get the label of an initial supervoxel
+     * 
+     * @param i the index of the supervoxel, in [0, get_segments_num())
+     * 
+     * @return the label
+     */
+    uint32_t get_label(size_t i) const {
+        return labels[i];
+    }
+
+    /**
+     * Get the index of the first voxel of an initial supervoxel
+     * 
+     * @param i the index of the supervoxel, in [0, get_segments_num()]; for
+     *          get_segments_num(), the number of voxels is returned
+     * 
+     * @return the index of the first voxel of the supervoxel
+     */
+    uint64_t get_offset(size_t i) const {
+        return offsets[i];
+    }
+
+    /**
+     * Get a voxel
+     * 
+     * @param i the index of the voxel, in [0, get_voxels_num())
+     * 
+     * @return the voxel
+     */
+    const hierarchyVoxel & get_voxel(size_t i) const {
+        return voxels[i];
+    }
+
+    size_t cut(float threshold, std::vector<uint32_t> &segment_labels) const;
+    void extract(float threshold, PointLCloudT &label_cloud) const;
+
+    static void save(std::string filename,
+            const ClusteringState &initial_state,
+            const std::vector<WeightedPairT> &merge_sequence);
+};
+
+#endif /* HIERARCHY_FILE_H_ */
@@ -0,0 +1,137 @@
+/*
+ * hierarchy_index.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef HIERARCHY_INDEX_H_
+#define HIERARCHY_INDEX_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "clustering_state.h"
+#include "hierarchy_file.h"
+#include "thread_pool.h"
+
+/**
+ * This class answers queries of the kind "which region does this voxel belong
+ * to at threshold t" on the hierarchy of a clustering, without clustering 
+ * again.
+ * 
+ * The merges form a tree whose leaves are the initial supervoxels, each merge
+ * adding a node parent of the current regions of its two supervoxels. As 
+ * clustering at a threshold performs the merges of the sequence up to the 
+ * first one whose weight is not below the threshold, the threshold is turned
+ * into a number of merges by binary search on the running maximum of the 
+ * weights; the region of a supervoxel is then its highest ancestor created by
+ * one of those merges, found by binary lifting. Both steps take O(log N).
+ * 
+ * Regions are identified by the label they have in the Clustering class, that
+ * is the label of the supervoxel whose label they kept through the merges.
+ */
+class HierarchyIndex {
+    size_t segments_num, nodes_num, levels;
+    std::vector<uint32_t> labels;
+    std::vector<uint32_t> voxel_segments;
+    std::vector<float> max_weights;
+    std::vector<uint32_t> node_merges;
+    std::vector<uint32_t> node_labels;
+    std::vector<uint32_t> ancestors;
+    ThreadPool *pool;
+
+    void build(const std::vector<uint32_t> &segment_labels,
+            const std::vector<uint64_t> &offsets,
+            const std::vector<hierarchyMerge> &merges);
+    void query_range(const std::vector<size_t> *voxels, size_t merges,
+            std::vector<uint32_t> *regions, size_t begin, size_t end) const;
+
+public:
+
+    HierarchyIndex(const HierarchyFile &file);
+    HierarchyIndex(const ClusteringState &initial_state,
+            const std::vector<WeightedPairT> &merge_sequence);
+
+    /**
+     * Set the thread pool on which batched queries run in parallel
+     * 
+     * @param thread_pool   the thread pool, or NULL to answer all queries in
+     *                      the calling thread
+     */
+    void set_thread_pool(ThreadPool *thread_pool) {
+        pool = thread_pool;
+    }
+
+    /**
+     * Get the number of initial supervoxels
+     * 
+     * @return the number of initial supervoxels
+     */
+    size_t get_segments_num() const {
+        return segments_num;
+    }
+
+    /**
+     * Get the number of voxels
+     * 
+     * @return the number of voxels
+     */
+    size_t get_voxels_num() const {
+        return voxel_segments.size();
+    }
+
+    /**
+     * Get the number of merges
+     * 
+     * @return the number of merges
+     */
+    size_t get_merges_num() const {
+        return max_weights.size();
+    }
+
+    size_t merges_below(float threshold) const;
+    uint32_t segment_region(size_t segment, float threshold) const;
+    uint32_t voxel_region(size_t voxel, float threshold) const;
+    void voxel_regions(const std::vector<size_t> &voxels, float threshold,
+            std::vector<uint32_t> &regions) const;
+    size_t regions_num(float threshold) const;
+
+    uint32_t ancestor(size_t node, size_t merges) const;
+};
+
+#endif /* HIERARCHY_INDEX_H_ */
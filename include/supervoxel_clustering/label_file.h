@@ -0,0 +1,172 @@
+/*
+ * label_file.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef LABEL_FILE_H_
+#define LABEL_FILE_H_
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#define LABEL_MAGIC 0x4c424c53
+#define LABEL_VERSION 1
+#define LABEL_NONE 0xffffffff
+
+enum LabelEncoding {
+    RAW_LABELS, RLE_LABELS
+};
+
+/**
+ * Header of a label file
+ */
+struct labelHeader {
+    uint32_t magic, version, encoding, padding;
+    uint64_t points, data_size;
+};
+
+/**
+ * This class reads a label file, a compact binary file holding the label of
+ * each point of a pointcloud, in the order of the points of the input file;
+ * points that were not segmented (e.g. with NaN coordinates) get LABEL_NONE.
+ * 
+ * The file is a labelHeader followed by data_size bytes of labels, either:
+ * 
+ * - RAW_LABELS: one uint32_t per point, which can be used in place;
+ * - RLE_LABELS: runs of points with the same label, each stored as two
+ *   LEB128 varints, the length of the run and the label, which is much 
+ *   smaller for organized clouds, whose neighbouring points mostly share 
+ *   their label.
+ * 
+ * The reader maps the file in memory.
+ */
+class LabelFile {
+    void *memory;
+    size_t size;
+    const labelHeader *header;
+    const uint8_t *data;
+
+    LabelFile(const LabelFile &);
+    LabelFile & operator=(const LabelFile &);
+
+public:
+
+    LabelFile(std::string filename);
+    ~LabelFile();
+
+    /**
+     * Get the number of points
+     * 
+     * @return the number of points
+     */
+    size_t get_points_num() const {
+        return header->points;
+    }
+
+    /**
+     * Get the encoding of the labels
+     * 
+     * @return the encoding
+     */
+    LabelEncoding get_encoding() const {
+        return static_cast<LabelEncoding> (header->encoding);
+    }
+
+    /**
+     * Get the labels of a RAW_LABELS file in place
+     * 
+     * @return the array of labels, or NULL if the file is encoded
+     */
+    const uint32_t * get_raw_labels() const {
+        if (header->encoding != RAW_LABELS)
+            return NULL;
+        return reinterpret_cast<const uint32_t *> (data);
+    }
+
+    void get_labels(std::vector<uint32_t> &labels) const;
+
+    static void encode(const std::vector<uint32_t> &labels,
+            LabelEncoding encoding, std::vector<uint8_t> &data);
+    static void save(std::string filename, const std::vector<uint32_t> &labels,
+            LabelEncoding encoding);
+};
+
+/**
+ * This class saves label files on a background thread, so that the caller 
+ * can go on with the next frame while the labels are encoded and written.
+ */
+class LabelWriter {
+
+    struct labelJob {
+        std::string filename;
+        boost::shared_ptr<std::vector<uint32_t> > labels;
+    };
+
+    LabelEncoding encoding;
+    std::deque<labelJob> jobs;
+    bool stopping, writing;
+    size_t written, failed;
+    boost::mutex mutex;
+    boost::condition_variable job_available, job_done;
+    boost::thread thread;
+
+    LabelWriter(const LabelWriter &);
+    LabelWriter & operator=(const LabelWriter &);
+
+    void work();
+
+public:
+
+    LabelWriter(LabelEncoding e = RAW_LABELS);
+    ~LabelWriter();
+
+    void write(std::string filename,
+            boost::shared_ptr<std::vector<uint32_t> > labels);
+    void flush();
+
+    size_t get_written();
+    size_t get_failed();
+};
+
+#endif /* LABEL_FILE_H_ */
@@ -0,0 +1,101 @@
+/*
+ * performance_report.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PERFORMANCE_REPORT_H_
+#define PERFORMANCE_REPORT_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "testing.h"
+
+/**
+ * Evaluation of a single file, as stored in a result file
+ */
+struct fileResult {
+    std::string filename;
+    performanceSet performance;
+    std::map<float, performanceSet> all_performances;
+};
+
+/**
+ * This class collects the functions to save and print the evaluation of a 
+ * dataset, and to store it in result files that can be merged later, e.g. when
+ * the dataset is split in shards processed on different machines.
+ * 
+ * A result file is a text file, optionally starting with the line
+ * 
+ *   run <arguments>
+ * 
+ * that identifies the run producing it, where each file of the dataset is
+ * described by the lines
+ * 
+ *   file <relative-path>
+ *   best <voi> <precision> <recall> <fscore> <wov> <fpr> <fnr>
+ *   thresh <threshold> <voi> <precision> <recall> <fscore> <wov> <fpr> <fnr>
+ *   ...
+ *   end
+ * 
+ * with one 'thresh' line for each threshold tested. Since each file is written
+ * as a whole, a result file can be used as a journal while a run is going.
+ */
+class PerformanceReport {
+public:
+
+    static void save_all(
+            std::vector<std::map<float, performanceSet> > all_performances,
+            std::string filename);
+    static void print_best(std::vector<performanceSet> best_performances);
+
+    static void write_result(std::ostream &out, const fileResult &result);
+    static void save_results(const std::vector<fileResult> &results,
+            std::string filename, std::string signature = "");
+    static bool load_results(std::string filename,
+            std::vector<fileResult> &results, std::string *signature = NULL);
+
+    static uint64_t path_hash(const std::string &path);
+    static bool in_shard(const std::string &path, size_t shard,
+            size_t shards);
+};
+
+#endif /* PERFORMANCE_REPORT_H_ */
@@ -0,0 +1,127 @@
+/*
+ * plane_extractor.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef PLANE_EXTRACTOR_H_
+#define PLANE_EXTRACTOR_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "clustering.h"
+#include "thread_pool.h"
+
+#define PLANE_HYPOTHESES 256
+#define PLANE_HYPOTHESES_CHUNKS 16
+#define PLANE_SCORING_POINTS 50000
+#define PLANE_MIN_FRACTION 0.1f
+
+/**
+ * A dominant plane pulled out of a pointcloud, voxelized on a regular grid
+ */
+struct planeSegment {
+    Eigen::Vector4f coefficients;
+    PointCloudT::Ptr voxels;
+    PointLCloudT::Ptr truth_voxels;
+};
+
+/**
+ * This class pulls the dominant planes (tables, walls, floors) out of a 
+ * pointcloud before its supervoxels are extracted. Such surfaces produce 
+ * many supervoxels and edges which only ever merge with each other; taking 
+ * them out shrinks the region graph, and each plane is given back to the 
+ * clustering as a single segment without edges.
+ * 
+ * Planes are found one at a time with RANSAC: the hypotheses are split in a
+ * fixed number of chunks, each with its own seed, scored in parallel on a 
+ * subsample of the points, so that the planes found do not depend on the 
+ * number of threads. The best hypothesis is refined by least squares on its
+ * inliers, which are then split in connected parts, so that disjoint coplanar
+ * surfaces are not taken as a single segment; each part with at least a 
+ * given fraction of the points is a plane, while the others are left to the
+ * supervoxels. The extraction stops when no plane is found.
+ */
+class PlaneExtractor {
+    float voxel_resolution, distance;
+    size_t max_planes;
+    ThreadPool *pool;
+
+    struct planeHypothesis {
+        Eigen::Vector4f coefficients;
+        size_t score;
+    };
+
+    void score_hypotheses(const PointCloudT *cloud,
+            const std::vector<int> *points, uint32_t seed,
+            planeHypothesis *best) const;
+    void inliers(const PointCloudT &cloud, const std::vector<int> &points,
+            const Eigen::Vector4f &coefficients,
+            std::vector<int> &plane_points,
+            std::vector<int> &other_points) const;
+    void components(const PointCloudT &cloud, const std::vector<int> &points,
+            std::vector<std::vector<int> > &parts) const;
+    void voxelize(const PointCloudT &cloud, const PointLCloudT &truth,
+            const std::vector<int> &points, planeSegment &plane) const;
+
+public:
+
+    PlaneExtractor(float voxel_resolution, size_t max_planes);
+
+    /**
+     * Set the thread pool on which the hypotheses are scored in parallel
+     * 
+     * @param thread_pool   the thread pool, or NULL to score all hypotheses in
+     *                      the calling thread
+     */
+    void set_thread_pool(ThreadPool *thread_pool) {
+        pool = thread_pool;
+    }
+
+    void extract(PointCloudT::Ptr cloud, PointLCloudT::Ptr truth,
+            std::vector<planeSegment> &planes,
+            NormalCloudT::Ptr normals = NormalCloudT::Ptr()) const;
+
+    static void add_segments(const std::vector<planeSegment> &planes,
+            ClusteringT &segments);
+};
+
+#endif /* PLANE_EXTRACTOR_H_ */
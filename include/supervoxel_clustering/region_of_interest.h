@@ -0,0 +1,121 @@
+/*
+ * region_of_interest.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef REGION_OF_INTEREST_H_
+#define REGION_OF_INTEREST_H_
+
+#include <cmath>
+#include <string>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+enum RoiType {
+    ROI_NONE, ROI_BOX, ROI_OBB, ROI_FRUSTUM
+};
+
+/**
+ * This class describes the region of the scene to be segmented, so that the
+ * points outside of it can be dropped before the supervoxels are extracted.
+ * 
+ * The region is given in the frame of the camera (x right, y down, z forward)
+ * as one of:
+ * 
+ * - box:<xmin>,<ymin>,<zmin>,<xmax>,<ymax>,<zmax>, an axis-aligned box;
+ * - obb:<cx>,<cy>,<cz>,<hx>,<hy>,<hz>,<roll>,<pitch>,<yaw>, a box with the 
+ *   given center and half sizes, rotated by the given angles in radians 
+ *   around x, y and z;
+ * - frustum:<hfov>,<vfov>,<near>,<far>, the part of the view of the camera 
+ *   within the given horizontal and vertical fields of view, in radians, and
+ *   between the given depths.
+ */
+class RegionOfInterest {
+    RoiType type;
+    Eigen::Vector3f min, max;
+    Eigen::Matrix3f rotation;
+    Eigen::Vector3f center;
+    float tan_h, tan_v;
+
+public:
+
+    RegionOfInterest();
+
+    static bool parse(std::string spec, RegionOfInterest &roi);
+
+    /**
+     * Get the type of region
+     * 
+     * @return the type of region, ROI_NONE if every point is in the region
+     */
+    RoiType get_type() const {
+        return type;
+    }
+
+    /**
+     * Check whether a point is in the region
+     * 
+     * @param x the x coordinate of the point
+     * @param y the y coordinate of the point
+     * @param z the z coordinate of the point
+     * 
+     * @return true if the point is in the region
+     */
+    bool contains(float x, float y, float z) const {
+        switch (type) {
+            case ROI_BOX:
+                return x >= min[0] && x <= max[0] && y >= min[1]
+                        && y <= max[1] && z >= min[2] && z <= max[2];
+            case ROI_OBB:
+            {
+                Eigen::Vector3f local = rotation.transpose()
+                        * (Eigen::Vector3f(x, y, z) - center);
+                return (local.cwiseAbs().array() <= max.array()).all();
+            }
+            case ROI_FRUSTUM:
+                return z >= min[2] && z <= max[2]
+                        && std::abs(x) <= z * tan_h
+                        && std::abs(y) <= z * tan_v;
+            default:
+                return true;
+        }
+    }
+};
+
+#endif /* REGION_OF_INTEREST_H_ */
@@ -0,0 +1,88 @@
+/*
+ * results_log.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef RESULTS_LOG_H_
+#define RESULTS_LOG_H_
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "testing.h"
+
+/**
+ * This class appends the evaluation of each processed file to a results file 
+ * in the JSON-lines format, as soon as the file is done. Each line is a
+ * self-contained record of one file evaluated at one threshold:
+ * 
+ *   {"file":"<id>","config":"<arguments>","thresh":<t>,"best":<true|false>,
+ *    "voi":<v>,"precision":<p>,"recall":<r>,"fscore":<f>,"wov":<w>,
+ *    "fpr":<fp>,"fnr":<fn>,"timings":{"<stage>":<ms>,...}}
+ * 
+ * where the record with "best" set is the one at the best threshold of the
+ * file. Since every line stands on its own, the file can be read while the run
+ * is going, concatenated with the files of other runs and loaded by analysis
+ * tools one line at a time. Writing is thread safe.
+ */
+class ResultsLog {
+    std::ofstream file;
+    boost::mutex mutex;
+
+    static std::string escape(const std::string &s);
+    void write_row(const std::string &file_id, const std::string &config,
+            float threshold, bool best, const performanceSet &p,
+            const std::string &timings);
+
+public:
+
+    bool open(std::string filename, bool append);
+    bool is_open() const;
+    void write(const std::string &file_id, const std::string &config,
+            const std::map<float, performanceSet> &all_performances,
+            const performanceSet &performance, float threshold,
+            const std::vector<std::pair<std::string, double> > &timings);
+    void close();
+};
+
+#endif /* RESULTS_LOG_H_ */
@@ -0,0 +1,136 @@
+/*
+ * segment_index.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef SEGMENT_INDEX_H_
+#define SEGMENT_INDEX_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+
+#include <pcl/kdtree/kdtree_flann.h>
+
+#include "clustering_state.h"
+
+/**
+ * Segment of a segment index, with its bounding box and the search tree of 
+ * its voxels
+ */
+struct indexedSegment {
+    uint32_t label;
+    SupervoxelT::Ptr segment;
+    Eigen::Vector3f min, max;
+    boost::shared_ptr<pcl::KdTreeFLANN<PointT> > tree;
+};
+
+/**
+ * Node of the bounding volume hierarchy of a segment index; leaves hold the
+ * segments in [begin, begin + count) of the ordered segments, inner nodes
+ * have count 0 and two children
+ */
+struct bvhNode {
+    Eigen::Vector3f min, max;
+    uint32_t left, right, begin, count;
+};
+
+/**
+ * This class indexes the regions of a segmentation for spatial queries: which
+ * regions have voxels in a box or within a radius of a point, and which region
+ * is the nearest to a point.
+ * 
+ * The bounding boxes of the regions are organized in a bounding volume 
+ * hierarchy, so that queries only visit the regions near the queried volume,
+ * and each region keeps a kd-tree of its voxels for the exact tests.
+ * 
+ * Regions are never modified by the clustering, merges create new ones: when
+ * the index is updated, regions already indexed are recognized and keep their
+ * bounding box and kd-tree, so only the regions created by merges since the
+ * last update are processed again before the hierarchy is rebuilt.
+ */
+class SegmentIndex {
+    std::map<uint32_t, indexedSegment> indexed;
+    std::vector<indexedSegment> ordered;
+    std::vector<bvhNode> nodes;
+    size_t reused, rebuilt;
+
+    uint32_t build(size_t begin, size_t end);
+    static float box_distance(const Eigen::Vector3f &min,
+            const Eigen::Vector3f &max, const Eigen::Vector3f &p);
+    static bool in_box(const indexedSegment &s, const Eigen::Vector3f &min,
+            const Eigen::Vector3f &max);
+
+public:
+
+    SegmentIndex();
+
+    void update(const ClusteringT &segments);
+    void clear();
+
+    /**
+     * Get the number of indexed regions
+     * 
+     * @return the number of regions
+     */
+    size_t size() const {
+        return ordered.size();
+    }
+
+    /**
+     * Get the number of regions kept and processed again by the last update
+     * 
+     * @return a pair with the regions kept and the regions processed again
+     */
+    std::pair<size_t, size_t> get_update_stats() const {
+        return std::pair<size_t, size_t>(reused, rebuilt);
+    }
+
+    void box_query(const Eigen::Vector3f &min, const Eigen::Vector3f &max,
+            std::vector<uint32_t> &labels) const;
+    void radius_query(const Eigen::Vector3f &center, float radius,
+            std::vector<uint32_t> &labels) const;
+    bool nearest_query(const Eigen::Vector3f &point, uint32_t &label,
+            float &distance) const;
+};
+
+#endif /* SEGMENT_INDEX_H_ */
@@ -0,0 +1,124 @@
+/*
+ * segment_moments.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef SEGMENT_MOMENTS_H_
+#define SEGMENT_MOMENTS_H_
+
+#include <stdint.h>
+
+#include <limits>
+
+#include <Eigen/Core>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "cloud_types.h"
+
+/**
+ * Summed moments of the voxels of a region: the moments of the union of two
+ * regions are the sums of their moments, so they can be kept up to date 
+ * through the merges at constant cost
+ */
+struct segmentMoments {
+
+    segmentMoments() :
+    count(0) {
+        for (int i = 0; i < 3; ++i) {
+            sum[i] = 0;
+            min[i] = std::numeric_limits<float>::max();
+            max[i] = -std::numeric_limits<float>::max();
+        }
+        for (int i = 0; i < 6; ++i)
+            sum_sq[i] = 0;
+        for (int i = 0; i < 4; ++i)
+            sum_rgba[i] = 0;
+    }
+    uint64_t count;
+    // Sums of x, y, z and of xx, xy, xz, yy, yz, zz
+    double sum[3], sum_sq[6];
+    double sum_rgba[4];
+    float min[3], max[3];
+};
+
+/**
+ * Geometric and color descriptors of a region
+ * 
+ * The oriented box is aligned with the principal axes of the voxels and has 
+ * the size of the box of uniform density having their same variances, as the
+ * exact extents along the principal axes can't be derived from the moments.
+ */
+struct segmentDescriptor {
+    uint32_t label;
+    size_t voxels;
+    Eigen::Vector3f centroid, min, max;
+    // Principal axes as columns, by decreasing variance
+    Eigen::Matrix3f axes;
+    Eigen::Vector3f variances, obb_half_sizes;
+    float mean_rgb[3], mean_lab[3];
+    Eigen::Vector3f normal;
+    float curvature;
+};
+
+/**
+ * Utility class computing and combining the moments of regions, and deriving
+ * descriptors from them without visiting the voxels again
+ */
+class SegmentMoments {
+
+    SegmentMoments() {
+    }
+
+public:
+
+    static segmentMoments compute(const pcl::PointCloud<PointT> &voxels);
+    static segmentMoments combine(const segmentMoments &a,
+            const segmentMoments &b);
+
+    static Eigen::Vector3f mean(const segmentMoments &m);
+    static Eigen::Matrix3f covariance(const segmentMoments &m);
+    static void centroid(const segmentMoments &m, PointT &centroid);
+    static bool normal(const segmentMoments &m, Eigen::Vector4f &normal,
+            float &curvature);
+    static segmentDescriptor describe(uint32_t label,
+            const segmentMoments &m);
+};
+
+#endif /* SEGMENT_MOMENTS_H_ */
@@ -0,0 +1,142 @@
+/*
+ * segmentation_server.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SEGMENTATION_SERVER_H_
+#define SEGMENTATION_SERVER_H_
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "segmenter.h"
+#include "socket_stream.h"
+#include "thread_pool.h"
+
+struct serverStats {
+
+    serverStats() :
+    connections(0), jobs(0), failed_jobs(0) {
+    }
+    size_t connections, jobs, failed_jobs;
+};
+
+/**
+ * Point of an inline cloud sent to the server
+ */
+struct wirePoint {
+    float x, y, z;
+    uint32_t rgba, label;
+};
+
+/**
+ * Labelled voxel returned by the server
+ */
+struct wireLabel {
+    float x, y, z;
+    uint32_t label;
+};
+
+/**
+ * This class serves segmentation jobs over a Unix-domain socket, so that a
+ * long-running process can answer many requests without paying the start-up
+ * and initialization cost each time. 
+ * 
+ * Each connection is handled by a worker of a thread pool, so that many 
+ * clients can be served at the same time, while the stages of each job run 
+ * in parallel on a second pool shared by all connections. Segmenters are cached by their 
+ * parameters and handed to the following jobs, keeping their buffers warm; 
+ * only the most recently used ones are kept, up to a few for each worker.
+ * A connection keeps the same segmenter for as long as its parameters don't 
+ * change, so --TW and --BG work on the sequence of frames sent over it.
+ * 
+ * The protocol is made of text request lines, each followed by an optional
+ * binary payload:
+ * 
+ *   SEGMENT_FILE <pcd-file> [arguments]
+ *   SEGMENT <points> [arguments]        followed by <points> wirePoint
+ *   STATS
+ *   QUIT
+ * 
+ * where the arguments are the ones of the command line. A segmentation job
+ * is answered by
+ * 
+ *   OK <voxels> <segments> <threshold> <precision> <recall> <fscore> <voi> 
+ *      <wov> <milliseconds>             followed by <voxels> wireLabel
+ * 
+ * while any failure is answered by "ERROR <message>". Binary data is sent in
+ * the byte order of the host. A SEGMENT request whose payload can't be 
+ * received is answered with an error and the connection is closed.
+ */
+class SegmentationServer {
+    std::string path;
+    int server;
+    ThreadPool pool;
+    ThreadPool stage_pool;
+    boost::mutex mutex;
+    // Idle segmenters, the most recently used first
+    std::list<std::pair<std::string, boost::shared_ptr<Segmenter> > >
+    idle_segmenters;
+    size_t max_idle;
+    serverStats stats;
+
+    void serve(int client);
+    bool run_job(SocketStream &stream, const std::string &request,
+            std::string &key, boost::shared_ptr<Segmenter> &segmenter);
+    boost::shared_ptr<Segmenter> acquire(const std::string &key,
+            const segmenterParameters &params);
+    void release(const std::string &key,
+            boost::shared_ptr<Segmenter> segmenter);
+
+public:
+
+    SegmentationServer(std::string socket_path, size_t workers = 0,
+            size_t stage_workers = 0);
+    ~SegmentationServer();
+
+    void run();
+    void stop();
+    serverStats get_stats();
+
+    static std::vector<std::string> tokenize(const std::string &line);
+};
+
+#endif /* SEGMENTATION_SERVER_H_ */
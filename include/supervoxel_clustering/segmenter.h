@@ -0,0 +1,246 @@
+/*
+ * segmenter.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SEGMENTER_H_
+#define SEGMENTER_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/segmentation/supervoxel_clustering.h>
+
+#include "background_model.h"
+#include "cloud_types.h"
+#include "clustering.h"
+#include "plane_extractor.h"
+#include "region_of_interest.h"
+#include "shm_ring_buffer.h"
+#include "task_graph.h"
+#include "temporal_cache.h"
+#include "testing.h"
+#include "thread_pool.h"
+
+struct segmenterParameters {
+
+    segmenterParameters() :
+    voxel_resolution(0.008f), seed_resolution(0.08f), color_importance(0.2f),
+    spatial_importance(0.4f), normal_importance(1.0f),
+    disable_transform(false), delta_c(LAB_CIEDE00), delta_g(NORMALS_DIFF),
+    merging(ADAPTIVE_LAMBDA), lambda(0), bins_num(0), thresh_specified(false),
+    thresh(0), start_thresh(0.8), end_thresh(1), step_thresh(0.005),
+    remove_label(false), label_to_be_removed(0), temporal(false),
+    background(false), background_tolerance(0.05), hierarchy(false),
+    roi_specified(false), planes_num(0) {
+    }
+    // Supervoxel parameters
+    float voxel_resolution, seed_resolution, color_importance,
+    spatial_importance, normal_importance;
+    bool disable_transform;
+    // Segmentation parameters
+    ColorDistance delta_c;
+    GeometricDistance delta_g;
+    MergingCriterion merging;
+    float lambda;
+    int bins_num;
+    bool thresh_specified;
+    float thresh, start_thresh, end_thresh, step_thresh;
+    // Other parameters
+    bool remove_label;
+    uint32_t label_to_be_removed;
+    bool temporal, background;
+    float background_tolerance;
+    bool hierarchy;
+    bool roi_specified;
+    RegionOfInterest roi;
+    int planes_num;
+};
+
+struct frameResult {
+
+    frameResult() :
+    threshold(0) {
+    }
+    ClusteringT supervoxels;
+    AdjacencyMapT adjacency;
+    PointCloudT::Ptr voxel_centroid_cloud, colored_voxel_cloud,
+    colored_truth_cloud;
+    PointLCloudT::Ptr labeled_voxel_cloud;
+    PointNCloudT::Ptr refined_normal_cloud;
+    std::map<float, performanceSet> all_performances;
+    performanceSet performance;
+    float threshold;
+    temporalStats temporal;
+    backgroundStats background;
+    std::vector<std::pair<std::string, size_t> > allocations;
+    std::vector<std::pair<std::string, double> > timings;
+    ClusteringState hierarchy_state;
+    std::vector<WeightedPairT> hierarchy_merges;
+    std::vector<int> point_indices;
+};
+
+/**
+ * State of a frame shared by the stages of its processing, kept by the 
+ * segmenter across frames
+ */
+struct frameJob {
+    frameResult *result;
+    AdjacencyMapT adjacency;
+    PointLCloudT::Ptr voxel_truth_cloud;
+    std::vector<planeSegment> planes;
+    size_t allocations;
+    boost::mutex mutex;
+};
+
+/**
+ * This class runs the complete processing of a single pointcloud: supervoxel 
+ * extraction, voxelization of the groundtruth, clustering and evaluation. 
+ * 
+ * A segmenter can be used to process a sequence of frames; if the temporal 
+ * mode is enabled, each frame is seeded from the supervoxels of the previous 
+ * one and the distances of the regions that did not change are reused. If the
+ * background mode is enabled, the first frame is cached as background and only
+ * the parts of the following frames that differ from it are segmented again.
+ */
+class Segmenter {
+    segmenterParameters params;
+    TemporalCache temporal_cache;
+    BackgroundModel background;
+    size_t (*allocation_counter)();
+    ThreadPool *pool;
+
+    // Workspace: the buffers, the clustering, its evaluation and the task 
+    // graph of the stages are kept across frames and cleared instead of being
+    // built again, so that processing frames of similar size reuses their 
+    // memory. The supervoxel extraction and the node-based maps of regions 
+    // and edges still allocate for each frame.
+    PointCloudT::Ptr cloud;
+    NormalCloudT::Ptr normal_cloud;
+    PointLCloudT::Ptr truth_cloud;
+    PointLCloudT::Ptr supervoxel_labels;
+    PointCloudT::Ptr plane_colors;
+    Clustering segmentation;
+    Testing test;
+    frameJob job;
+    boost::shared_ptr<TaskGraph> graph;
+
+    template <typename PointInT>
+    void preprocess(pcl::PointCloud<PointInT> &input,
+            NormalCloudT::ConstPtr input_normals, PointCloudT::Ptr cloud,
+            NormalCloudT::Ptr normals, PointLCloudT::Ptr truth,
+            std::vector<int> &indices) const;
+    void preprocess(const shmPoint *points, size_t size,
+            PointCloudT::Ptr cloud, PointLCloudT::Ptr truth,
+            std::vector<int> &indices) const;
+    void init_supervoxels(pcl::SupervoxelClustering<PointT> &super,
+            PointCloudT::Ptr cloud, NormalCloudT::ConstPtr normals) const;
+    void extract_supervoxels(PointCloudT::Ptr cloud,
+            NormalCloudT::ConstPtr normals, frameResult &result,
+            AdjacencyMapT &adjacency, PointLCloudT::Ptr labels);
+    void extract_changed_supervoxels(PointCloudT::Ptr cloud,
+            frameResult &result, AdjacencyMapT &adjacency);
+    void voxelize_truth(PointLCloudT::Ptr truth,
+            const std::vector<planeSegment> &planes,
+            PointLCloudT &voxel_truth, PointCloudT::Ptr colored_truth) const;
+    void init_clustering(Clustering &segmentation) const;
+    void build_graph();
+    void segment(frameResult &result, size_t &allocations);
+    void planes_stage(frameJob *job);
+    void extract_stage(frameJob *job);
+    void truth_stage(frameJob *job);
+    void clustering_stage(frameJob *job);
+    void coloring_stage(frameJob *job);
+    void hierarchy_stage(frameJob *job);
+    void testing_stage(frameJob *job);
+    void count_allocations(frameJob *job, std::string stage) const;
+    void count_allocations(frameResult &result, std::string stage,
+            size_t &allocations) const;
+
+public:
+
+    Segmenter(segmenterParameters p);
+
+    /**
+     * Get the parameters used by the segmenter
+     * 
+     * @return the segmenter parameters
+     */
+    segmenterParameters get_parameters() const {
+        return params;
+    }
+
+    /**
+     * Set a function counting the heap allocations performed so far. If set,
+     * the allocations of each processing stage are reported in the results.
+     * 
+     * @param counter   the counting function, or NULL to disable counting
+     */
+    void set_allocation_counter(size_t (*counter)()) {
+        allocation_counter = counter;
+    }
+
+    /**
+     * Set the thread pool on which the independent stages of each frame run
+     * in parallel
+     * 
+     * @param thread_pool   the thread pool, or NULL to run all stages in the
+     *                      calling thread
+     */
+    void set_thread_pool(ThreadPool *thread_pool) {
+        pool = thread_pool;
+        graph.reset();
+    }
+
+    frameResult process(PointLCCloudT::Ptr input,
+            NormalCloudT::ConstPtr normals = NormalCloudT::ConstPtr());
+    template <typename PointInT>
+    void process(pcl::PointCloud<PointInT> &input,
+            NormalCloudT::ConstPtr normals, frameResult &result);
+    frameResult process(const shmPoint *points, size_t size);
+    void process(const shmPoint *points, size_t size, frameResult &result);
+    void reset();
+    template <typename PointInT>
+    void point_labels(const pcl::PointCloud<PointInT> &input,
+            const frameResult &result, std::vector<uint32_t> &labels) const;
+
+    static bool parse_arguments(int argc, char **argv,
+            segmenterParameters &params);
+    static bool load(std::string filename, PointLCCloudT::Ptr input,
+            NormalCloudT::Ptr normals = NormalCloudT::Ptr());
+};
+
+#endif /* SEGMENTER_H_ */
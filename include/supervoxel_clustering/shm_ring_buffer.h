@@ -0,0 +1,155 @@
+/*
+ * shm_ring_buffer.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SHM_RING_BUFFER_H_
+#define SHM_RING_BUFFER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#define SHM_MAGIC 0x53564342
+#define SHM_VERSION 1
+#define SHM_DEFAULT_SLOTS 4
+#define SHM_DEFAULT_CAPACITY 1000000
+
+/**
+ * Point of a frame in shared memory
+ */
+struct shmPoint {
+    float x, y, z;
+    uint32_t rgba;
+};
+
+/**
+ * Header of a frame slot
+ */
+struct shmFrame {
+    uint64_t sequence;
+    uint32_t points, width, height, padding;
+};
+
+/**
+ * Header of the shared memory segment; head and tail lie on separate cache 
+ * lines, so that the producer and the consumer don't contend for them. The
+ * magic number is stored last by the creator, with release semantics, and
+ * loaded first by the opener, with acquire semantics, so that the rest of the
+ * header is seen initialized once the magic number is.
+ */
+struct shmHeader {
+    std::atomic<uint32_t> magic;
+    uint32_t version, slots, slot_capacity;
+    std::atomic<uint32_t> closed;
+    char padding_head[64 - 5 * sizeof (uint32_t)];
+    std::atomic<uint64_t> head;
+    char padding_tail[64 - sizeof (uint64_t)];
+    std::atomic<uint64_t> tail;
+    char padding_end[64 - sizeof (uint64_t)];
+};
+
+/**
+ * This class implements a single-producer single-consumer ring buffer of 
+ * pointcloud frames in POSIX shared memory, so that a process on the same host
+ * can hand frames to the segmenter without serializing them.
+ * 
+ * The segment starts with a shmHeader, followed by a number of slots, each 
+ * made of a shmFrame and room for slot_capacity shmPoint. The protocol is
+ * lock-free and relies only on the two counters head and tail, which count 
+ * the frames written and released since the creation of the buffer:
+ * 
+ * - the producer owns slot (head % slots) while head - tail < slots; it writes
+ *   the points and the frame header in place, then publishes the frame by
+ *   storing head + 1 with release semantics;
+ * - the consumer owns slot (tail % slots) while tail < head, loaded with 
+ *   acquire semantics; it reads the points in place, then gives the slot back
+ *   by storing tail + 1 with release semantics;
+ * - the producer sets closed once it won't write any more frames.
+ * 
+ * A producer finding the buffer full should drop its frame rather than wait, 
+ * as a camera driver would.
+ */
+class ShmRingBuffer {
+    std::string name;
+    bool owner;
+    void *memory;
+    size_t size;
+    shmHeader *header;
+
+    ShmRingBuffer(const ShmRingBuffer &);
+    ShmRingBuffer & operator=(const ShmRingBuffer &);
+
+    shmFrame * slot(uint64_t index) const;
+
+public:
+
+    ShmRingBuffer(std::string shm_name, uint32_t slots,
+            uint32_t slot_capacity);
+    ShmRingBuffer(std::string shm_name);
+    ~ShmRingBuffer();
+
+    /**
+     * Get the maximum number of points of a frame
+     * 
+     * @return the capacity of a slot
+     */
+    uint32_t get_slot_capacity() const {
+        return header->slot_capacity;
+    }
+
+    /**
+     * Check whether the producer closed the buffer
+     * 
+     * @return true if no more frames will be written
+     */
+    bool is_closed() const {
+        return header->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    // Producer side
+    shmPoint * begin_write();
+    void commit_write(uint32_t points, uint32_t width, uint32_t height);
+    void close();
+
+    // Consumer side
+    const shmPoint * begin_read(shmFrame &frame);
+    void end_read();
+};
+
+#endif /* SHM_RING_BUFFER_H_ */
@@ -0,0 +1,82 @@
+/*
+ * socket_stream.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef SOCKET_STREAM_H_
+#define SOCKET_STREAM_H_
+
+#include <string>
+
+/**
+ * A connected Unix-domain stream socket, with buffered reading of text lines
+ * and blocking reading and writing of binary payloads. The socket is closed
+ * when the stream is destroyed.
+ */
+class SocketStream {
+    int fd;
+    std::string buffer;
+
+    SocketStream(const SocketStream &);
+    SocketStream & operator=(const SocketStream &);
+
+public:
+
+    SocketStream(int socket);
+    ~SocketStream();
+
+    /**
+     * Check whether the stream is connected to a socket
+     * 
+     * @return true if the stream has a valid socket
+     */
+    bool is_open() const {
+        return fd >= 0;
+    }
+
+    void close();
+    bool read_line(std::string &line);
+    bool read(void *data, size_t size);
+    bool write(const void *data, size_t size);
+    bool write_line(const std::string &line);
+
+    static int listen(const std::string &path, int backlog = 16);
+    static int accept(int server);
+    static int connect(const std::string &path);
+};
+
+#endif /* SOCKET_STREAM_H_ */
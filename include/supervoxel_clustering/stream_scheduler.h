@@ -0,0 +1,124 @@
+/*
+ * stream_scheduler.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef STREAM_SCHEDULER_H_
+#define STREAM_SCHEDULER_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "segmenter.h"
+#include "thread_pool.h"
+
+typedef boost::chrono::steady_clock ClockT;
+typedef boost::function<void(const std::string &, const frameResult &) >
+ResultCallbackT;
+
+struct streamStats {
+
+    streamStats() :
+    submitted(0), processed(0), replaced(0), expired(0), failed(0),
+    deadline_misses(0), total_latency(0), max_latency(0) {
+    }
+    size_t submitted, processed, replaced, expired, failed, deadline_misses;
+    double total_latency, max_latency;
+};
+
+/**
+ * This class segments the frames of several named streams (e.g. the cameras
+ * of a cell) on a single pool of workers. 
+ * 
+ * Each stream only keeps its latest frame: a frame submitted while the 
+ * previous one is still waiting replaces it. Workers pick the streams with a 
+ * waiting frame in round-robin order, and a stream is never processed by two
+ * workers at the same time, so that its segmenter sees its frames in order. 
+ * Frames older than the deadline of their stream when a worker picks them are
+ * dropped, while frames completed after it are counted as deadline misses.
+ */
+class StreamScheduler {
+
+    struct streamState {
+
+        streamState() :
+        deadline(0), busy(false) {
+        }
+        boost::shared_ptr<Segmenter> segmenter;
+        double deadline;
+        PointLCCloudT::Ptr pending;
+        ClockT::time_point pending_time;
+        bool busy;
+        streamStats stats;
+    };
+
+    segmenterParameters params;
+    std::map<std::string, streamState> streams;
+    std::vector<std::string> order;
+    size_t next_stream, processing;
+    bool stopping;
+    ResultCallbackT callback;
+    boost::mutex mutex;
+    boost::condition_variable frame_available, frame_done;
+    ThreadPool pool;
+
+    void work();
+    bool next_job(std::string &name, PointLCCloudT::Ptr &frame,
+            ClockT::time_point &time, bool &expired);
+
+public:
+
+    StreamScheduler(segmenterParameters p, size_t workers = 0);
+    ~StreamScheduler();
+
+    void add_stream(std::string name, double deadline = 0);
+    void set_callback(ResultCallbackT result_callback);
+    void submit(std::string name, PointLCCloudT::Ptr frame);
+    void wait();
+    void stop();
+
+    std::vector<std::string> get_streams();
+    streamStats get_stats(std::string name);
+};
+
+#endif /* STREAM_SCHEDULER_H_ */
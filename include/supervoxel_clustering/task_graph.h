@@ -0,0 +1,100 @@
+/*
+ * task_graph.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef TASK_GRAPH_H_
+#define TASK_GRAPH_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "thread_pool.h"
+
+/**
+ * This class runs a set of tasks with dependencies between them, starting 
+ * each task as soon as all the tasks it depends on are completed. Ready tasks
+ * are offered to a thread pool, while the calling thread executes them as 
+ * well; this way the graph always makes progress, even when run from a worker
+ * of the same pool or without a pool at all.
+ */
+class TaskGraph {
+
+    struct taskNode {
+        std::string name;
+        TaskT task;
+        std::vector<size_t> successors;
+        size_t dependencies, waiting;
+        bool skipped;
+        double time;
+    };
+
+    // State shared with the tasks offered to the pool, which may be picked
+    // by a worker after the graph is gone
+    struct graphState {
+        std::vector<taskNode> nodes;
+        ThreadPool *pool;
+        std::deque<size_t> ready;
+        size_t remaining;
+        std::string error;
+        boost::mutex mutex;
+        boost::condition_variable changed;
+    };
+
+    boost::shared_ptr<graphState> state;
+
+    static void run_ready(boost::shared_ptr<graphState> state);
+    static void execute(boost::shared_ptr<graphState> state, size_t index);
+    static void skip(graphState &state, size_t index);
+
+public:
+
+    TaskGraph(ThreadPool *thread_pool = NULL);
+
+    size_t add_task(std::string name, TaskT task,
+            std::vector<size_t> dependencies = std::vector<size_t>());
+    void run();
+    std::vector<std::pair<std::string, double> > get_timings() const;
+    void get_timings(
+            std::vector<std::pair<std::string, double> > &timings) const;
+};
+
+#endif /* TASK_GRAPH_H_ */
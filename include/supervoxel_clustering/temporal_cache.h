@@ -0,0 +1,167 @@
+/*
+ * temporal_cache.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef TEMPORALCACHE_H_
+#define TEMPORALCACHE_H_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/segmentation/supervoxel_clustering.h>
+
+#include "cloud_types.h"
+#include "color_utilities.h"
+
+typedef std::pair<uint32_t, uint32_t> EdgeT;
+typedef std::pair<float, float> DeltasT;
+
+struct temporalStats {
+
+    temporalStats() :
+    supervoxels(0), matched_supervoxels(0), edges(0), reused_edges(0) {
+    }
+    size_t supervoxels, matched_supervoxels, edges, reused_edges;
+};
+
+/**
+ * Supervoxel extraction seeded from the supervoxel centroids of a previous 
+ * frame. Every previous centroid lying on the new voxel cloud becomes a seed,
+ * while the standard seeding of PCL is only kept for the parts of the scene 
+ * that are not covered by any previous centroid (e.g. newly appeared objects).
+ * If no previous centroids are set, the behavior is the same as the one of 
+ * pcl::SupervoxelClustering.
+ */
+class SeededSupervoxelClustering : public pcl::SupervoxelClustering<PointT> {
+    PointCloudT::Ptr previous_centroids;
+
+    void select_seeds(std::vector<int> &seed_indices);
+
+public:
+
+    SeededSupervoxelClustering(float voxel_resolution, float seed_resolution);
+
+    /**
+     * Set the centroids from which the supervoxels should be seeded
+     * 
+     * @param c the supervoxel centroids of the previous frame
+     */
+    void set_previous_centroids(PointCloudT::Ptr c) {
+        previous_centroids = c;
+    }
+
+    void extract(ClusteringT &supervoxel_clusters);
+};
+
+/**
+ * Cache keeping the supervoxel statistics and the color and geometric 
+ * distances computed for the previous frame of a sequence. Supervoxels of the 
+ * current frame are matched to the previous ones; for edges connecting two 
+ * matched supervoxels, the distances computed in the previous frame can be 
+ * reused instead of being computed again.
+ * 
+ * Each matched supervoxel keeps the statistics of the frame in which its 
+ * distances were last computed, so that slow drifts accumulating over many 
+ * frames still invalidate the cached values.
+ */
+class TemporalCache {
+
+    struct supervoxelSignature {
+        PointT centroid;
+        Normal normal;
+        float rgb[3];
+        size_t size;
+    };
+
+    typedef std::map<uint32_t, supervoxelSignature> SignatureMapT;
+    typedef std::map<EdgeT, DeltasT> DeltasMapT;
+
+    float max_distance, max_color_diff, min_normal_cos, max_size_ratio;
+    PointCloudT::Ptr previous_centroids;
+    SignatureMapT previous_signatures, current_signatures;
+    DeltasMapT previous_deltas, current_deltas;
+    std::map<uint32_t, uint32_t> matches;
+    temporalStats stats;
+
+    supervoxelSignature signature(SupervoxelT::Ptr s) const;
+    bool similar(const supervoxelSignature &s1,
+            const supervoxelSignature &s2) const;
+    static EdgeT edge(uint32_t l1, uint32_t l2);
+
+public:
+
+    TemporalCache();
+
+    void set_tolerances(float distance, float color, float normal_angle,
+            float size_ratio);
+
+    /**
+     * Check if a previous frame is available in the cache
+     * 
+     * @return true if the statistics of a previous frame are stored
+     */
+    bool has_previous() const {
+        return !previous_signatures.empty();
+    }
+
+    /**
+     * Get the supervoxel centroids of the previous frame
+     * 
+     * @return a pointcloud containing one centroid per supervoxel, empty if
+     *         no previous frame is available
+     */
+    PointCloudT::Ptr get_previous_centroids() const {
+        return previous_centroids;
+    }
+
+    /**
+     * Get the reuse statistics of the current frame
+     * 
+     * @return the number of matched supervoxels and reused edges
+     */
+    temporalStats get_stats() const {
+        return stats;
+    }
+
+    void begin_frame(const ClusteringT &supervoxels);
+    bool lookup(uint32_t l1, uint32_t l2, DeltasT &deltas);
+    void store(uint32_t l1, uint32_t l2, DeltasT deltas);
+    void end_frame();
+    void clear();
+};
+
+#endif /* TEMPORALCACHE_H_ */
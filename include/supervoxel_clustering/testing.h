@@ -48,8 +48,8 @@
 #include <pcl/console/print.h>
 #include <boost/make_shared.hpp>
 
-typedef pcl::PointXYZL PointLT;
-typedef pcl::PointCloud<PointLT> PointLCloudT;
+#include "cloud_types.h"
+
 typedef std::vector<PointLT, Eigen::aligned_allocator<PointLT> > PointLVectorT;
 typedef std::map<uint32_t, PointLCloudT::Ptr> labelMapT;
 
@@ -79,25 +79,38 @@ struct performanceSet {
 class Testing {
     PointLCloudT::Ptr segm, truth;
     labelMapT segm_labels, truth_labels;
+    std::vector<uint32_t> label_buffer;
+    std::vector<PointLCloudT *> segment_buffer;
+    std::vector<std::pair<size_t, uint32_t> > size_buffer;
     Eigen::Matrix<size_t, Eigen::Dynamic, Eigen::Dynamic> inter_matrix;
+    Eigen::Matrix<size_t, Eigen::Dynamic, 1> column_buffer;
     Eigen::Array<int64_t, 1, Eigen::Dynamic> matches;
     float precision, recall, fscore, voi, wov, fpr, fnr;
     bool is_set_segm, is_set_truth;
 
     void init_performance();
-    labelMapT label_map(PointLCloudT::Ptr in);
+    void label_map(PointLCloudT::Ptr in, labelMapT &map);
     void compute_intersections();
-    PointLCloudT::Ptr extract_label_cloud(PointLCloudT::Ptr c,
-            uint32_t label) const;
     size_t count_intersect(PointLCloudT::Ptr c1, PointLCloudT::Ptr c2) const;
     size_t count_union(PointLCloudT::Ptr c1, PointLCloudT::Ptr c2) const;
 
-    Testing() {
+    static bool larger_size(const std::pair<size_t, uint32_t> &s1,
+            const std::pair<size_t, uint32_t> &s2);
+    static bool same_size(const std::pair<size_t, uint32_t> &s1,
+            const std::pair<size_t, uint32_t> &s2);
+
+public:
+
+    /**
+     * Build an empty testing suite, whose pointclouds are to be set with 
+     * 'set_clouds'; a suite can be reused for many pointclouds, keeping the
+     * memory of its segments
+     */
+    Testing() :
+    is_set_segm(false), is_set_truth(false) {
         init_performance();
     }
 
-public:
-    
     Testing(PointLCloudT::Ptr s, PointLCloudT::Ptr t);
 
     float eval_precision();
@@ -129,6 +142,7 @@ public:
 
     void set_segm(PointLCloudT::Ptr s);
     void set_truth(PointLCloudT::Ptr t);
+    void set_clouds(PointLCloudT::Ptr s, PointLCloudT::Ptr t);
 };
 
 #endif /* TESTING_H_ */
@@ -0,0 +1,123 @@
+/*
+ * thread_pool.h
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <deque>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+typedef boost::function<void()> TaskT;
+
+struct poolStats {
+
+    poolStats() :
+    tasks(0), stolen_tasks(0), busy_time(0), elapsed_time(0),
+    utilization(0) {
+    }
+    size_t tasks, stolen_tasks;
+    double busy_time, elapsed_time, utilization;
+};
+
+/**
+ * A fixed set of worker threads executing the submitted tasks. The workers are
+ * started once and kept alive until the pool is destroyed, so that the cost 
+ * of creating threads is not paid for each task.
+ * 
+ * Each worker has its own queue of tasks. Tasks submitted by a worker (e.g. 
+ * the sub-tasks of a running task) go to the back of its own queue, which it
+ * serves last-in first-out, while tasks submitted from outside the pool are 
+ * spread over the queues. A worker with an empty queue steals from the front
+ * of the others, so that the load stays balanced even when the cost of the 
+ * tasks is very uneven.
+ */
+class ThreadPool {
+
+    struct workerQueue {
+
+        workerQueue() :
+        tasks(0), stolen_tasks(0), busy_time(0) {
+        }
+        boost::mutex mutex;
+        std::deque<TaskT> queue;
+        size_t tasks, stolen_tasks;
+        double busy_time;
+    };
+
+    std::vector<boost::shared_ptr<workerQueue> > queues;
+    boost::thread_group workers;
+    boost::mutex mutex;
+    boost::condition_variable task_available, queue_empty;
+    size_t queued, pending, next_queue;
+    bool stopping;
+    boost::chrono::steady_clock::time_point start_time;
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool & operator=(const ThreadPool &);
+
+    void work(size_t index);
+    bool take(size_t index, TaskT &task);
+
+public:
+
+    ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    /**
+     * Get the number of worker threads of the pool
+     * 
+     * @return the number of workers
+     */
+    size_t size() const {
+        return queues.size();
+    }
+
+    void submit(TaskT task);
+    void wait();
+
+    poolStats get_stats();
+    void reset_stats();
+};
+
+#endif /* THREAD_POOL_H_ */
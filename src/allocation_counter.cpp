@@ -0,0 +1,179 @@
+/*
+ * allocation_counter.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include "supervoxel_clustering/allocation_counter.h"
+
+namespace {
+// The flag is only read by the allocation functions, while the counter is
+// written by all threads once counting is enabled, so they are kept in
+// separate cache lines
+alignas(64) std::atomic<bool> counting(false);
+alignas(64) std::atomic<size_t> allocations(0);
+
+inline void count_allocation() {
+    if (counting.load(std::memory_order_relaxed))
+        allocations.fetch_add(1, std::memory_order_relaxed);
+}
+}
+
+#ifdef __GLIBC__
+
+/*
+ * With glibc the C allocation functions are replaced, so that the memory 
+ * allocated by operator new as well as the one allocated directly through
+ * malloc (e.g. by Eigen::aligned_allocator, used by all PCL pointclouds) is
+ * counted.
+ */
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t n, size_t size);
+void * __libc_realloc(void * p, size_t size);
+void * __libc_memalign(size_t alignment, size_t size);
+
+void * malloc(size_t size) throw () {
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void * calloc(size_t n, size_t size) throw () {
+    count_allocation();
+    return __libc_calloc(n, size);
+}
+
+void * realloc(void * p, size_t size) throw () {
+    count_allocation();
+    return __libc_realloc(p, size);
+}
+
+void * memalign(size_t alignment, size_t size) throw () {
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+void * aligned_alloc(size_t alignment, size_t size) throw () {
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void ** p, size_t alignment, size_t size) throw () {
+    // As in glibc, the alignment must be a power of two multiple of the size
+    // of a pointer, and the result is left untouched on failure
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0
+            || alignment % sizeof(void *) != 0)
+        return EINVAL;
+    count_allocation();
+    void * memory = __libc_memalign(alignment, size);
+    if (!memory)
+        return ENOMEM;
+    *p = memory;
+    return 0;
+}
+}
+
+#else
+
+namespace {
+
+void * counted_malloc(std::size_t size) {
+    count_allocation();
+    return std::malloc((size == 0) ? 1 : size);
+}
+}
+
+void * operator new(std::size_t size) {
+    void * p = counted_malloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void * operator new[](std::size_t size) {
+    void * p = counted_malloc(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) throw () {
+    return counted_malloc(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) throw () {
+    return counted_malloc(size);
+}
+
+void operator delete(void * p) throw () {
+    std::free(p);
+}
+
+void operator delete[](void * p) throw () {
+    std::free(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) throw () {
+    std::free(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) throw () {
+    std::free(p);
+}
+
+#endif
+
+/**
+ * Start counting the heap allocations; until this is called, the allocation 
+ * functions only check a flag
+ */
+void AllocationCounter::enable() {
+    counting.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Get the number of heap allocations performed so far
+ * 
+ * @return the number of allocations since counting was enabled
+ */
+size_t AllocationCounter::count() {
+    return allocations.load(std::memory_order_relaxed);
+}
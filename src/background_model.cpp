@@ -0,0 +1,344 @@
+/*
+ * background_model.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "supervoxel_clustering/background_model.h"
+
+namespace {
+const int KEY_BITS = 21;
+const int64_t KEY_OFFSET = 1 << (KEY_BITS - 1);
+const uint64_t KEY_MASK = (1 << KEY_BITS) - 1;
+}
+
+/**
+ * Compute the key of the voxel containing a point; if the single camera 
+ * transform is used, the point is transformed as PCL does before voxelizing 
+ * it for the supervoxels, so that the voxels grow with the depth as theirs
+ * 
+ * @param p a point
+ * 
+ * @return the key of the voxel
+ */
+uint64_t BackgroundModel::key(const PointT &p) const {
+    float px = p.x, py = p.y, pz = p.z;
+    if (camera_transform && pz > 0) {
+        px /= pz;
+        py /= pz;
+        pz = std::log(pz);
+    }
+    int64_t x = static_cast<int64_t> (std::floor(px / resolution));
+    int64_t y = static_cast<int64_t> (std::floor(py / resolution));
+    int64_t z = static_cast<int64_t> (std::floor(pz / resolution));
+    return ((static_cast<uint64_t> (x + KEY_OFFSET) & KEY_MASK)
+            << (2 * KEY_BITS))
+            | ((static_cast<uint64_t> (y + KEY_OFFSET) & KEY_MASK) << KEY_BITS)
+            | (static_cast<uint64_t> (z + KEY_OFFSET) & KEY_MASK);
+}
+
+/**
+ * Compute the key of a voxel adjacent to the given one
+ * 
+ * @param k     the key of a voxel
+ * @param dx    the offset along x, in voxels
+ * @param dy    the offset along y, in voxels
+ * @param dz    the offset along z, in voxels
+ * 
+ * @return the key of the adjacent voxel
+ */
+uint64_t BackgroundModel::neighbor_key(uint64_t k, int dx, int dy, int dz) {
+    uint64_t x = ((k >> (2 * KEY_BITS)) + dx) & KEY_MASK;
+    uint64_t y = ((k >> KEY_BITS) + dy) & KEY_MASK;
+    uint64_t z = (k + dz) & KEY_MASK;
+    return (x << (2 * KEY_BITS)) | (y << KEY_BITS) | z;
+}
+
+/**
+ * Constructor for the BackgroundModel class
+ * 
+ * @param res       the size of the voxels of the model
+ * @param tolerance the maximum RGB distance, normalized in [0, 1], for a voxel
+ *                  to be considered unchanged
+ * @param transform whether the supervoxels use the single camera transform
+ */
+BackgroundModel::BackgroundModel(float res, float tolerance, bool transform) {
+    if (res <= 0)
+        throw std::invalid_argument("Voxel resolution must be positive");
+    if (tolerance < 0 || tolerance > 1)
+        throw std::invalid_argument("Color tolerance outside range [0, 1]");
+    resolution = res;
+    color_tolerance = tolerance;
+    learning_rate = 0.05;
+    camera_transform = transform;
+    max_label = 0;
+}
+
+/**
+ * Store a frame and its supervoxel segmentation as the background
+ * 
+ * @param cloud         the colored pointcloud of the frame
+ * @param labels        the supervoxel label of each point of the frame, in
+ *                      the same order of cloud
+ * @param supervoxels   the supervoxels of the frame
+ * @param adj           the adjacency between the supervoxels
+ */
+void BackgroundModel::set_background(PointCloudT::Ptr cloud,
+        PointLCloudT::Ptr labels, const ClusteringT &supervoxels,
+        const AdjacencyMapT &adj) {
+    if (cloud->size() != labels->size())
+        throw std::invalid_argument(
+            "The pointcloud and its labels must have the same size");
+    clear();
+
+    // A voxel takes the label of most of its points; the labels of a voxel 
+    // are few, so they are counted in a short list
+    typedef std::vector<std::pair<uint32_t, size_t> > LabelCountsT;
+    std::unordered_map<uint64_t, size_t> counts;
+    std::unordered_map<uint64_t, LabelCountsT> label_counts;
+    for (size_t i = 0; i < cloud->size(); i++) {
+        const PointT &p = cloud->at(i);
+        uint64_t k = key(p);
+        size_t &n = counts[k];
+        backgroundVoxel &v = voxels[k];
+        if (n == 0) {
+            v.rgb[0] = v.rgb[1] = v.rgb[2] = 0;
+            v.label = 0;
+        }
+        n++;
+        v.rgb[0] += (p.r - v.rgb[0]) / n;
+        v.rgb[1] += (p.g - v.rgb[1]) / n;
+        v.rgb[2] += (p.b - v.rgb[2]) / n;
+        uint32_t label = labels->at(i).label;
+        if (label == 0)
+            continue;
+        LabelCountsT &l_counts = label_counts[k];
+        LabelCountsT::iterator l_it = l_counts.begin();
+        while (l_it != l_counts.end() && l_it->first != label)
+            ++l_it;
+        if (l_it == l_counts.end())
+            l_counts.push_back(std::pair<uint32_t, size_t>(label, 1));
+        else
+            l_it->second++;
+    }
+    std::unordered_map<uint64_t, LabelCountsT>::const_iterator c_it =
+            label_counts.begin();
+    for (; c_it != label_counts.end(); ++c_it) {
+        LabelCountsT::const_iterator l_it = c_it->second.begin();
+        LabelCountsT::const_iterator best = l_it;
+        for (; l_it != c_it->second.end(); ++l_it)
+            if (l_it->second > best->second)
+                best = l_it;
+        voxels[c_it->first].label = best->first;
+    }
+
+    segments = supervoxels;
+    adjacency = adj;
+    if (!segments.empty())
+        max_label = segments.rbegin()->first;
+}
+
+/**
+ * Compare a frame against the background, marking its unchanged voxels
+ * 
+ * @param cloud   the colored pointcloud of the frame
+ * @param indices filled with the indices in cloud of the returned points
+ * 
+ * @return the points of the frame which need to be segmented again
+ */
+PointCloudT::Ptr BackgroundModel::classify(PointCloudT::Ptr cloud,
+        std::vector<int> &indices) {
+    struct frameVoxel {
+        float rgb[3];
+        size_t n;
+    };
+    std::unordered_map<uint64_t, frameVoxel> frame;
+    std::vector<uint64_t> keys(cloud->size());
+    for (size_t i = 0; i < cloud->size(); i++) {
+        const PointT &p = cloud->at(i);
+        keys[i] = key(p);
+        frameVoxel &v = frame[keys[i]];
+        if (v.n == 0)
+            v.rgb[0] = v.rgb[1] = v.rgb[2] = 0;
+        v.n++;
+        v.rgb[0] += (p.r - v.rgb[0]) / v.n;
+        v.rgb[1] += (p.g - v.rgb[1]) / v.n;
+        v.rgb[2] += (p.b - v.rgb[2]) / v.n;
+    }
+
+    // Supervoxels having at least one voxel which changed color or
+    // disappeared cannot be carried over
+    float max_diff = color_tolerance * RGB_RANGE;
+    std::set<uint32_t> invalid;
+    std::set<uint64_t> changed;
+    VoxelMapT::iterator v_it = voxels.begin();
+    for (; v_it != voxels.end(); ++v_it) {
+        std::unordered_map<uint64_t, frameVoxel>::iterator f_it =
+                frame.find(v_it->first);
+        bool unchanged = false;
+        if (f_it != frame.end()) {
+            Eigen::Vector3f diff(f_it->second.rgb[0] - v_it->second.rgb[0],
+                    f_it->second.rgb[1] - v_it->second.rgb[1],
+                    f_it->second.rgb[2] - v_it->second.rgb[2]);
+            unchanged = diff.norm() <= max_diff;
+            if (unchanged) {
+                for (int c = 0; c < 3; c++)
+                    v_it->second.rgb[c] += learning_rate
+                        * (f_it->second.rgb[c] - v_it->second.rgb[c]);
+            } else {
+                changed.insert(v_it->first);
+            }
+        }
+        if (!unchanged)
+            invalid.insert(v_it->second.label);
+    }
+
+    carried.clear();
+    ClusteringT::const_iterator s_it = segments.begin();
+    for (; s_it != segments.end(); ++s_it) {
+        if (invalid.count(s_it->first) == 0)
+            carried.insert(*s_it);
+    }
+
+    PointCloudT::Ptr changed_cloud(new PointCloudT);
+    indices.clear();
+    for (size_t i = 0; i < cloud->size(); i++) {
+        VoxelMapT::const_iterator b_it = voxels.find(keys[i]);
+        if (b_it == voxels.end() || changed.count(keys[i]) != 0
+                || carried.count(b_it->second.label) == 0) {
+            changed_cloud->push_back(cloud->at(i));
+            indices.push_back(i);
+        }
+    }
+
+    stats = backgroundStats();
+    stats.points = cloud->size();
+    stats.changed_points = changed_cloud->size();
+    stats.supervoxels = segments.size();
+    stats.carried_supervoxels = carried.size();
+    pcl::console::print_debug("Background: %zu/%zu points changed, %zu/%zu "
+            "supervoxels carried\n", stats.changed_points, stats.points,
+            stats.carried_supervoxels, stats.supervoxels);
+
+    return changed_cloud;
+}
+
+/**
+ * Add the carried supervoxels of the last classified frame to the supervoxels
+ * extracted from its changed points. New supervoxels are relabelled so that 
+ * their labels do not clash with the background ones, and new edges are added
+ * between new and carried supervoxels touching each other.
+ * 
+ * @param supervoxels   the supervoxels extracted from the changed points, 
+ *                      updated with the carried ones
+ * @param adj           the adjacency of the new supervoxels, updated with the
+ *                      edges towards the carried ones
+ */
+void BackgroundModel::link(ClusteringT &supervoxels,
+        AdjacencyMapT &adj) const {
+    ClusteringT linked = carried;
+    std::map<uint32_t, uint32_t> new_labels;
+    ClusteringT::iterator s_it = supervoxels.begin();
+    for (; s_it != supervoxels.end(); ++s_it) {
+        uint32_t l = max_label + s_it->first;
+        new_labels.insert(std::pair<uint32_t, uint32_t>(s_it->first, l));
+        linked.insert(std::pair<uint32_t, SupervoxelT::Ptr>(l, s_it->second));
+    }
+
+    std::set<std::pair<uint32_t, uint32_t> > edges;
+    AdjacencyMapT::const_iterator a_it = adj.begin();
+    for (; a_it != adj.end(); ++a_it) {
+        uint32_t l1 = new_labels.at(a_it->first);
+        uint32_t l2 = new_labels.at(a_it->second);
+        edges.insert(std::pair<uint32_t, uint32_t>(std::min(l1, l2),
+                std::max(l1, l2)));
+    }
+    for (a_it = adjacency.begin(); a_it != adjacency.end(); ++a_it) {
+        if (carried.count(a_it->first) != 0
+                && carried.count(a_it->second) != 0)
+            edges.insert(std::pair<uint32_t, uint32_t>(
+                std::min(a_it->first, a_it->second),
+                std::max(a_it->first, a_it->second)));
+    }
+
+    // New supervoxels are adjacent to the carried ones owning any of the 26
+    // voxels surrounding one of their voxels
+    for (s_it = supervoxels.begin(); s_it != supervoxels.end(); ++s_it) {
+        uint32_t l = new_labels.at(s_it->first);
+        PointCloudT::iterator v_it = s_it->second->voxels_->begin();
+        for (; v_it != s_it->second->voxels_->end(); ++v_it) {
+            uint64_t k = key(*v_it);
+            for (int dx = -1; dx <= 1; dx++)
+                for (int dy = -1; dy <= 1; dy++)
+                    for (int dz = -1; dz <= 1; dz++) {
+                        VoxelMapT::const_iterator b_it = voxels.find(
+                                neighbor_key(k, dx, dy, dz));
+                        if (b_it != voxels.end()
+                                && carried.count(b_it->second.label) != 0)
+                            edges.insert(std::pair<uint32_t, uint32_t>(
+                                b_it->second.label, l));
+                    }
+        }
+    }
+
+    supervoxels = linked;
+    adj.clear();
+    std::set<std::pair<uint32_t, uint32_t> >::iterator e_it = edges.begin();
+    for (; e_it != edges.end(); ++e_it)
+        adj.insert(*e_it);
+}
+
+/**
+ * Get the supervoxels carried over from the background in the last classified
+ * frame
+ * 
+ * @return the carried supervoxels, identified by their background labels
+ */
+ClusteringT BackgroundModel::get_carried() const {
+    return carried;
+}
+
+/**
+ * Forget the background
+ */
+void BackgroundModel::clear() {
+    voxels.clear();
+    segments.clear();
+    carried.clear();
+    adjacency.clear();
+    max_label = 0;
+    stats = backgroundStats();
+}
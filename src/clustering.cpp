@@ -37,7 +37,11 @@
  *
  */
 
+#include <algorithm>
+#include <limits>
+
 #include "supervoxel_clustering/clustering.h"
+#include "supervoxel_clustering/task_graph.h"
 
 /**
  * Test if two regions form a convex angle between them
@@ -101,19 +105,23 @@ float Clustering::normals_diff(Normal norm1, PointT centroid1, Normal norm2,
  * 
  * @param supvox1   the first region
  * @param supvox2   the second region
+ * @param moments1  the moments of the first region, if known
+ * @param moments2  the moments of the second region, if known
  * 
  * @return a pair containing delta_c as first value and delta_g as second value
  */
 std::pair<float, float> Clustering::delta_c_g(SupervoxelT::Ptr supvox1,
-        SupervoxelT::Ptr supvox2) const {
+        SupervoxelT::Ptr supvox2, const segmentMoments *moments1,
+        const segmentMoments *moments2) const {
     float delta_c = 0;
-    float * rgb1 = ColorUtilities::mean_color(supvox1);
-    float * rgb2 = ColorUtilities::mean_color(supvox2);
+    float rgb1[3], rgb2[3];
+    mean_color(supvox1, moments1, rgb1);
+    mean_color(supvox2, moments2, rgb2);
     switch (delta_c_type) {
         case LAB_CIEDE00:
-            float *lab1, *lab2;
-            lab1 = ColorUtilities::rgb2lab(rgb1);
-            lab2 = ColorUtilities::rgb2lab(rgb2);
+            float lab1[3], lab2[3];
+            ColorUtilities::rgb2lab(rgb1, lab1);
+            ColorUtilities::rgb2lab(rgb2, lab2);
             delta_c = ColorUtilities::lab_ciede00(lab1, lab2);
             delta_c /= LAB_RANGE;
             break;
@@ -146,13 +154,17 @@ std::pair<float, float> Clustering::delta_c_g(SupervoxelT::Ptr supvox1,
  * 
  * @param supvox1   the first region
  * @param supvox2   the second region
+ * @param moments1  the moments of the first region, if known
+ * @param moments2  the moments of the second region, if known
  * 
  * @return the distance value
  */
 float Clustering::delta(SupervoxelT::Ptr supvox1,
-        SupervoxelT::Ptr supvox2) const {
+        SupervoxelT::Ptr supvox2, const segmentMoments *moments1,
+        const segmentMoments *moments2) const {
 
-    std::pair<float, float> deltas = delta_c_g(supvox1, supvox2);
+    std::pair<float, float> deltas = delta_c_g(supvox1, supvox2, moments1,
+            moments2);
 
     float delta = t_c(deltas.first) + t_g(deltas.second);
 
@@ -165,84 +177,116 @@ float Clustering::delta(SupervoxelT::Ptr supvox1,
  * Converts a weight map to an anjacency map (i.e. a map only recording which 
  * regions are adjacent tho which others without any weight information)
  * 
- * @param w_map a weight map
- * 
- * @return the corresponding adjacency map
+ * @param w_map     a weight map
+ * @param adj_map   the map in which the corresponding adjacency map is 
+ *                  written
  */
-AdjacencyMapT Clustering::weight2adj(WeightMapT w_map) const {
-    AdjacencyMapT adj_map;
+void Clustering::weight2adj(const WeightMapT &w_map,
+        AdjacencyMapT &adj_map) const {
+    adj_map.clear();
 
-    WeightMapT::iterator it = w_map.begin();
-    WeightMapT::iterator it_end = w_map.end();
+    WeightMapT::const_iterator it = w_map.begin();
+    WeightMapT::const_iterator it_end = w_map.end();
     for (; it != it_end; ++it) {
         adj_map.insert(it->second);
     }
-
-    return adj_map;
 }
 
 /**
  * Converts an adjacency map (i.e. a map only recording which regions are 
- * adjacent tho which others without any weight information)to a weight map.
- * All weight are set to -1.
+ * adjacent tho which others without any weight information) to a weight map.
+ * All weight are set to -1. Each edge is listed in both directions in the
+ * adjacency map, so the lower triangle under the diagonal is skipped.
  * 
- * @param w_map an adjacency map
- * 
- * @return the corresponding weight map
+ * @param adj_map   an adjacency map
+ * @param w_map     the map in which the corresponding weight map is written
  */
-WeightMapT Clustering::adj2weight(ClusteringT segm,
-        AdjacencyMapT adj_map) const {
-    WeightMapT w_map;
+void Clustering::adj2weight(const AdjacencyMapT &adj_map,
+        WeightMapT &w_map) const {
+    w_map.clear();
 
-    AdjacencyMapT::iterator it = adj_map.begin();
-    AdjacencyMapT::iterator it_end = adj_map.end();
+    AdjacencyMapT::const_iterator it = adj_map.begin();
+    AdjacencyMapT::const_iterator it_end = adj_map.end();
     for (; it != it_end; ++it) {
+        if (it->first > it->second)
+            continue;
         WeightedPairT elem;
         elem.first = -1;
         elem.second = *(it);
         w_map.insert(elem);
     }
+}
 
-    return w_map;
+/**
+ * Compute the color and geometric distances of a range of edges of the initial
+ * state; ranges are computed in parallel if a thread pool is set
+ * 
+ * @param edges     the edges of the initial state
+ * @param cached    whether the distances of each edge were found in the 
+ *                  temporal cache
+ * @param deltas    the distances of each edge, filled for the given range
+ * @param begin     the first edge of the range
+ * @param end       the edge after the last one of the range
+ */
+void Clustering::compute_deltas(
+        const std::vector<std::pair<uint32_t, uint32_t> > *edges,
+        const std::vector<char> *cached,
+        std::vector<std::pair<float, float> > *deltas, size_t begin,
+        size_t end) const {
+    for (size_t i = begin; i < end; ++i) {
+        if ((*cached)[i])
+            continue;
+        SupervoxelT::Ptr sup1 = initial_state.segments.at((*edges)[i].first);
+        SupervoxelT::Ptr sup2 = initial_state.segments.at((*edges)[i].second);
+        (*deltas)[i] = delta_c_g(sup1, sup2);
+    }
 }
 
 /**
  * Initialize all weights in the initial state of the graph
  */
 void Clustering::init_weights() {
-    std::map<std::string, std::pair<float, float> > temp_deltas;
-    DeltasDistribT deltas_c;
-    DeltasDistribT deltas_g;
-    WeightMapT w_new;
-
+    std::vector<std::pair<uint32_t, uint32_t> > edges;
+    edges.reserve(initial_state.weight_map.size());
     WeightMapT::iterator it = initial_state.weight_map.begin();
     WeightMapT::iterator it_end = initial_state.weight_map.end();
-    for (; it != it_end; ++it) {
-        uint32_t sup1_id = it->second.first;
-        uint32_t sup2_id = it->second.second;
-        std::stringstream ids;
-        ids << sup1_id << "-" << sup2_id;
-        SupervoxelT::Ptr sup1 = initial_state.segments.at(sup1_id);
-        SupervoxelT::Ptr sup2 = initial_state.segments.at(sup2_id);
-        std::pair<float, float> deltas = delta_c_g(sup1, sup2);
-        temp_deltas.insert(
-                std::pair<std::string, std::pair<float, float> >(ids.str(),
-                deltas));
-        deltas_c.insert(deltas.first);
-        deltas_g.insert(deltas.second);
+    for (; it != it_end; ++it)
+        edges.push_back(it->second);
+
+    std::vector<std::pair<float, float> > deltas(edges.size());
+    std::vector<char> cached(edges.size(), 0);
+    if (temporal_cache)
+        for (size_t i = 0; i < edges.size(); ++i)
+            cached[i] = temporal_cache->lookup(edges[i].first,
+                edges[i].second, deltas[i]);
+
+    // Edges are split in more chunks than workers, so that idle workers can
+    // steal the chunks left when some regions are more costly than others
+    size_t chunks = (pool) ? 4 * pool->size() : 1;
+    size_t chunk_size = std::max<size_t>(1,
+            (edges.size() + chunks - 1) / chunks);
+    TaskGraph graph(pool);
+    for (size_t begin = 0; begin < edges.size(); begin += chunk_size)
+        graph.add_task("weights", boost::bind(&Clustering::compute_deltas,
+            this, &edges, &cached, &deltas, begin,
+            std::min(begin + chunk_size, edges.size())));
+    graph.run();
+
+    DeltasDistribT deltas_c;
+    DeltasDistribT deltas_g;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (temporal_cache)
+            temporal_cache->store(edges[i].first, edges[i].second, deltas[i]);
+        deltas_c.insert(deltas[i].first);
+        deltas_g.insert(deltas[i].second);
     }
 
     init_merging_parameters(deltas_c, deltas_g);
 
-    it = initial_state.weight_map.begin();
-    for (; it != it_end; ++it) {
-        uint32_t sup1_id = it->second.first;
-        uint32_t sup2_id = it->second.second;
-        std::stringstream ids;
-        ids << sup1_id << "-" << sup2_id;
-        std::pair<float, float> deltas = temp_deltas.at(ids.str());
-        float delta = t_c(deltas.first) + t_g(deltas.second);
-        w_new.insert(WeightedPairT(delta, it->second));
+    WeightMapT w_new;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        float delta = t_c(deltas[i].first) + t_g(deltas[i].second);
+        w_new.insert(WeightedPairT(delta, edges[i]));
     }
 
     initial_state.set_weight_map(w_new);
@@ -257,8 +301,8 @@ void Clustering::init_weights() {
  * @param deltas_c the distribution of delta_c values
  * @param deltas_g the distribution of delta_g values
  */
-void Clustering::init_merging_parameters(DeltasDistribT deltas_c,
-        DeltasDistribT deltas_g) {
+void Clustering::init_merging_parameters(const DeltasDistribT &deltas_c,
+        const DeltasDistribT &deltas_g) {
     switch (merging_type) {
         case MANUAL_LAMBDA:
         {
@@ -286,11 +330,11 @@ void Clustering::init_merging_parameters(DeltasDistribT deltas_c,
  * 
  * @return the cdf of the given distribution
  */
-std::map<short, float> Clustering::compute_cdf(DeltasDistribT dist) {
+std::map<short, float> Clustering::compute_cdf(const DeltasDistribT &dist) {
     std::map<short, float> cdf;
     int bins[bins_num] = {};
 
-    DeltasDistribT::iterator d_itr, d_itr_end;
+    DeltasDistribT::const_iterator d_itr, d_itr_end;
     d_itr = dist.begin();
     d_itr_end = dist.end();
     int n = dist.size();
@@ -376,45 +420,91 @@ float Clustering::t_g(float delta_g) const {
 }
 
 /**
- * Perform the clustering. The result is stored in the object internal state.
+ * Continue the clustering of a state up to a threshold. Only the given state
+ * is modified, so many threads can run the clustering at the same time, each
+ * on its own state, once the initial state has been prepared.
  * 
- * @param start     the state from which the clustering should start
+ * @param run_state the state to be clustered, usually a copy of the initial
+ *                  state or the result of a run with a lower threshold
  * @param threshold the threshold value
+ * @param merges    if not NULL, the weight and the labels of the regions of 
+ *                  each merge are appended to it, in the order they happen
+ * @param merge_voxels  if false, the voxels of the merged regions are not 
+ *                      gathered, leaving their voxel clouds empty; the 
+ *                      merges are the same, but the state can't be converted
+ *                      to a labelled pointcloud
  */
-void Clustering::cluster(ClusteringState start, float threshold) {
-    state = start;
+void Clustering::run(ClusteringState &run_state, float threshold,
+        std::vector<WeightedPairT> *merges, bool merge_voxels) const {
+    if (!init_initial_weights)
+        throw std::logic_error("Cannot call 'run' before preparing the "
+            "initial state with 'prepare'");
 
     WeightedPairT next;
-    while (!state.weight_map.empty()
-            && (next = state.get_first_weight(), next.first < threshold)) {
+    while (!run_state.weight_map.empty()
+            && (next = run_state.get_first_weight(), next.first < threshold)) {
         pcl::console::print_debug("left: %de/%dp - w: %f - [%d, %d]...",
-                state.weight_map.size(), state.segments.size(), next.first,
-                next.second.first, next.second.second);
-        merge(next.second);
+                run_state.weight_map.size(), run_state.segments.size(),
+                next.first, next.second.first, next.second.second);
+        merge(run_state, next.second, merge_voxels);
+        if (merges != NULL)
+            merges->push_back(next);
         pcl::console::print_debug("OK\n");
     }
 }
 
 /**
- * Merge two regions into one
+ * Merge two regions into one. The regions of the initial state are shared
+ * between states and never modified: the merged region is a new one.
  * 
+ * @param state         the state in which the regions are merged
  * @param supvox_ids    a pair containing the two region labels to be merged
+ * @param merge_voxels  if false, the merged region gets no voxels, and its 
+ *                      color is taken from its moments
  */
-void Clustering::merge(std::pair<uint32_t, uint32_t> supvox_ids) {
+void Clustering::merge(ClusteringState &state,
+        std::pair<uint32_t, uint32_t> supvox_ids, bool merge_voxels) const {
     SupervoxelT::Ptr sup1 = state.segments.at(supvox_ids.first);
     SupervoxelT::Ptr sup2 = state.segments.at(supvox_ids.second);
     SupervoxelT::Ptr sup_new = boost::make_shared<SupervoxelT>();
 
-    *(sup_new->voxels_) = *(sup1->voxels_) + *(sup2->voxels_);
-    *(sup_new->normals_) = *(sup1->normals_) + *(sup2->normals_);
+    if (merge_voxels) {
+        sup_new->voxels_->reserve(
+                sup1->voxels_->size() + sup2->voxels_->size());
+        *(sup_new->voxels_) += *(sup1->voxels_);
+        *(sup_new->voxels_) += *(sup2->voxels_);
+        sup_new->normals_->reserve(
+                sup1->normals_->size() + sup2->normals_->size());
+        *(sup_new->normals_) += *(sup1->normals_);
+        *(sup_new->normals_) += *(sup2->normals_);
+    }
+
+    // Centroid and normal of the merged region come from the sum of the 
+    // moments of the two regions, without visiting their voxels
+    const segmentMoments &moments1 = get_moments(state, supvox_ids.first,
+            sup1);
+    const segmentMoments &moments2 = get_moments(state, supvox_ids.second,
+            sup2);
+    segmentMoments new_moments = SegmentMoments::combine(moments1, moments2);
+    float weight1 = moments1.count, weight2 = moments2.count;
+    state.moments.erase(supvox_ids.second);
+    state.moments[supvox_ids.first] = new_moments;
 
     PointT new_centr;
-    computeCentroid(*(sup_new->voxels_), new_centr);
+    SegmentMoments::centroid(new_moments, new_centr);
     sup_new->centroid_ = new_centr;
 
     Eigen::Vector4f new_norm;
     float new_curv;
-    computePointNormal(*(sup_new->voxels_), new_norm, new_curv);
+    if (voxel_normals) {
+        // Normals from the sensor are averaged, as the voxel normals are
+        new_norm = weight1 * sup1->normal_.getNormalVector4fMap()
+                + weight2 * sup2->normal_.getNormalVector4fMap();
+        new_curv = (weight1 * sup1->normal_.curvature
+                + weight2 * sup2->normal_.curvature) / (weight1 + weight2);
+    } else {
+        SegmentMoments::normal(new_moments, new_norm, new_curv);
+    }
     flipNormalTowardsViewpoint(sup_new->centroid_, 0, 0, 0, new_norm);
     new_norm[3] = 0.0f;
     new_norm.normalize();
@@ -428,27 +518,22 @@ void Clustering::merge(std::pair<uint32_t, uint32_t> supvox_ids) {
     state.segments.insert(
             std::pair<uint32_t, SupervoxelT::Ptr>(supvox_ids.first, sup_new));
 
-    WeightMapT new_map;
+    // The weight map is updated in place: only the edges touching one of the
+    // two merged regions are removed, relabelled and inserted again with 
+    // their new weight, while all other edges are left untouched
+    std::vector<std::pair<uint32_t, uint32_t> > affected;
 
     WeightMapT::iterator it = state.weight_map.begin();
-    ++it;
+    state.weight_map.erase(it++);
     WeightMapT::iterator it_end = state.weight_map.end();
-    for (; it != it_end; ++it) {
+    while (it != it_end) {
         std::pair<uint32_t, uint32_t> curr_ids = it->second;
         if (curr_ids.first == supvox_ids.first
                 || curr_ids.second == supvox_ids.first) {
-            if (!contains(new_map, curr_ids.first, curr_ids.second)) {
-                float w = delta(state.segments.at(curr_ids.first),
-                        state.segments.at(curr_ids.second));
-                new_map.insert(WeightedPairT(w, curr_ids));
-            }
+            affected.push_back(curr_ids);
         } else if (curr_ids.first == supvox_ids.second) {
             curr_ids.first = supvox_ids.first;
-            if (!contains(new_map, curr_ids.first, curr_ids.second)) {
-                float w = delta(state.segments.at(curr_ids.first),
-                        state.segments.at(curr_ids.second));
-                new_map.insert(WeightedPairT(w, curr_ids));
-            }
+            affected.push_back(curr_ids);
         } else if (curr_ids.second == supvox_ids.second) {
             if (curr_ids.first < supvox_ids.first)
                 curr_ids.second = supvox_ids.first;
@@ -456,53 +541,46 @@ void Clustering::merge(std::pair<uint32_t, uint32_t> supvox_ids) {
                 curr_ids.second = curr_ids.first;
                 curr_ids.first = supvox_ids.first;
             }
-            if (!contains(new_map, curr_ids.first, curr_ids.second)) {
-                float w = delta(state.segments.at(curr_ids.first),
-                        state.segments.at(curr_ids.second));
-                new_map.insert(WeightedPairT(w, curr_ids));
-            }
+            affected.push_back(curr_ids);
         } else {
-            new_map.insert(*it);
+            ++it;
+            continue;
         }
+        state.weight_map.erase(it++);
     }
-    state.weight_map = new_map;
-}
 
-/**
- * Clear the lower triangle under the diaconal of the adjacency map
- * 
- * @param adjacency the adjacency map to be cleared
- */
-void Clustering::clear_adjacency(AdjacencyMapT * adjacency) {
-    AdjacencyMapT::iterator it = adjacency->begin();
-    AdjacencyMapT::iterator it_end = adjacency->end();
-    while (it != it_end) {
-        if (it->first > it->second) {
-            adjacency->erase(it++);
-        } else {
-            ++it;
-        }
+    std::sort(affected.begin(), affected.end());
+    std::vector<std::pair<uint32_t, uint32_t> >::iterator a_it =
+            affected.begin();
+    std::vector<std::pair<uint32_t, uint32_t> >::iterator a_it_end =
+            std::unique(affected.begin(), affected.end());
+    for (; a_it != a_it_end; ++a_it) {
+        MomentsMapT::const_iterator m1 = state.moments.find(a_it->first);
+        MomentsMapT::const_iterator m2 = state.moments.find(a_it->second);
+        float w = delta(state.segments.at(a_it->first),
+                state.segments.at(a_it->second),
+                (m1 != state.moments.end()) ? &m1->second : NULL,
+                (m2 != state.moments.end()) ? &m2->second : NULL);
+        state.weight_map.insert(WeightedPairT(w, *a_it));
     }
 }
 
 /**
- * Check if the edge connecting two regions is contained in a weight map
- * 
- * @param w     a weight map
- * @param i1    the first label
- * @param i2    the second label
+ * Compute the mean color of a region from its voxels or, if it was merged 
+ * without gathering them, from its moments
  * 
- * @return true if the edge exists, false if it doesn't
+ * @param s         the region
+ * @param moments   the moments of the region, if known
+ * @param rgb       the mean color of the region as an array of RGB values
  */
-bool Clustering::contains(WeightMapT w, uint32_t i1, uint32_t i2) {
-    WeightMapT::iterator it = w.begin();
-    WeightMapT::iterator it_end = w.end();
-    for (; it != it_end; ++it) {
-        std::pair<uint32_t, uint32_t> ids = it->second;
-        if (ids.first == i1 && ids.second == i2)
-            return true;
+void Clustering::mean_color(SupervoxelT::Ptr s,
+        const segmentMoments *moments, float rgb[3]) {
+    if (moments == NULL || !s->voxels_->empty() || moments->count == 0) {
+        ColorUtilities::mean_color(s, rgb);
+        return;
     }
-    return false;
+    for (int i = 0; i < 3; ++i)
+        rgb[i] = moments->sum_rgba[i] / moments->count;
 }
 
 /**
@@ -512,8 +590,8 @@ bool Clustering::contains(WeightMapT w, uint32_t i1, uint32_t i2) {
  * 
  * @return the mean value
  */
-float Clustering::deltas_mean(DeltasDistribT deltas) {
-    DeltasDistribT::iterator d_itr, d_itr_end;
+float Clustering::deltas_mean(const DeltasDistribT &deltas) {
+    DeltasDistribT::const_iterator d_itr, d_itr_end;
     d_itr = deltas.begin();
     d_itr_end = deltas.end();
     float count = 0;
@@ -536,6 +614,9 @@ Clustering::Clustering() {
     set_merging(ADAPTIVE_LAMBDA);
     set_initial_state = false;
     init_initial_weights = false;
+    temporal_cache = NULL;
+    pool = NULL;
+    voxel_normals = false;
 }
 
 /**
@@ -552,6 +633,9 @@ Clustering::Clustering(ColorDistance c, GeometricDistance g,
     set_merging(m);
     set_initial_state = false;
     init_initial_weights = false;
+    temporal_cache = NULL;
+    pool = NULL;
+    voxel_normals = false;
 }
 
 /**
@@ -597,20 +681,76 @@ void Clustering::set_bins_num(short b) {
 }
 
 /**
- * Set the initial state of the clustering process
+ * Set the initial state of the clustering process; the state of the previous 
+ * frame, if any, is overwritten in place
  * 
  * @param segm  the initial segmentation (output of some supervoxel algorithm)
  * @param adj   the edges (unweighted) of the clustering graph
  */
-void Clustering::set_initialstate(ClusteringT segm, AdjacencyMapT adj) {
-    clear_adjacency(&adj);
-    ClusteringState init_state(segm, adj2weight(segm, adj));
-    initial_state = init_state;
-    state = init_state;
+void Clustering::set_initialstate(const ClusteringT &segm,
+        const AdjacencyMapT &adj) {
+    initial_state.segments = segm;
+    adj2weight(adj, initial_state.weight_map);
+    initial_state.moments.clear();
+    ClusteringT::const_iterator s_it = segm.begin();
+    for (; s_it != segm.end(); ++s_it)
+        initial_state.moments[s_it->first] =
+            SegmentMoments::compute(*(s_it->second->voxels_));
+    state = initial_state;
     set_initial_state = true;
     init_initial_weights = false;
 }
 
+/**
+ * Set a cache from which the color and geometric distances of unchanged 
+ * regions can be reused across consecutive frames. The cache is also updated 
+ * with the distances computed for the current initial state. Passing NULL 
+ * disables the cache.
+ * 
+ * @param cache a temporal cache, which must outlive the clustering
+ */
+void Clustering::set_temporal_cache(TemporalCache * cache) {
+    temporal_cache = cache;
+    init_initial_weights = false;
+}
+
+/**
+ * Set a thread pool on which the edge weights and the evaluation of multiple
+ * thresholds are computed in parallel. Passing NULL computes them in the 
+ * calling thread.
+ * 
+ * @param thread_pool   a thread pool, which must outlive the clustering
+ */
+void Clustering::set_thread_pool(ThreadPool * thread_pool) {
+    pool = thread_pool;
+}
+
+/**
+ * Compute the edge weights of the initial state. After this call the initial
+ * state is read-only, and 'run' can be called concurrently on separate states
+ * as long as the parameters are not changed.
+ */
+void Clustering::prepare() {
+    if (!set_initial_state)
+        throw std::logic_error("Cannot call 'prepare' before "
+            "setting an initial state with 'set_initialstate'");
+
+    if (!init_initial_weights)
+        init_weights();
+}
+
+/**
+ * Get the prepared initial state, to be used as starting point of 'run'
+ * 
+ * @return the initial state
+ */
+const ClusteringState & Clustering::get_initialstate() const {
+    if (!init_initial_weights)
+        throw std::logic_error("Cannot call 'get_initialstate' before "
+            "preparing the initial state with 'prepare'");
+    return initial_state;
+}
+
 /**
  * Get the current state of the segmentation
  * 
@@ -619,17 +759,27 @@ void Clustering::set_initialstate(ClusteringT segm, AdjacencyMapT adj) {
 std::pair<ClusteringT, AdjacencyMapT> Clustering::get_currentstate() const {
     std::pair<ClusteringT, AdjacencyMapT> ret;
     ret.first = state.segments;
-    ret.second = weight2adj(state.weight_map);
+    weight2adj(state.weight_map, ret.second);
     return ret;
 }
 
+/**
+ * Get the adjacency between the regions of the current state, without copying
+ * the regions
+ * 
+ * @param adjacency the map in which the adjacency is written
+ */
+void Clustering::get_adjacency(AdjacencyMapT &adjacency) const {
+    weight2adj(state.weight_map, adjacency);
+}
+
 /**
  * Get the colored pointcloud corresponding to the current state
  * 
  * @return a colored pointcloud
  */
 PointCloudT::Ptr Clustering::get_colored_cloud() const {
-    return label2color(get_labeled_cloud());
+    return state2color(state, pool);
 }
 
 /**
@@ -639,27 +789,72 @@ PointCloudT::Ptr Clustering::get_colored_cloud() const {
  */
 PointLCloudT::Ptr Clustering::get_labeled_cloud() const {
     PointLCloudT::Ptr label_cloud(new PointLCloudT);
+    get_labeled_cloud(*label_cloud);
+    return label_cloud;
+}
+
+/**
+ * Get the pointcloud of the regions corresponding to the current state, 
+ * reusing the memory of the given pointcloud
+ * 
+ * @param label_cloud   the pointcloud in which the labelled pointcloud is 
+ *                      written
+ */
+void Clustering::get_labeled_cloud(PointLCloudT &label_cloud) const {
+    state2label(state, label_cloud);
+}
+
+/**
+ * Get the colored pointcloud of the regions of a state
+ * 
+ * @param state   the state
+ * @param pool    the thread pool on which the pointcloud is colored, or NULL
+ *                to color it in the calling thread
+ * 
+ * @return a colored pointcloud
+ */
+PointCloudT::Ptr Clustering::state2color(const ClusteringState &state,
+        ThreadPool *pool) {
+    PointLCloudT::Ptr label_cloud(new PointLCloudT);
+    state2label(state, *label_cloud);
+    return label2color(label_cloud, pool);
+}
 
+/**
+ * Get the pointcloud of the regions of a state, reusing the memory of the 
+ * given pointcloud
+ * 
+ * @param state         the state
+ * @param label_cloud   the pointcloud in which the labelled pointcloud is 
+ *                      written
+ */
+void Clustering::state2label(const ClusteringState &state,
+        PointLCloudT &label_cloud) {
     ClusteringT::const_iterator it = state.segments.begin();
     ClusteringT::const_iterator it_end = state.segments.end();
 
+    size_t size = 0;
+    for (; it != it_end; ++it)
+        size += it->second->voxels_->size();
+    label_cloud.resize(size);
+
+    size_t i = 0;
     uint32_t current_l = 0;
-    for (; it != it_end; ++it) {
-        PointCloudT cloud = *(it->second->voxels_);
-        PointCloudT::iterator it_cloud = cloud.begin();
-        PointCloudT::iterator it_cloud_end = cloud.end();
-        for (; it_cloud != it_cloud_end; ++it_cloud) {
-            PointLT p;
+    for (it = state.segments.begin(); it != it_end; ++it) {
+        const PointCloudT &cloud = *(it->second->voxels_);
+        PointCloudT::const_iterator it_cloud = cloud.begin();
+        PointCloudT::const_iterator it_cloud_end = cloud.end();
+        for (; it_cloud != it_cloud_end; ++it_cloud, ++i) {
+            PointLT &p = label_cloud[i];
             p.x = it_cloud->x;
             p.y = it_cloud->y;
             p.z = it_cloud->z;
             p.label = current_l;
-            label_cloud->push_back(p);
         }
         current_l++;
     }
-
-    return label_cloud;
+    label_cloud.width = size;
+    label_cloud.height = 1;
 }
 
 /**
@@ -672,10 +867,121 @@ void Clustering::cluster(float threshold) {
         throw std::logic_error("Cannot call 'cluster' before "
             "setting an initial state with 'set_initialstate'");
 
-    if (!init_initial_weights)
-        init_weights();
+    prepare();
+    state = initial_state;
+    run(state, threshold);
+}
+
+/**
+ * Record the whole hierarchy of the clustering, that is the sequence of merges
+ * of a run from the initial state until a single region is left; the voxels
+ * of the merged regions are never gathered, so the cost of each merge does
+ * not grow with the size of the regions
+ * 
+ * @param merges    the vector in which the merges are written, in the order
+ *                  they happen
+ */
+void Clustering::hierarchy(std::vector<WeightedPairT> &merges) const {
+    ClusteringState full_state = initial_state;
+    merges.clear();
+    run(full_state, std::numeric_limits<float>::infinity(), &merges, false);
+}
+
+/**
+ * Get the descriptors of the regions of the current state, computed from their
+ * moments in time linear in the number of regions
+ * 
+ * @return the descriptors of each region
+ */
+std::vector<segmentDescriptor> Clustering::get_descriptors() const {
+    return state2descriptors(state);
+}
+
+/**
+ * Get the descriptors of the regions of a state
+ * 
+ * @param state the state
+ * 
+ * @return the descriptors of each region, in the order of their labels
+ */
+std::vector<segmentDescriptor> Clustering::state2descriptors(
+        const ClusteringState &state) {
+    std::vector<segmentDescriptor> descriptors;
+    descriptors.reserve(state.segments.size());
+    ClusteringT::const_iterator it = state.segments.begin();
+    for (; it != state.segments.end(); ++it) {
+        MomentsMapT::const_iterator m_it = state.moments.find(it->first);
+        descriptors.push_back(SegmentMoments::describe(it->first,
+                (m_it != state.moments.end()) ? m_it->second
+                : SegmentMoments::compute(*(it->second->voxels_))));
+    }
+    return descriptors;
+}
+
+/**
+ * Get the moments of a region of a state, computing them if the state was not
+ * built by the clustering
+ * 
+ * @param state     the state
+ * @param label     the label of the region
+ * @param segment   the region
+ * 
+ * @return the moments of the region
+ */
+const segmentMoments & Clustering::get_moments(ClusteringState &state,
+        uint32_t label, SupervoxelT::Ptr segment) {
+    MomentsMapT::iterator it = state.moments.find(label);
+    if (it == state.moments.end())
+        it = state.moments.insert(std::pair<uint32_t, segmentMoments>(label,
+                SegmentMoments::compute(*(segment->voxels_)))).first;
+    return it->second;
+}
+
+/**
+ * Get the spatial index of the regions of the current state. The index is only
+ * built when requested, and each request only processes the regions created 
+ * by merges since the previous one.
+ * 
+ * @return the index of the regions
+ */
+const SegmentIndex & Clustering::get_segment_index() {
+    segment_index.update(state.segments);
+    return segment_index;
+}
 
-    cluster(initial_state, threshold);
+/**
+ * Cluster the initial state at a range of increasing thresholds and evaluate
+ * each result against the groundtruth. The range works on its own copy of the
+ * initial state: the copy is linear in the number of edges, as is each merge,
+ * which scans the whole weight map, so sharing the initial edges between the
+ * ranges would only slow down every merge.
+ * 
+ * @param ground_truth  the groundtruth
+ * @param t_values      the thresholds
+ * @param begin         the first threshold of the range
+ * @param end           the threshold after the last one of the range
+ * @param performances  the scores for each threshold, filled for the range
+ * @param final_state   if not NULL, swapped with the state clustered at the
+ *                      last threshold of the range
+ */
+void Clustering::evaluate_range(PointLCloudT::Ptr ground_truth,
+        const std::vector<float> *t_values, size_t begin, size_t end,
+        std::vector<performanceSet> *performances,
+        ClusteringState *final_state) const {
+    ClusteringState run_state = initial_state;
+    PointLCloudT::Ptr label_cloud(new PointLCloudT);
+    boost::shared_ptr<Testing> test;
+    for (size_t i = begin; i < end; ++i) {
+        run(run_state, (*t_values)[i]);
+        state2label(run_state, *label_cloud);
+        if (!test)
+            test.reset(new Testing(label_cloud, ground_truth));
+        else
+            test->set_segm(label_cloud);
+        (*performances)[i] = test->eval_performance();
+    }
+    if (final_state != NULL)
+        final_state->swap(run_state);
 }
 
 /**
@@ -707,22 +1013,38 @@ std::map<float, performanceSet> Clustering::all_thresh(
     pcl::console::print_info("Testing thresholds from %f to %f (step %f)\n",
             start_thresh, end_thresh, step_thresh);
 
-    std::map<float, performanceSet> thresholds;
-    cluster(start_thresh);
-    Testing test(get_labeled_cloud(), ground_truth);
-    performanceSet p = test.eval_performance();
-    thresholds.insert(std::pair<float, performanceSet>(start_thresh, p));
-    pcl::console::print_info("<T, Fscore, voi, wov> = <%f, %f, %f, %f>\n",
-            start_thresh, p.fscore, p.voi, p.wov);
-
+    std::vector<float> t_values;
+    t_values.push_back(start_thresh);
     for (float t = start_thresh + step_thresh; t <= end_thresh; t +=
-            step_thresh) {
-        cluster(state, t);
-        test.set_segm(get_labeled_cloud());
-        p = test.eval_performance();
-        thresholds.insert(std::pair<float, performanceSet>(t, p));
-        pcl::console::print_info("<T, Fscore, voi, wov> = <%f, %f, %f, %f>\n", t,
-                p.fscore, p.voi, p.wov);
+            step_thresh)
+        t_values.push_back(t);
+
+    prepare();
+
+    // Thresholds are split in contiguous chunks, each clustered incrementally
+    // from the initial state on its own run state; without a thread pool 
+    // there is a single chunk, as in a sequential sweep. Only the state of the
+    // last chunk is kept, as the clustering at the highest threshold.
+    size_t chunks = (pool) ? std::min(t_values.size(), 2 * pool->size()) : 1;
+    size_t chunk_size = (t_values.size() + chunks - 1) / chunks;
+    size_t last_chunk = (t_values.size() - 1) / chunk_size;
+    std::vector<performanceSet> performances(t_values.size());
+    ClusteringState final_state;
+    TaskGraph graph(pool);
+    for (size_t c = 0; c <= last_chunk; ++c)
+        graph.add_task("evaluation", boost::bind(&Clustering::evaluate_range,
+            this, ground_truth, &t_values, c * chunk_size,
+            std::min((c + 1) * chunk_size, t_values.size()), &performances,
+            (c == last_chunk) ? &final_state : NULL));
+    graph.run();
+    state.swap(final_state);
+
+    std::map<float, performanceSet> thresholds;
+    for (size_t i = 0; i < t_values.size(); ++i) {
+        performanceSet p = performances[i];
+        thresholds.insert(std::pair<float, performanceSet>(t_values[i], p));
+        pcl::console::print_info("<T, Fscore, voi, wov> = <%f, %f, %f, %f>\n",
+                t_values[i], p.fscore, p.voi, p.wov);
     }
 
     return thresholds;
@@ -791,24 +1113,83 @@ void Clustering::test_all() const {
  * @return the colored pointcloud
  */
 PointCloudT::Ptr Clustering::label2color(
-        PointLCloudT::Ptr label_cloud) {
+        PointLCloudT::Ptr label_cloud, ThreadPool *pool) {
     PointCloudT::Ptr colored_cloud(new PointCloudT);
-    pcl::PointCloud<PointLCT>::Ptr temp_cloud(new pcl::PointCloud<PointLCT>);
+    label2color(*label_cloud, *colored_cloud, pool);
+    return colored_cloud;
+}
 
-    copyPointCloud(*label_cloud, *temp_cloud);
+/**
+ * Convert a labelled pointcloud of any point type having a label field into a
+ * color one assigning the color in the Glasbey lookup table corresponding to 
+ * the label number, in a single pass; explicitly instantiated for PointXYZL 
+ * and PointXYZRGBL
+ * 
+ * @param label_cloud   a labelled pointcloud
+ * @param colored_cloud the pointcloud in which the colored pointcloud is 
+ *                      written
+ * @param pool          the thread pool on which contiguous ranges of points
+ *                      are colored, or NULL to color them in the calling 
+ *                      thread
+ */
+template <typename PointLabelT>
+void Clustering::label2color(const pcl::PointCloud<PointLabelT> &label_cloud,
+        PointCloudT &colored_cloud, ThreadPool *pool) {
+    colored_cloud.resize(label_cloud.size());
+    colored_cloud.width = label_cloud.width;
+    colored_cloud.height = label_cloud.height;
+    colored_cloud.is_dense = label_cloud.is_dense;
+
+    // Each point only depends on its label, so the ranges are as many as the
+    // workers, each written in place in the output cloud
+    size_t chunks = (pool) ? pool->size() : 1;
+    size_t chunk_size = std::max<size_t>(1,
+            (label_cloud.size() + chunks - 1) / chunks);
+    TaskGraph graph(pool);
+    for (size_t begin = 0; begin < label_cloud.size(); begin += chunk_size)
+        graph.add_task("colors", boost::bind(
+            &Clustering::label2color_range<PointLabelT>, &label_cloud,
+            &colored_cloud, begin,
+            std::min(begin + chunk_size, label_cloud.size())));
+    graph.run();
+}
 
-    pcl::PointCloud<PointLCT>::iterator it = temp_cloud->begin();
-    pcl::PointCloud<PointLCT>::iterator it_end = temp_cloud->end();
+/**
+ * Compute the first slot of a color in the open-addressing table of 
+ * color2label, by Fibonacci hashing
+ * 
+ * @param rgba      the color as an integer
+ * @param capacity  the capacity of the table, a power of two
+ * @return          the slot from which the color is probed
+ */
+size_t Clustering::color_slot(uint32_t rgba, size_t capacity) {
+    return static_cast<size_t>((rgba * 0x9E3779B97F4A7C15ull) >> 32)
+            & (capacity - 1);
+}
 
-    for (; it != it_end; ++it) {
-        uint8_t * rgb = ColorUtilities::get_glasbey(it->label);
-        it->r = rgb[0];
-        it->g = rgb[1];
-        it->b = rgb[2];
+/**
+ * Color a range of points of a labelled pointcloud with the packed Glasbey 
+ * lookup table
+ * 
+ * @param label_cloud   a labelled pointcloud
+ * @param colored_cloud the colored pointcloud, already of the same size
+ * @param begin         the first point of the range
+ * @param end           the point after the last one of the range
+ */
+template <typename PointLabelT>
+void Clustering::label2color_range(
+        const pcl::PointCloud<PointLabelT> *label_cloud,
+        PointCloudT *colored_cloud, size_t begin, size_t end) {
+    const std::vector<uint32_t> &table = ColorUtilities::glasbey_table();
+    const uint32_t table_size = table.size();
+    for (size_t i = begin; i < end; ++i) {
+        const PointLabelT &in = (*label_cloud)[i];
+        PointT &out = (*colored_cloud)[i];
+        out.x = in.x;
+        out.y = in.y;
+        out.z = in.z;
+        out.rgba = table[in.label % table_size];
     }
-
-    copyPointCloud(*temp_cloud, *colored_cloud);
-    return colored_cloud;
 }
 
 /**
@@ -823,24 +1204,94 @@ PointCloudT::Ptr Clustering::label2color(
 PointLCloudT::Ptr Clustering::color2label(
         PointCloudT::Ptr colored_cloud) {
     PointLCloudT::Ptr label_cloud(new PointLCloudT);
-    pcl::PointCloud<PointLCT>::Ptr temp_cloud(new pcl::PointCloud<PointLCT>);
-    std::map<float, uint32_t> mappings;
-    copyPointCloud(*colored_cloud, *temp_cloud);
-
-    pcl::PointCloud<PointLCT>::iterator it = temp_cloud->begin();
-    pcl::PointCloud<PointLCT>::iterator it_end = temp_cloud->end();
+    color2label(*colored_cloud, *label_cloud);
+    return label_cloud;
+}
 
-    uint32_t i = 0;
-    for (; it != it_end; ++it) {
-        if (mappings.count(it->rgb) != 0)
-            it->label = mappings.at(it->rgb);
-        else {
-            it->label = i;
-            mappings.insert(std::pair<float, uint32_t>(it->rgb, i));
-            i++;
+/**
+ * Convert a pointcloud of any point type having a color field, with points 
+ * colored according to their labels, into a labelled pointcloud assigning a 
+ * label to all points having the same color, in a single pass; explicitly 
+ * instantiated for PointXYZRGB, PointXYZRGBA and PointXYZRGBL
+ *  
+ * @param colored_cloud a colored pointcloud
+ * @param label_cloud   the pointcloud in which the labelled pointcloud is 
+ *                      written
+ */
+template <typename PointColorT>
+void Clustering::color2label(const pcl::PointCloud<PointColorT> &colored_cloud,
+        PointLCloudT &label_cloud) {
+    label_cloud.resize(colored_cloud.size());
+    label_cloud.width = colored_cloud.width;
+    label_cloud.height = colored_cloud.height;
+    label_cloud.is_dense = colored_cloud.is_dense;
+
+    // Colors are compared as integers: as floats, half of the colors with 
+    // full alpha would be NaN, which can't be used as keys. Colors are mapped
+    // through an open-addressing table with linear probing, kept at most half
+    // full, whose empty slots have an invalid label. Points of the same 
+    // segment are mostly contiguous, so the last color is checked before the 
+    // table
+    const uint32_t empty = std::numeric_limits<uint32_t>::max();
+    size_t capacity = 64;
+    while (capacity < 2 * std::min<size_t>(colored_cloud.size(), 4096))
+        capacity *= 2;
+    std::vector<uint32_t> colors(capacity);
+    std::vector<uint32_t> labels(capacity, empty);
+    uint32_t n_labels = 0;
+    uint32_t last_rgba = 0;
+    uint32_t last_label = 0;
+    bool has_last = false;
+    for (size_t i = 0; i < colored_cloud.size(); ++i) {
+        const PointColorT &in = colored_cloud[i];
+        PointLT &out = label_cloud[i];
+        out.x = in.x;
+        out.y = in.y;
+        out.z = in.z;
+        if (!has_last || in.rgba != last_rgba) {
+            size_t slot = color_slot(in.rgba, capacity);
+            while (labels[slot] != empty && colors[slot] != in.rgba)
+                slot = (slot + 1) & (capacity - 1);
+            if (labels[slot] == empty) {
+                colors[slot] = in.rgba;
+                labels[slot] = n_labels++;
+                if (2 * n_labels > capacity) {
+                    // Rehash into a table twice as large
+                    std::vector<uint32_t> old_colors(2 * capacity);
+                    std::vector<uint32_t> old_labels(2 * capacity, empty);
+                    old_colors.swap(colors);
+                    old_labels.swap(labels);
+                    capacity *= 2;
+                    for (size_t j = 0; j < old_labels.size(); ++j) {
+                        if (old_labels[j] == empty)
+                            continue;
+                        size_t s = color_slot(old_colors[j], capacity);
+                        while (labels[s] != empty)
+                            s = (s + 1) & (capacity - 1);
+                        colors[s] = old_colors[j];
+                        labels[s] = old_labels[j];
+                    }
+                    slot = color_slot(in.rgba, capacity);
+                    while (colors[slot] != in.rgba || labels[slot] == empty)
+                        slot = (slot + 1) & (capacity - 1);
+                }
+            }
+            last_rgba = in.rgba;
+            last_label = labels[slot];
+            has_last = true;
         }
+        out.label = last_label;
     }
-
-    copyPointCloud(*temp_cloud, *label_cloud);
-    return label_cloud;
 }
+
+template void Clustering::label2color<pcl::PointXYZL>(
+        const pcl::PointCloud<pcl::PointXYZL> &, PointCloudT &, ThreadPool *);
+template void Clustering::label2color<pcl::PointXYZRGBL>(
+        const pcl::PointCloud<pcl::PointXYZRGBL> &, PointCloudT &,
+        ThreadPool *);
+template void Clustering::color2label<pcl::PointXYZRGB>(
+        const pcl::PointCloud<pcl::PointXYZRGB> &, PointLCloudT &);
+template void Clustering::color2label<pcl::PointXYZRGBA>(
+        const pcl::PointCloud<pcl::PointXYZRGBA> &, PointLCloudT &);
+template void Clustering::color2label<pcl::PointXYZRGBL>(
+        const pcl::PointCloud<pcl::PointXYZRGBL> &, PointLCloudT &);
@@ -47,25 +47,32 @@
  *              acceptable values
  * 
  * @return the converted color vector containing either three L*a*b* or three 
- *         RGB channels
+ *         RGB channels; it has to be freed by the caller with delete[]
  */
 float * ColorUtilities::color_conversion(float in[3], int code) {
-    float i1 = in[0];
-    float i2 = in[1];
-    float i3 = in[2];
-
-    cv::Mat in_m(1, 1, CV_32FC3, cv::Scalar(i1, i2, i3));
-    cv::Mat out_m(1, 1, CV_32FC3, cv::Scalar(0, 0, 0));
+    float * out = new float[3];
+    color_conversion(in, code, out);
+    return out;
+}
 
-    cv::cvtColor(in_m, out_m, code);
+/**
+ * Convert from one color space to another without allocating memory
+ * 
+ * @param in    a vector containing either three L*a*b* or three RGB channels
+ * @param code  color conversion code (see OpenCV cvtColor documentation for
+ *              acceptable values
+ * @param out   the converted color vector containing either three L*a*b* or 
+ *              three RGB channels
+ */
+void ColorUtilities::color_conversion(const float in[3], int code,
+        float out[3]) {
+    float in_data[3] = {in[0], in[1], in[2]};
 
-    cv::Vec3f out_v = out_m.at<cv::Vec3f>(0, 0);
-    float * out = new float[3];
-    out[0] = out_v[0];
-    out[1] = out_v[1];
-    out[2] = out_v[2];
+    // Both matrices wrap the given buffers, so OpenCV doesn't allocate them
+    cv::Mat in_m(1, 1, CV_32FC3, in_data);
+    cv::Mat out_m(1, 1, CV_32FC3, out);
 
-    return out;
+    cv::cvtColor(in_m, out_m, code);
 }
 
 /**
@@ -96,15 +103,52 @@ float ColorUtilities::ciede00_test(float L1, float a1, float b1, float L2,
  * 
  * @param label the label of the desired color
  * 
- * @return the color corresponding to the given label
+ * @return the color corresponding to the given label; it has to be freed by
+ *         the caller with delete[]
  */
 uint8_t * ColorUtilities::get_glasbey(uint32_t label) {
-    pcl::RGB color = pcl::GlasbeyLUT::at(label % pcl::GlasbeyLUT::size());
     uint8_t * rgb = new uint8_t[3];
+    get_glasbey(label, rgb);
+    return rgb;
+}
+
+/**
+ * Get the color corresponding to the given label in the Glasbey lookup table
+ * without allocating memory
+ * 
+ * @param label the label of the desired color
+ * @param rgb   the color corresponding to the given label
+ */
+void ColorUtilities::get_glasbey(uint32_t label, uint8_t rgb[3]) {
+    pcl::RGB color = pcl::GlasbeyLUT::at(label % pcl::GlasbeyLUT::size());
     rgb[0] = color.r;
     rgb[1] = color.g;
     rgb[2] = color.b;
-    return rgb;
+}
+
+/**
+ * Get the Glasbey lookup table as colors packed as in the rgba field of a 
+ * point, with full alpha; the table is packed only once, the first time it is
+ * requested, so that colorizing a cloud only takes one lookup per point
+ * 
+ * @return the packed Glasbey lookup table
+ */
+const std::vector<uint32_t> & ColorUtilities::glasbey_table() {
+    struct packer {
+        static std::vector<uint32_t> pack() {
+            std::vector<uint32_t> table(pcl::GlasbeyLUT::size());
+            for (size_t i = 0; i < table.size(); ++i) {
+                pcl::RGB color = pcl::GlasbeyLUT::at(i);
+                table[i] = (static_cast<uint32_t> (255) << 24)
+                        | (static_cast<uint32_t> (color.r) << 16)
+                        | (static_cast<uint32_t> (color.g) << 8)
+                        | static_cast<uint32_t> (color.b);
+            }
+            return table;
+        }
+    };
+    static const std::vector<uint32_t> table = packer::pack();
+    return table;
 }
 
 /**
@@ -112,9 +156,22 @@ uint8_t * ColorUtilities::get_glasbey(uint32_t label) {
  * 
  * @param s a segmentation region
  * 
- * @return the mean color of all points as an array of RGB values
+ * @return the mean color of all points as an array of RGB values; it has to 
+ *         be freed by the caller with delete[]
  */
 float * ColorUtilities::mean_color(SupervoxelT::Ptr s) {
+    float * mean = new float[3];
+    mean_color(s, mean);
+    return mean;
+}
+
+/**
+ * Compute the mean color of all points in a region without allocating memory
+ * 
+ * @param s     a segmentation region
+ * @param mean  the mean color of all points as an array of RGB values
+ */
+void ColorUtilities::mean_color(SupervoxelT::Ptr s, float mean[3]) {
     pcl::PointCloud<PointT>::Ptr v = s->voxels_;
     pcl::PointCloud<PointT>::iterator v_itr, v_itr_end;
     v_itr = v->begin();
@@ -133,12 +190,9 @@ float * ColorUtilities::mean_color(SupervoxelT::Ptr s) {
         mean_g = mean_g + (1 / count) * (g - mean_g);
         mean_b = mean_b + (1 / count) * (b - mean_b);
     }
-    float * mean = new float[3];
     mean[0] = mean_r;
     mean[1] = mean_g;
     mean[2] = mean_b;
-
-    return mean;
 }
 
 /**
@@ -146,17 +200,28 @@ float * ColorUtilities::mean_color(SupervoxelT::Ptr s) {
  * 
  * @param rgb   the RGB color to be converted
  * 
- * @return the corresponding L*a*b* color to the given RGB color
+ * @return the corresponding L*a*b* color to the given RGB color; it has to be
+ *         freed by the caller with delete[]
  */
 float * ColorUtilities::rgb2lab(float rgb[3]) {
+    float * lab = new float[3];
+    rgb2lab(rgb, lab);
+    return lab;
+}
+
+/**
+ * Convert RGB colors to L*a*b* color space without allocating memory
+ * 
+ * @param rgb   the RGB color to be converted
+ * @param lab   the corresponding L*a*b* color to the given RGB color
+ */
+void ColorUtilities::rgb2lab(const float rgb[3], float lab[3]) {
     float rgb2[3];
     rgb2[0] = rgb[0] / 255;
     rgb2[1] = rgb[1] / 255;
     rgb2[2] = rgb[2] / 255;
 
-    float * lab = color_conversion(rgb2, cv::COLOR_RGB2Lab);
-
-    return lab;
+    color_conversion(rgb2, cv::COLOR_RGB2Lab, lab);
 }
 
 /**
@@ -164,16 +229,27 @@ float * ColorUtilities::rgb2lab(float rgb[3]) {
  * 
  * @param lab   the L*a*b* color to be converted
  * 
- * @return the corresponding RGB color to the given L*a*b* color
+ * @return the corresponding RGB color to the given L*a*b* color; it has to be
+ *         freed by the caller with delete[]
  */
 float * ColorUtilities::lab2rgb(float lab[3]) {
-    float * rgb = color_conversion(lab, cv::COLOR_Lab2RGB);
+    float * rgb = new float[3];
+    lab2rgb(lab, rgb);
+    return rgb;
+}
+
+/**
+ * Convert L*a*b* colors to RGB color space without allocating memory
+ * 
+ * @param lab   the L*a*b* color to be converted
+ * @param rgb   the corresponding RGB color to the given L*a*b* color
+ */
+void ColorUtilities::lab2rgb(const float lab[3], float rgb[3]) {
+    color_conversion(lab, cv::COLOR_Lab2RGB, rgb);
 
     rgb[0] *= 255;
     rgb[1] *= 255;
     rgb[2] *= 255;
-
-    return rgb;
 }
 
 /**
@@ -466,32 +542,36 @@ void ColorUtilities::convert_test() {
     pcl::console::print_info("Performing RGB-LAB Conversion test...\n");
     
     float rgb1[] = {123, 10, 200};
-    float * lab1 = rgb2lab(rgb1);
-    float * rgb1c = lab2rgb(lab1);
+    float lab1[3], rgb1c[3];
+    rgb2lab(rgb1, lab1);
+    lab2rgb(lab1, rgb1c);
     pcl::console::print_debug(
             "rgb[%f, %f, %f]\t=>\tlab[%f, %f, %f]\t=>\trgb[%f, %f, %f]\n",
             rgb1[0], rgb1[1], rgb1[2], lab1[0], lab1[1], lab1[2], rgb1c[0],
             rgb1c[1], rgb1c[2]);
     
     float rgb2[] = {0, 0, 0};
-    float * lab2 = rgb2lab(rgb2);
-    float * rgb2c = lab2rgb(lab2);
+    float lab2[3], rgb2c[3];
+    rgb2lab(rgb2, lab2);
+    lab2rgb(lab2, rgb2c);
     pcl::console::print_debug(
             "rgb[%f, %f, %f]\t=>\tlab[%f, %f, %f]\t=>\trgb[%f, %f, %f]\n",
             rgb2[0], rgb2[1], rgb2[2], lab2[0], lab2[1], lab2[2], rgb2c[0],
             rgb2c[1], rgb2c[2]);
     
     float rgb3[] = {255, 255, 255};
-    float * lab3 = rgb2lab(rgb3);
-    float * rgb3c = lab2rgb(lab3);
+    float lab3[3], rgb3c[3];
+    rgb2lab(rgb3, lab3);
+    lab2rgb(lab3, rgb3c);
     pcl::console::print_debug(
             "rgb[%f, %f, %f]\t=>\tlab[%f, %f, %f]\t=>\trgb[%f, %f, %f]\n",
             rgb3[0], rgb3[1], rgb3[2], lab3[0], lab3[1], lab3[2], rgb3c[0],
             rgb3c[1], rgb3c[2]);
     
     float rgb4[] = {255, 255, 0};
-    float * lab4 = rgb2lab(rgb4);
-    float * rgb4c = lab2rgb(lab4);
+    float lab4[3], rgb4c[3];
+    rgb2lab(rgb4, lab4);
+    lab2rgb(lab4, rgb4c);
     pcl::console::print_debug(
             "rgb[%f, %f, %f]\t=>\tlab[%f, %f, %f]\t=>\trgb[%f, %f, %f]\n",
             rgb4[0], rgb4[1], rgb4[2], lab4[0], lab4[1], lab4[2], rgb4c[0],
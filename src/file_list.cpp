@@ -0,0 +1,111 @@
+/*
+ * file_list.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cctype>
+
+#include "supervoxel_clustering/file_list.h"
+
+/**
+ * Check if a character is a decimal digit
+ * 
+ * @param c the character
+ * 
+ * @return true if the character is a digit
+ */
+static bool is_digit(char c) {
+    return std::isdigit(static_cast<unsigned char> (c)) != 0;
+}
+
+/**
+ * Compare two strings in natural order: runs of digits are compared by their
+ * numeric value, any other character by its code; strings equal in natural 
+ * order (e.g. differing only by leading zeros) are compared character by 
+ * character
+ * 
+ * @param a the first string
+ * @param b the second string
+ * 
+ * @return true if the first string comes before the second one
+ */
+bool FileList::natural_less(const std::string &a, const std::string &b) {
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (is_digit(a[i]) && is_digit(b[j])) {
+            size_t a_start = i, b_start = j;
+            while (a_start < a.size() - 1 && a[a_start] == '0'
+                    && is_digit(a[a_start + 1]))
+                ++a_start;
+            while (b_start < b.size() - 1 && b[b_start] == '0'
+                    && is_digit(b[b_start + 1]))
+                ++b_start;
+            size_t a_end = a_start, b_end = b_start;
+            while (a_end < a.size() && is_digit(a[a_end]))
+                ++a_end;
+            while (b_end < b.size() && is_digit(b[b_end]))
+                ++b_end;
+            // Without leading zeros, a longer run is a larger number
+            if (a_end - a_start != b_end - b_start)
+                return a_end - a_start < b_end - b_start;
+            int c = a.compare(a_start, a_end - a_start, b, b_start,
+                    b_end - b_start);
+            if (c != 0)
+                return c < 0;
+            i = a_end;
+            j = b_end;
+        } else {
+            if (a[i] != b[j])
+                return a[i] < b[j];
+            ++i;
+            ++j;
+        }
+    }
+    if (i < a.size() || j < b.size())
+        return a.size() - i < b.size() - j;
+    return a < b;
+}
+
+/**
+ * Sort a list of files in natural order
+ * 
+ * @param files the list of files
+ */
+void FileList::sort(std::vector<std::string> &files) {
+    std::sort(files.begin(), files.end(), natural_less);
+}
@@ -0,0 +1,108 @@
+/*
+ * hierarchy_extract.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <pcl/common/time.h>
+#include <pcl/console/print.h>
+#include <pcl/io/pcd_io.h>
+
+#include "supervoxel_clustering/hierarchy_file.h"
+
+using namespace pcl;
+
+int main(int argc, char ** argv) {
+    if (argc != 2 && argc != 4) {
+        console::print_info(
+                "Syntax is: "
+                "%s <hierarchy-file> [<threshold> <output-pcd-file>]\n"
+                "\n\tSaves the labelled voxels of the segmentation at the "
+                "given threshold; if no threshold is given, prints a summary "
+                "of the hierarchy\n", argv[0]);
+        return (1);
+    }
+
+    try {
+        HierarchyFile hierarchy(argv[1]);
+
+        if (argc == 2) {
+            console::print_info("Supervoxels: %zu, voxels: %zu, merges: %zu\n",
+                    hierarchy.get_segments_num(), hierarchy.get_voxels_num(),
+                    hierarchy.get_merges_num());
+            if (hierarchy.get_merges_num() > 0) {
+                // Weights are not monotonic, as merged regions get new ones
+                float min_weight = hierarchy.get_merge(0).weight;
+                float max_weight = min_weight;
+                for (size_t m = 1; m < hierarchy.get_merges_num(); ++m) {
+                    min_weight = std::min(min_weight,
+                            hierarchy.get_merge(m).weight);
+                    max_weight = std::max(max_weight,
+                            hierarchy.get_merge(m).weight);
+                }
+                console::print_info("Merge weights: from %f to %f\n",
+                        min_weight, max_weight);
+            }
+            return (0);
+        }
+
+        float threshold = std::atof(argv[2]);
+        PointLCloudT label_cloud;
+        StopWatch timer;
+        hierarchy.extract(threshold, label_cloud);
+        double time = timer.getTime();
+        uint32_t regions = 0;
+        for (size_t i = 0; i < label_cloud.size(); ++i)
+            regions = std::max(regions, label_cloud[i].label + 1);
+        console::print_info("Threshold %f: %u regions, extracted in %f ms\n",
+                threshold, regions, time);
+
+        if (pcl::io::savePCDFileBinary(argv[3], label_cloud) < 0) {
+            console::print_error("Cannot save %s\n", argv[3]);
+            return (1);
+        }
+    } catch (std::exception &e) {
+        console::print_error("%s\n", e.what());
+        return (1);
+    }
+
+    return (0);
+}
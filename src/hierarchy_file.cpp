@@ -0,0 +1,309 @@
+/*
+ * hierarchy_file.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "supervoxel_clustering/hierarchy_file.h"
+
+/**
+ * Compute the size of the array of labels, padded so that the following 
+ * arrays stay aligned
+ * 
+ * @param segments  the number of initial supervoxels
+ * 
+ * @return the size of the array in bytes
+ */
+static size_t labels_size(uint64_t segments) {
+    return (segments * sizeof (uint32_t) + 7) / 8 * 8;
+}
+
+/**
+ * Compute the size of a hierarchy file
+ * 
+ * @param segments  the number of initial supervoxels
+ * @param voxels    the number of voxels
+ * @param merges    the number of merges
+ * 
+ * @return the size of the file in bytes
+ */
+static size_t file_size(uint64_t segments, uint64_t voxels,
+        uint64_t merges) {
+    return sizeof (hierarchyHeader) + (segments + 1) * sizeof (uint64_t)
+            + labels_size(segments) + voxels * sizeof (hierarchyVoxel)
+            + merges * sizeof (hierarchyMerge);
+}
+
+/**
+ * Find the region an initial segment belongs to, compressing the path
+ * 
+ * @param parent    the parent of each initial segment, the root of each 
+ *                  region being its own parent
+ * @param i         the index of the initial segment
+ * 
+ * @return the index of the initial segment at the root of its region
+ */
+static uint32_t find_root(std::vector<uint32_t> &parent, uint32_t i) {
+    uint32_t root = i;
+    while (parent[root] != root)
+        root = parent[root];
+    while (parent[i] != root) {
+        uint32_t next = parent[i];
+        parent[i] = root;
+        i = next;
+    }
+    return root;
+}
+
+/**
+ * Constructor for the HierarchyFile class, mapping a hierarchy file in memory
+ * 
+ * @param filename  the name of the hierarchy file
+ */
+HierarchyFile::HierarchyFile(std::string filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open hierarchy file '" + filename
+            + "': " + std::strerror(errno));
+    struct stat info;
+    if (fstat(fd, &info) < 0
+            || (size_t) info.st_size < sizeof (hierarchyHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid hierarchy file '" + filename + "'");
+    }
+    size = info.st_size;
+    memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+        throw std::runtime_error("Cannot map hierarchy file '" + filename
+            + "': " + std::strerror(errno));
+
+    header = static_cast<const hierarchyHeader *> (memory);
+    if (header->magic != HIERARCHY_MAGIC
+            || header->version != HIERARCHY_VERSION
+            || size != file_size(header->segments, header->voxels,
+            header->merges)) {
+        munmap(memory, size);
+        throw std::runtime_error("Invalid hierarchy file '" + filename + "'");
+    }
+    const char *data = static_cast<const char *> (memory)
+            + sizeof (hierarchyHeader);
+    offsets = reinterpret_cast<const uint64_t *> (data);
+    data += (header->segments + 1) * sizeof (uint64_t);
+    labels = reinterpret_cast<const uint32_t *> (data);
+    data += labels_size(header->segments);
+    voxels = reinterpret_cast<const hierarchyVoxel *> (data);
+    data += header->voxels * sizeof (hierarchyVoxel);
+    merges = reinterpret_cast<const hierarchyMerge *> (data);
+
+    for (size_t i = 0; i < header->merges; ++i)
+        if (merges[i].first >= header->segments
+                || merges[i].second >= header->segments) {
+            munmap(memory, size);
+            throw std::runtime_error("Invalid hierarchy file '" + filename
+                + "'");
+        }
+    // The voxels of each segment are read through the offsets, so they must
+    // all lie within the voxels of the file
+    bool valid_offsets = offsets[0] == 0
+            && offsets[header->segments] == header->voxels;
+    for (size_t i = 0; i < header->segments && valid_offsets; ++i)
+        valid_offsets = offsets[i] <= offsets[i + 1]
+            && offsets[i + 1] <= header->voxels;
+    if (!valid_offsets) {
+        munmap(memory, size);
+        throw std::runtime_error("Invalid hierarchy file '" + filename + "'");
+    }
+}
+
+/**
+ * Destructor for the HierarchyFile class
+ */
+HierarchyFile::~HierarchyFile() {
+    munmap(memory, size);
+}
+
+/**
+ * Cut the hierarchy at a threshold
+ * 
+ * @param threshold         the threshold
+ * @param segment_labels    filled with the label of the region of each initial
+ *                          supervoxel; regions are labelled from 0, in the 
+ *                          order of their smallest initial supervoxel, as in
+ *                          the labelled clouds of the Clustering class
+ * 
+ * @return the number of regions
+ */
+size_t HierarchyFile::cut(float threshold,
+        std::vector<uint32_t> &segment_labels) const {
+    uint32_t segments = header->segments;
+    std::vector<uint32_t> parent(segments);
+    for (uint32_t i = 0; i < segments; ++i)
+        parent[i] = i;
+    for (size_t m = 0; m < header->merges && merges[m].weight < threshold;
+            ++m)
+        parent[find_root(parent, merges[m].second)] =
+            find_root(parent, merges[m].first);
+
+    // A region keeps the label of its root segment, so regions are labelled 
+    // in the order of their roots
+    segment_labels.resize(segments);
+    uint32_t regions = 0;
+    for (uint32_t i = 0; i < segments; ++i)
+        if (find_root(parent, i) == i)
+            segment_labels[i] = regions++;
+    for (uint32_t i = 0; i < segments; ++i)
+        segment_labels[i] = segment_labels[parent[i]];
+    return regions;
+}
+
+/**
+ * Get the labelled voxel cloud of the segmentation at a threshold
+ * 
+ * @param threshold     the threshold
+ * @param label_cloud   the pointcloud in which the labelled voxels are written
+ */
+void HierarchyFile::extract(float threshold,
+        PointLCloudT &label_cloud) const {
+    std::vector<uint32_t> segment_labels;
+    cut(threshold, segment_labels);
+
+    label_cloud.resize(header->voxels);
+    for (uint32_t s = 0; s < header->segments; ++s)
+        for (uint64_t v = offsets[s]; v < offsets[s + 1]; ++v) {
+            PointLT &p = label_cloud[v];
+            p.x = voxels[v].x;
+            p.y = voxels[v].y;
+            p.z = voxels[v].z;
+            p.label = segment_labels[s];
+        }
+    label_cloud.width = header->voxels;
+    label_cloud.height = 1;
+}
+
+/**
+ * Save the hierarchy of a clustering in a hierarchy file
+ * 
+ * @param filename          the name of the hierarchy file
+ * @param initial_state     the initial state of the clustering
+ * @param merge_sequence    the weight and the labels of the regions of each
+ *                          merge, in the order they were performed
+ */
+void HierarchyFile::save(std::string filename,
+        const ClusteringState &initial_state,
+        const std::vector<WeightedPairT> &merge_sequence) {
+    ClusteringT segments = initial_state.get_segments();
+
+    hierarchyHeader h;
+    h.magic = HIERARCHY_MAGIC;
+    h.version = HIERARCHY_VERSION;
+    h.segments = segments.size();
+    h.padding = 0;
+    h.voxels = 0;
+    h.merges = merge_sequence.size();
+
+    std::vector<uint64_t> file_offsets;
+    std::vector<uint32_t> file_labels;
+    file_offsets.reserve(segments.size() + 1);
+    file_labels.reserve(segments.size());
+    ClusteringT::const_iterator it = segments.begin();
+    for (; it != segments.end(); ++it) {
+        file_offsets.push_back(h.voxels);
+        file_labels.push_back(it->first);
+        h.voxels += it->second->voxels_->size();
+    }
+    file_offsets.push_back(h.voxels);
+    file_labels.resize(labels_size(h.segments) / sizeof (uint32_t), 0);
+
+    std::vector<hierarchyMerge> file_merges(merge_sequence.size());
+    for (size_t m = 0; m < merge_sequence.size(); ++m) {
+        // Labels are stored in increasing order, so they are found by 
+        // binary search among the real ones
+        std::vector<uint32_t>::iterator end =
+                file_labels.begin() + h.segments;
+        std::vector<uint32_t>::iterator first = std::lower_bound(
+                file_labels.begin(), end, merge_sequence[m].second.first);
+        std::vector<uint32_t>::iterator second = std::lower_bound(
+                file_labels.begin(), end, merge_sequence[m].second.second);
+        if (first == end || *first != merge_sequence[m].second.first
+                || second == end || *second != merge_sequence[m].second.second)
+            throw std::invalid_argument("Merge of a region not in the initial "
+                "state");
+        file_merges[m].weight = merge_sequence[m].first;
+        file_merges[m].first = first - file_labels.begin();
+        file_merges[m].second = second - file_labels.begin();
+    }
+
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("Cannot create hierarchy file '" + filename
+            + "'");
+    file.write(reinterpret_cast<const char *> (&h), sizeof (h));
+    file.write(reinterpret_cast<const char *> (&file_offsets[0]),
+            file_offsets.size() * sizeof (uint64_t));
+    if (!file_labels.empty())
+        file.write(reinterpret_cast<const char *> (&file_labels[0]),
+                file_labels.size() * sizeof (uint32_t));
+    hierarchyVoxel v;
+    for (it = segments.begin(); it != segments.end(); ++it) {
+        pcl::PointCloud<PointT>::const_iterator p_it = it->second->voxels_->begin();
+        for (; p_it != it->second->voxels_->end(); ++p_it) {
+            v.x = p_it->x;
+            v.y = p_it->y;
+            v.z = p_it->z;
+            file.write(reinterpret_cast<const char *> (&v), sizeof (v));
+        }
+    }
+    if (!file_merges.empty())
+        file.write(reinterpret_cast<const char *> (&file_merges[0]),
+                file_merges.size() * sizeof (hierarchyMerge));
+    file.close();
+    if (file.fail())
+        throw std::runtime_error("Cannot write hierarchy file '" + filename
+            + "'");
+}
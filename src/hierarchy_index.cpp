@@ -0,0 +1,291 @@
+/*
+ * hierarchy_index.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include "supervoxel_clustering/hierarchy_index.h"
+#include "supervoxel_clustering/task_graph.h"
+
+/**
+ * Constructor for the HierarchyIndex class, indexing a hierarchy file
+ * 
+ * @param file  the hierarchy file
+ */
+HierarchyIndex::HierarchyIndex(const HierarchyFile &file) :
+pool(NULL) {
+    std::vector<uint32_t> segment_labels(file.get_segments_num());
+    std::vector<uint64_t> offsets(file.get_segments_num() + 1);
+    for (size_t s = 0; s < segment_labels.size(); ++s) {
+        segment_labels[s] = file.get_label(s);
+        offsets[s] = file.get_offset(s);
+    }
+    offsets.back() = file.get_offset(segment_labels.size());
+    std::vector<hierarchyMerge> merges(file.get_merges_num());
+    for (size_t m = 0; m < merges.size(); ++m)
+        merges[m] = file.get_merge(m);
+    build(segment_labels, offsets, merges);
+}
+
+/**
+ * Constructor for the HierarchyIndex class, indexing the hierarchy of a 
+ * clustering
+ * 
+ * @param initial_state     the initial state of the clustering
+ * @param merge_sequence    the weight and the labels of the regions of each
+ *                          merge, in the order they were performed, as given
+ *                          by Clustering::run
+ */
+HierarchyIndex::HierarchyIndex(const ClusteringState &initial_state,
+        const std::vector<WeightedPairT> &merge_sequence) :
+pool(NULL) {
+    ClusteringT segments = initial_state.get_segments();
+    std::vector<uint32_t> segment_labels;
+    std::vector<uint64_t> offsets(1, 0);
+    segment_labels.reserve(segments.size());
+    offsets.reserve(segments.size() + 1);
+    ClusteringT::const_iterator it = segments.begin();
+    for (; it != segments.end(); ++it) {
+        segment_labels.push_back(it->first);
+        offsets.push_back(offsets.back() + it->second->voxels_->size());
+    }
+
+    std::vector<hierarchyMerge> merges(merge_sequence.size());
+    for (size_t m = 0; m < merge_sequence.size(); ++m) {
+        std::vector<uint32_t>::iterator first = std::lower_bound(
+                segment_labels.begin(), segment_labels.end(),
+                merge_sequence[m].second.first);
+        std::vector<uint32_t>::iterator second = std::lower_bound(
+                segment_labels.begin(), segment_labels.end(),
+                merge_sequence[m].second.second);
+        if (first == segment_labels.end()
+                || *first != merge_sequence[m].second.first
+                || second == segment_labels.end()
+                || *second != merge_sequence[m].second.second)
+            throw std::invalid_argument("Merge of a region not in the initial "
+                "state");
+        merges[m].weight = merge_sequence[m].first;
+        merges[m].first = first - segment_labels.begin();
+        merges[m].second = second - segment_labels.begin();
+    }
+    build(segment_labels, offsets, merges);
+}
+
+/**
+ * Build the merge tree and its ancestor tables
+ * 
+ * @param segment_labels    the labels of the initial supervoxels
+ * @param offsets           the voxels of supervoxel i are those in 
+ *                          [offsets[i], offsets[i + 1])
+ * @param merges            the merges, in the order they were performed
+ */
+void HierarchyIndex::build(const std::vector<uint32_t> &segment_labels,
+        const std::vector<uint64_t> &offsets,
+        const std::vector<hierarchyMerge> &merges) {
+    labels = segment_labels;
+    segments_num = labels.size();
+    nodes_num = segments_num + merges.size();
+
+    voxel_segments.resize(offsets.back());
+    for (size_t s = 0; s < segments_num; ++s)
+        std::fill(voxel_segments.begin() + offsets[s],
+                voxel_segments.begin() + offsets[s + 1], s);
+
+    max_weights.resize(merges.size());
+    for (size_t m = 0; m < merges.size(); ++m)
+        max_weights[m] = (m == 0) ? merges[m].weight
+            : std::max(max_weights[m - 1], merges[m].weight);
+
+    // Node i < segments_num is a supervoxel, node segments_num + m is the 
+    // region made by merge m; each node knows the merge that created it 
+    // (merge m is stored as m + 1, supervoxels as 0) and the current node of
+    // each supervoxel is tracked while the merges are replayed
+    std::vector<uint32_t> parents(nodes_num);
+    node_merges.assign(nodes_num, 0);
+    node_labels.resize(nodes_num);
+    std::vector<uint32_t> current(segments_num);
+    for (size_t s = 0; s < segments_num; ++s) {
+        parents[s] = s;
+        node_labels[s] = labels[s];
+        current[s] = s;
+    }
+    for (size_t m = 0; m < merges.size(); ++m) {
+        uint32_t node = segments_num + m;
+        uint32_t first = current[merges[m].first];
+        uint32_t second = current[merges[m].second];
+        if (first == node || second == node || first == second)
+            throw std::invalid_argument("Invalid merge sequence");
+        parents[node] = node;
+        parents[first] = parents[second] = node;
+        node_merges[node] = m + 1;
+        node_labels[node] = labels[merges[m].first];
+        current[merges[m].first] = node;
+        // The region keeps the label of first, so it is found from first 
+        // from now on, while second is never used again
+        current[merges[m].second] = node;
+    }
+
+    levels = 1;
+    while (((size_t) 1 << levels) < nodes_num)
+        levels++;
+    ancestors.resize(levels * nodes_num);
+    std::copy(parents.begin(), parents.end(), ancestors.begin());
+    for (size_t j = 1; j < levels; ++j) {
+        uint32_t *up = &ancestors[j * nodes_num];
+        const uint32_t *half = &ancestors[(j - 1) * nodes_num];
+        for (size_t n = 0; n < nodes_num; ++n)
+            up[n] = half[half[n]];
+    }
+}
+
+/**
+ * Get the number of merges performed by a clustering at a threshold
+ * 
+ * @param threshold the threshold
+ * 
+ * @return the number of merges
+ */
+size_t HierarchyIndex::merges_below(float threshold) const {
+    return std::lower_bound(max_weights.begin(), max_weights.end(), threshold)
+            - max_weights.begin();
+}
+
+/**
+ * Get the region a node of the merge tree belongs to after a number of merges
+ * 
+ * @param node      the node, a supervoxel if below get_segments_num()
+ * @param merges    the number of merges performed
+ * 
+ * @return the node of the region
+ */
+uint32_t HierarchyIndex::ancestor(size_t node, size_t merges) const {
+    uint32_t n = node;
+    // Ancestors are created by later merges, so the wanted one is the highest
+    // created by one of the first 'merges' merges
+    for (size_t j = levels; j-- > 0;) {
+        uint32_t up = ancestors[j * nodes_num + n];
+        if (node_merges[up] <= merges)
+            n = up;
+    }
+    return n;
+}
+
+/**
+ * Get the region of a supervoxel at a threshold
+ * 
+ * @param segment   the index of the supervoxel, in [0, get_segments_num())
+ * @param threshold the threshold
+ * 
+ * @return the label of the region
+ */
+uint32_t HierarchyIndex::segment_region(size_t segment,
+        float threshold) const {
+    return node_labels[ancestor(segment, merges_below(threshold))];
+}
+
+/**
+ * Get the region of a voxel at a threshold
+ * 
+ * @param voxel     the index of the voxel, in [0, get_voxels_num())
+ * @param threshold the threshold
+ * 
+ * @return the label of the region
+ */
+uint32_t HierarchyIndex::voxel_region(size_t voxel, float threshold) const {
+    return segment_region(voxel_segments[voxel], threshold);
+}
+
+/**
+ * Answer a range of a batch of voxel queries
+ * 
+ * @param voxels    the indices of the voxels
+ * @param merges    the number of merges performed
+ * @param regions   the labels of the regions, filled for the range
+ * @param begin     the first query of the range
+ * @param end       the query after the last one of the range
+ */
+void HierarchyIndex::query_range(const std::vector<size_t> *voxels,
+        size_t merges, std::vector<uint32_t> *regions, size_t begin,
+        size_t end) const {
+    for (size_t i = begin; i < end; ++i)
+        (*regions)[i] = node_labels[ancestor(
+                voxel_segments[(*voxels)[i]], merges)];
+}
+
+/**
+ * Get the regions of many voxels at a threshold; if a thread pool is set, the
+ * queries are answered in parallel
+ * 
+ * @param voxels    the indices of the voxels
+ * @param threshold the threshold
+ * @param regions   the vector in which the label of the region of each voxel
+ *                  is written
+ */
+void HierarchyIndex::voxel_regions(const std::vector<size_t> &voxels,
+        float threshold, std::vector<uint32_t> &regions) const {
+    size_t merges = merges_below(threshold);
+    regions.resize(voxels.size());
+    size_t chunks = (pool) ? 4 * pool->size() : 1;
+    size_t chunk_size = std::max<size_t>(1024,
+            (voxels.size() + chunks - 1) / chunks);
+    if (voxels.size() <= chunk_size) {
+        query_range(&voxels, merges, &regions, 0, voxels.size());
+        return;
+    }
+    TaskGraph graph(pool);
+    for (size_t begin = 0; begin < voxels.size(); begin += chunk_size)
+        graph.add_task("queries", boost::bind(&HierarchyIndex::query_range,
+            this, &voxels, merges, &regions, begin,
+            std::min(begin + chunk_size, voxels.size())));
+    graph.run();
+}
+
+/**
+ * Get the number of regions at a threshold
+ * 
+ * @param threshold the threshold
+ * 
+ * @return the number of regions
+ */
+size_t HierarchyIndex::regions_num(float threshold) const {
+    return segments_num - merges_below(threshold);
+}
@@ -0,0 +1,320 @@
+/*
+ * label_file.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <pcl/console/print.h>
+
+#include "supervoxel_clustering/label_file.h"
+
+/**
+ * Append a value to a buffer as an unsigned LEB128 varint
+ * 
+ * @param value the value
+ * @param data  the buffer
+ */
+static void put_varint(uint64_t value, std::vector<uint8_t> &data) {
+    while (value >= 0x80) {
+        data.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    data.push_back((uint8_t) value);
+}
+
+/**
+ * Read an unsigned LEB128 varint from a buffer
+ * 
+ * @param data  the position in the buffer, moved after the value
+ * @param end   the end of the buffer
+ * @param value the value read
+ * 
+ * @return true if a whole value was read
+ */
+static bool get_varint(const uint8_t *&data, const uint8_t *end,
+        uint64_t &value) {
+    value = 0;
+    for (int shift = 0; data < end && shift < 64; shift += 7) {
+        uint8_t byte = *(data++);
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Constructor for the LabelFile class, mapping a label file in memory
+ * 
+ * @param filename  the name of the label file
+ */
+LabelFile::LabelFile(std::string filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open label file '" + filename
+            + "': " + std::strerror(errno));
+    struct stat info;
+    if (fstat(fd, &info) < 0
+            || (size_t) info.st_size < sizeof (labelHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid label file '" + filename + "'");
+    }
+    size = info.st_size;
+    memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+        throw std::runtime_error("Cannot map label file '" + filename
+            + "': " + std::strerror(errno));
+
+    header = static_cast<const labelHeader *> (memory);
+    data = static_cast<const uint8_t *> (memory) + sizeof (labelHeader);
+    if (header->magic != LABEL_MAGIC || header->version != LABEL_VERSION
+            || size != sizeof (labelHeader) + header->data_size
+            || (header->encoding == RAW_LABELS
+            && header->data_size != header->points * sizeof (uint32_t))
+            || header->encoding > RLE_LABELS) {
+        munmap(memory, size);
+        throw std::runtime_error("Invalid label file '" + filename + "'");
+    }
+}
+
+/**
+ * Destructor for the LabelFile class
+ */
+LabelFile::~LabelFile() {
+    munmap(memory, size);
+}
+
+/**
+ * Get the labels of all points, decoding them if needed
+ * 
+ * @param labels    the vector in which the labels are written
+ */
+void LabelFile::get_labels(std::vector<uint32_t> &labels) const {
+    if (header->encoding == RAW_LABELS) {
+        const uint32_t *raw = get_raw_labels();
+        labels.assign(raw, raw + header->points);
+        return;
+    }
+    labels.clear();
+    labels.reserve(header->points);
+    const uint8_t *it = data;
+    const uint8_t *end = data + header->data_size;
+    uint64_t run, label;
+    while (it < end) {
+        if (!get_varint(it, end, run) || !get_varint(it, end, label)
+                || run > header->points - labels.size())
+            throw std::runtime_error("Corrupted label file");
+        labels.insert(labels.end(), run, (uint32_t) label);
+    }
+    if (labels.size() != header->points)
+        throw std::runtime_error("Corrupted label file");
+}
+
+/**
+ * Encode the labels of a pointcloud
+ * 
+ * @param labels    the label of each point
+ * @param encoding  the encoding
+ * @param data      the buffer in which the encoded labels are written
+ */
+void LabelFile::encode(const std::vector<uint32_t> &labels,
+        LabelEncoding encoding, std::vector<uint8_t> &data) {
+    data.clear();
+    if (encoding == RAW_LABELS) {
+        const uint8_t *raw = reinterpret_cast<const uint8_t *> (labels.data());
+        data.assign(raw, raw + labels.size() * sizeof (uint32_t));
+        return;
+    }
+    size_t i = 0;
+    while (i < labels.size()) {
+        size_t j = i + 1;
+        while (j < labels.size() && labels[j] == labels[i])
+            ++j;
+        put_varint(j - i, data);
+        put_varint(labels[i], data);
+        i = j;
+    }
+}
+
+/**
+ * Save the labels of a pointcloud in a label file
+ * 
+ * @param filename  the name of the label file
+ * @param labels    the label of each point
+ * @param encoding  the encoding of the labels
+ */
+void LabelFile::save(std::string filename, const std::vector<uint32_t> &labels,
+        LabelEncoding encoding) {
+    std::vector<uint8_t> data;
+    encode(labels, encoding, data);
+
+    labelHeader h;
+    h.magic = LABEL_MAGIC;
+    h.version = LABEL_VERSION;
+    h.encoding = encoding;
+    h.padding = 0;
+    h.points = labels.size();
+    h.data_size = data.size();
+
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("Cannot create label file '" + filename
+            + "'");
+    file.write(reinterpret_cast<const char *> (&h), sizeof (h));
+    if (!data.empty())
+        file.write(reinterpret_cast<const char *> (&data[0]), data.size());
+    file.close();
+    if (file.fail())
+        throw std::runtime_error("Cannot write label file '" + filename + "'");
+}
+
+/**
+ * Constructor for the LabelWriter class, starting the writing thread
+ * 
+ * @param e the encoding of the files written
+ */
+LabelWriter::LabelWriter(LabelEncoding e) :
+encoding(e), stopping(false), writing(false), written(0), failed(0) {
+    thread = boost::thread(&LabelWriter::work, this);
+}
+
+/**
+ * Destructor for the LabelWriter class, writing all queued files before
+ * stopping the writing thread
+ */
+LabelWriter::~LabelWriter() {
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stopping = true;
+    }
+    job_available.notify_all();
+    thread.join();
+}
+
+/**
+ * Loop of the writing thread
+ */
+void LabelWriter::work() {
+    while (true) {
+        labelJob job;
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            while (jobs.empty() && !stopping)
+                job_available.wait(lock);
+            if (jobs.empty())
+                return;
+            job = jobs.front();
+            jobs.pop_front();
+            writing = true;
+        }
+        bool ok = true;
+        try {
+            LabelFile::save(job.filename, *job.labels, encoding);
+        } catch (std::exception &e) {
+            pcl::console::print_error("%s\n", e.what());
+            ok = false;
+        }
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            writing = false;
+            if (ok)
+                written++;
+            else
+                failed++;
+        }
+        job_done.notify_all();
+    }
+}
+
+/**
+ * Queue the labels of a pointcloud to be saved; the call returns immediately
+ * 
+ * @param filename  the name of the label file
+ * @param labels    the label of each point, which must not be modified 
+ *                  afterwards
+ */
+void LabelWriter::write(std::string filename,
+        boost::shared_ptr<std::vector<uint32_t> > labels) {
+    labelJob job;
+    job.filename = filename;
+    job.labels = labels;
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        jobs.push_back(job);
+    }
+    job_available.notify_one();
+}
+
+/**
+ * Wait until all queued files are written
+ */
+void LabelWriter::flush() {
+    boost::mutex::scoped_lock lock(mutex);
+    while (!jobs.empty() || writing)
+        job_done.wait(lock);
+}
+
+/**
+ * Get the number of files written so far
+ * 
+ * @return the number of files written
+ */
+size_t LabelWriter::get_written() {
+    boost::mutex::scoped_lock lock(mutex);
+    return written;
+}
+
+/**
+ * Get the number of files that could not be written
+ * 
+ * @return the number of files not written
+ */
+size_t LabelWriter::get_failed() {
+    boost::mutex::scoped_lock lock(mutex);
+    return failed;
+}
@@ -0,0 +1,101 @@
+/*
+ * merge_results.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+
+#include <pcl/console/print.h>
+
+#include "supervoxel_clustering/file_list.h"
+#include "supervoxel_clustering/performance_report.h"
+
+using namespace pcl;
+
+/**
+ * Orders the results of the files by path in natural order, as in a single 
+ * run on the whole directory
+ */
+bool compareFilename(const fileResult &a, const fileResult &b) {
+    return FileList::natural_less(a.filename, b.filename);
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 3) {
+        console::print_info(
+                "Syntax is: "
+                "%s <test-results-filename> <result-file> [<result-file> ...]\n"
+                "\n\tCombines the result files saved by each shard of a "
+                "directory (--shard) into the same CSV files and average "
+                "scores of a single run on the whole directory\n",
+                argv[0]);
+        return (1);
+    }
+
+    std::string test_filename = argv[1];
+
+    std::vector<fileResult> results;
+    for (int i = 2; i < argc; ++i) {
+        size_t before = results.size();
+        if (!PerformanceReport::load_results(argv[i], results))
+            return (1);
+        console::print_info("Loaded %zu files from %s\n",
+                results.size() - before, argv[i]);
+    }
+
+    std::stable_sort(results.begin(), results.end(), compareFilename);
+    for (size_t i = 1; i < results.size(); ++i)
+        if (results[i].filename == results[i - 1].filename)
+            console::print_warn("File %s appears in more than one shard\n",
+                    results[i].filename.c_str());
+
+    std::vector<std::map<float, performanceSet> > all_performances;
+    std::vector<performanceSet> best_performances;
+    std::vector<fileResult>::iterator r_it = results.begin();
+    for (; r_it != results.end(); ++r_it) {
+        if (!r_it->all_performances.empty())
+            all_performances.push_back(r_it->all_performances);
+        best_performances.push_back(r_it->performance);
+    }
+
+    PerformanceReport::save_all(all_performances, test_filename);
+
+    PerformanceReport::print_best(best_performances);
+
+    return (0);
+}
@@ -0,0 +1,302 @@
+/*
+ * performance_report.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "supervoxel_clustering/performance_report.h"
+
+/**
+ * Save the scores of all thresholds tested on each file in a set of CSV files,
+ * one for each metric, with a line for each file
+ * 
+ * @param all_performances  the scores of each threshold, for each file
+ * @param filename          the prefix of the CSV files
+ */
+void PerformanceReport::save_all(
+        std::vector<std::map<float, performanceSet> > all_performances,
+        std::string filename) {
+    std::ofstream file_voi((filename + "_voi.csv").c_str());
+    std::ofstream file_prec((filename + "_precision.csv").c_str());
+    std::ofstream file_recall((filename + "_recall.csv").c_str());
+    std::ofstream file_fscore((filename + "_fscore.csv").c_str());
+    std::ofstream file_wov((filename + "_wov.csv").c_str());
+    std::ofstream file_fpr((filename + "_fpr.csv").c_str());
+    std::ofstream file_fnr((filename + "_fnr.csv").c_str());
+
+    std::vector<std::map<float, performanceSet> >::iterator p_it =
+            all_performances.begin();
+    for (; p_it != all_performances.end(); ++p_it) {
+        std::map<float, performanceSet>::iterator m_it = p_it->begin();
+        for (; m_it != p_it->end(); ++m_it) {
+            file_voi << m_it->second.voi << ";";
+            file_prec << m_it->second.precision << ";";
+            file_recall << m_it->second.recall << ";";
+            file_fscore << m_it->second.fscore << ";";
+            file_wov << m_it->second.wov << ";";
+            file_fpr << m_it->second.fpr << ";";
+            file_fnr << m_it->second.fnr << ";";
+        }
+        file_voi << "\n";
+        file_prec << "\n";
+        file_recall << "\n";
+        file_fscore << "\n";
+        file_wov << "\n";
+        file_fpr << "\n";
+        file_fnr << "\n";
+
+    }
+    file_voi.close();
+    file_prec.close();
+    file_recall.close();
+    file_fscore.close();
+    file_wov.close();
+    file_fpr.close();
+    file_fnr.close();
+}
+
+/**
+ * Print the scores of a single file, or the average scores of many files
+ * 
+ * @param best_performances the scores of each file
+ */
+void PerformanceReport::print_best(
+        std::vector<performanceSet> best_performances) {
+    if (best_performances.size() == 1) {
+        performanceSet p = best_performances.back();
+        pcl::console::print_info(
+                "Scores:\nVOI\t%f\nPrec.\t%f\nRecall\t%f\nF-score\t%f\n"
+                "WOv\t%f\nFPR\t%f\nFNR\t%f\n",
+                p.voi, p.precision, p.recall, p.fscore, p.wov, p.fpr, p.fnr);
+    } else {
+        std::vector<performanceSet>::iterator p_it = best_performances.begin();
+        float mean_v = 0;
+        float mean_p = 0;
+        float mean_r = 0;
+        float mean_f = 0;
+        float mean_w = 0;
+        float mean_pr = 0;
+        float mean_nr = 0;
+        int count = 0;
+        for (; p_it != best_performances.end(); ++p_it) {
+            count++;
+            mean_v = mean_v + (1.0f / count) * (p_it->voi - mean_v);
+            mean_p = mean_p + (1.0f / count) * (p_it->precision - mean_p);
+            mean_r = mean_r + (1.0f / count) * (p_it->recall - mean_r);
+            mean_f = mean_f + (1.0f / count) * (p_it->fscore - mean_f);
+            mean_w = mean_w + (1.0f / count) * (p_it->wov - mean_w);
+            mean_pr = mean_pr + (1.0f / count) * (p_it->fpr - mean_pr);
+            mean_nr = mean_nr + (1.0f / count) * (p_it->fnr - mean_nr);
+            pcl::console::print_debug(
+                    "Scores:\nVOI\t%f\nPrec.\t%f\nRecall\t%f\nF-score\t%f\n"
+                    "WOv\t%f\nFPR\t%f\nFNR\t%f\n",
+                    p_it->voi, p_it->precision, p_it->recall, p_it->fscore,
+                    p_it->wov, p_it->fpr, p_it->fnr);
+        }
+        pcl::console::print_info(
+                "Average scores:\nVOI\t%f\nPrec.\t%f\nRecall\t%f\nF-score\t%f\n"
+                "WOv\t%f\nFPR\t%f\nFNR\t%f\n",
+                mean_v, mean_p, mean_r, mean_f, mean_w, mean_pr, mean_nr);
+    }
+}
+
+/**
+ * Write the scores of a file on a stream
+ * 
+ * @param out   the output stream
+ * @param p     the scores
+ */
+static void write_performance(std::ostream &out, const performanceSet &p) {
+    out << p.voi << " " << p.precision << " " << p.recall << " " << p.fscore
+            << " " << p.wov << " " << p.fpr << " " << p.fnr;
+}
+
+/**
+ * Read the scores of a file from a stream
+ * 
+ * @param in    the input stream
+ * @param p     the scores
+ * 
+ * @return true if all scores were read
+ */
+static bool read_performance(std::istream &in, performanceSet &p) {
+    in >> p.voi >> p.precision >> p.recall >> p.fscore >> p.wov >> p.fpr
+            >> p.fnr;
+    return !in.fail();
+}
+
+/**
+ * Write the evaluation of a file on a stream, in the result file format
+ * 
+ * @param out       the output stream
+ * @param result    the evaluation of the file
+ */
+void PerformanceReport::write_result(std::ostream &out,
+        const fileResult &result) {
+    // Values are written with enough digits to be read back unchanged
+    out << std::setprecision(9);
+    out << "file " << result.filename << "\n";
+    out << "best ";
+    write_performance(out, result.performance);
+    out << "\n";
+    std::map<float, performanceSet>::const_iterator m_it =
+            result.all_performances.begin();
+    for (; m_it != result.all_performances.end(); ++m_it) {
+        out << "thresh " << m_it->first << " ";
+        write_performance(out, m_it->second);
+        out << "\n";
+    }
+    out << "end\n";
+}
+
+/**
+ * Save the evaluation of a set of files in a result file
+ * 
+ * @param results   the evaluation of each file
+ * @param filename  the name of the result file
+ * @param signature the arguments of the run that produced the results, not
+ *                  saved if empty
+ */
+void PerformanceReport::save_results(const std::vector<fileResult> &results,
+        std::string filename, std::string signature) {
+    std::ofstream file(filename.c_str());
+    if (!signature.empty())
+        file << "run " << signature << "\n";
+    std::vector<fileResult>::const_iterator r_it = results.begin();
+    for (; r_it != results.end(); ++r_it)
+        write_result(file, *r_it);
+    file.close();
+}
+
+/**
+ * Load the evaluation of a set of files from a result file
+ * 
+ * If the file is malformed, e.g. because the run writing it was interrupted,
+ * the files read completely before the error are still added to results
+ * 
+ * @param filename  the name of the result file
+ * @param results   the vector to which the evaluation of each file is added
+ * @param signature if not NULL, set to the arguments of the run that
+ *                  produced the results, or to an empty string if unknown
+ * 
+ * @return true if the file was loaded, false otherwise
+ */
+bool PerformanceReport::load_results(std::string filename,
+        std::vector<fileResult> &results, std::string *signature) {
+    if (signature != NULL)
+        signature->clear();
+    std::ifstream file(filename.c_str());
+    if (!file.is_open()) {
+        pcl::console::print_error("Cannot open result file '%s'\n",
+                filename.c_str());
+        return false;
+    }
+    std::string line;
+    fileResult current;
+    bool in_file = false;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 4, "run ") == 0) {
+            if (signature != NULL)
+                *signature = line.substr(4);
+            continue;
+        }
+        if (line.compare(0, 5, "file ") == 0) {
+            current = fileResult();
+            current.filename = line.substr(5);
+            in_file = true;
+            continue;
+        }
+        std::istringstream in(line);
+        std::string key;
+        in >> key;
+        bool valid = in_file;
+        if (key == "best") {
+            valid = valid && read_performance(in, current.performance);
+        } else if (key == "thresh") {
+            float t;
+            performanceSet p;
+            valid = valid && (in >> t) && read_performance(in, p);
+            current.all_performances.insert(
+                    std::pair<float, performanceSet>(t, p));
+        } else if (key == "end") {
+            results.push_back(current);
+            in_file = false;
+        } else {
+            valid = key.empty();
+        }
+        if (!valid) {
+            pcl::console::print_error("Malformed result file '%s': '%s'\n",
+                    filename.c_str(), line.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Hash a path with the 64 bit FNV-1a function, which gives the same value on
+ * every machine
+ * 
+ * @param path  the path
+ * 
+ * @return the hash of the path
+ */
+uint64_t PerformanceReport::path_hash(const std::string &path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < path.size(); ++i) {
+        hash ^= (unsigned char) path[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Check whether a file belongs to a shard of the dataset
+ * 
+ * @param path      the path of the file relative to the dataset directory
+ * @param shard     the index of the shard, in [0, shards)
+ * @param shards    the number of shards
+ * 
+ * @return true if the file belongs to the shard
+ */
+bool PerformanceReport::in_shard(const std::string &path, size_t shard,
+        size_t shards) {
+    return path_hash(path) % shards == shard;
+}
@@ -0,0 +1,425 @@
+/*
+ * plane_extractor.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+#include "supervoxel_clustering/plane_extractor.h"
+#include "supervoxel_clustering/segment_moments.h"
+#include "supervoxel_clustering/task_graph.h"
+
+/**
+ * Integer coordinates of a cell of the grid on which planes are voxelized
+ */
+struct voxelKey {
+    int x, y, z;
+
+    bool operator<(const voxelKey &other) const {
+        if (x != other.x)
+            return x < other.x;
+        if (y != other.y)
+            return y < other.y;
+        return z < other.z;
+    }
+};
+
+/**
+ * Sums of the points falling in a cell of the grid
+ */
+struct voxelSums {
+
+    voxelSums() :
+    count(0), x(0), y(0), z(0), r(0), g(0), b(0) {
+    }
+    size_t count;
+    double x, y, z, r, g, b;
+    std::map<uint32_t, size_t> labels;
+};
+
+/**
+ * Constructor for the PlaneExtractor class
+ * 
+ * @param voxel_resolution  the resolution of the voxels, also used as the
+ *                          largest distance of a point from its plane
+ * @param max_planes        the largest number of planes to be extracted
+ */
+PlaneExtractor::PlaneExtractor(float voxel_resolution, size_t max_planes) :
+voxel_resolution(voxel_resolution), distance(voxel_resolution),
+max_planes(max_planes), pool(NULL) {
+}
+
+/**
+ * Score a chunk of random plane hypotheses on a set of points, keeping the 
+ * one with the most inliers
+ * 
+ * @param cloud     the pointcloud
+ * @param points    the indices of the points on which hypotheses are scored
+ * @param seed      the seed of the chunk
+ * @param best      the best hypothesis of the chunk, with score 0 if no
+ *                  valid hypothesis was found
+ */
+void PlaneExtractor::score_hypotheses(const PointCloudT *cloud,
+        const std::vector<int> *points, uint32_t seed,
+        planeHypothesis *best) const {
+    best->coefficients.setZero();
+    best->score = 0;
+    std::minstd_rand rng(seed + 1);
+    std::uniform_int_distribution<size_t> pick(0, points->size() - 1);
+    for (size_t h = 0; h < PLANE_HYPOTHESES / PLANE_HYPOTHESES_CHUNKS; ++h) {
+        Eigen::Vector3f a = (*cloud)[(*points)[pick(rng)]].getVector3fMap();
+        Eigen::Vector3f b = (*cloud)[(*points)[pick(rng)]].getVector3fMap();
+        Eigen::Vector3f c = (*cloud)[(*points)[pick(rng)]].getVector3fMap();
+        Eigen::Vector3f n = (b - a).cross(c - a);
+        float norm = n.norm();
+        if (!(norm > 1e-12f))
+            continue;
+        n /= norm;
+        float d = -n.dot(a);
+        size_t score = 0;
+        std::vector<int>::const_iterator it = points->begin();
+        for (; it != points->end(); ++it)
+            if (std::abs(n.dot((*cloud)[*it].getVector3fMap()) + d)
+                    <= distance)
+                score++;
+        if (score > best->score) {
+            best->coefficients.head<3>() = n;
+            best->coefficients[3] = d;
+            best->score = score;
+        }
+    }
+}
+
+/**
+ * Split a set of points between the inliers of a plane and the others, 
+ * keeping their order
+ * 
+ * @param cloud         the pointcloud
+ * @param points        the indices of the points to be split
+ * @param coefficients  the plane
+ * @param plane_points  the indices of the inliers
+ * @param other_points  the indices of the other points
+ */
+void PlaneExtractor::inliers(const PointCloudT &cloud,
+        const std::vector<int> &points, const Eigen::Vector4f &coefficients,
+        std::vector<int> &plane_points,
+        std::vector<int> &other_points) const {
+    plane_points.clear();
+    other_points.clear();
+    Eigen::Vector3f n = coefficients.head<3>();
+    std::vector<int>::const_iterator it = points.begin();
+    for (; it != points.end(); ++it) {
+        if (std::abs(n.dot(cloud[*it].getVector3fMap()) + coefficients[3])
+                <= distance)
+            plane_points.push_back(*it);
+        else
+            other_points.push_back(*it);
+    }
+}
+
+/**
+ * Split a set of points in connected parts: points are connected when they 
+ * fall in the same cell of the voxel grid or in two of its cells touching 
+ * each other, even only at a corner
+ * 
+ * @param cloud     the pointcloud
+ * @param points    the indices of the points
+ * @param parts     the vector in which the indices of the points of each part
+ *                  are written
+ */
+void PlaneExtractor::components(const PointCloudT &cloud,
+        const std::vector<int> &points,
+        std::vector<std::vector<int> > &parts) const {
+    std::map<voxelKey, std::vector<int> > cells;
+    std::vector<int>::const_iterator it = points.begin();
+    for (; it != points.end(); ++it) {
+        const PointT &p = cloud[*it];
+        voxelKey key;
+        key.x = static_cast<int> (std::floor(p.x / voxel_resolution));
+        key.y = static_cast<int> (std::floor(p.y / voxel_resolution));
+        key.z = static_cast<int> (std::floor(p.z / voxel_resolution));
+        cells[key].push_back(*it);
+    }
+
+    // Parts are visited in the order of the grid, so they don't depend on the
+    // order of the points
+    parts.clear();
+    std::set<voxelKey> visited;
+    std::map<voxelKey, std::vector<int> >::const_iterator c_it = cells.begin();
+    for (; c_it != cells.end(); ++c_it) {
+        if (!visited.insert(c_it->first).second)
+            continue;
+        parts.push_back(std::vector<int>());
+        std::vector<int> &part = parts.back();
+        std::vector<voxelKey> queue(1, c_it->first);
+        while (!queue.empty()) {
+            voxelKey key = queue.back();
+            queue.pop_back();
+            const std::vector<int> &cell = cells.find(key)->second;
+            part.insert(part.end(), cell.begin(), cell.end());
+            for (int dx = -1; dx <= 1; ++dx)
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        voxelKey n = key;
+                        n.x += dx;
+                        n.y += dy;
+                        n.z += dz;
+                        if (cells.count(n) != 0 && visited.insert(n).second)
+                            queue.push_back(n);
+                    }
+        }
+        std::sort(part.begin(), part.end());
+    }
+}
+
+/**
+ * Voxelize the points of a plane on a regular grid, giving each voxel the 
+ * mean position and color of its points and the most frequent of their 
+ * labels
+ * 
+ * @param cloud     the pointcloud
+ * @param truth     the labelled pointcloud, with the same points
+ * @param points    the indices of the points of the plane
+ * @param plane     the plane, whose voxels are set
+ */
+void PlaneExtractor::voxelize(const PointCloudT &cloud,
+        const PointLCloudT &truth, const std::vector<int> &points,
+        planeSegment &plane) const {
+    std::map<voxelKey, voxelSums> grid;
+    std::vector<int>::const_iterator it = points.begin();
+    for (; it != points.end(); ++it) {
+        const PointT &p = cloud[*it];
+        voxelKey key;
+        key.x = static_cast<int> (std::floor(p.x / voxel_resolution));
+        key.y = static_cast<int> (std::floor(p.y / voxel_resolution));
+        key.z = static_cast<int> (std::floor(p.z / voxel_resolution));
+        voxelSums &sums = grid[key];
+        sums.count++;
+        sums.x += p.x;
+        sums.y += p.y;
+        sums.z += p.z;
+        sums.r += p.r;
+        sums.g += p.g;
+        sums.b += p.b;
+        sums.labels[truth[*it].label]++;
+    }
+
+    plane.voxels = boost::make_shared<PointCloudT>();
+    plane.truth_voxels = boost::make_shared<PointLCloudT>();
+    plane.voxels->reserve(grid.size());
+    plane.truth_voxels->reserve(grid.size());
+    std::map<voxelKey, voxelSums>::const_iterator g_it = grid.begin();
+    for (; g_it != grid.end(); ++g_it) {
+        const voxelSums &sums = g_it->second;
+        PointT v;
+        v.x = sums.x / sums.count;
+        v.y = sums.y / sums.count;
+        v.z = sums.z / sums.count;
+        v.r = sums.r / sums.count;
+        v.g = sums.g / sums.count;
+        v.b = sums.b / sums.count;
+        v.a = 255;
+        plane.voxels->push_back(v);
+        PointLT l;
+        l.x = v.x;
+        l.y = v.y;
+        l.z = v.z;
+        size_t most = 0;
+        std::map<uint32_t, size_t>::const_iterator l_it = sums.labels.begin();
+        for (; l_it != sums.labels.end(); ++l_it) {
+            if (l_it->second > most) {
+                most = l_it->second;
+                l.label = l_it->first;
+            }
+        }
+        plane.truth_voxels->push_back(l);
+    }
+    plane.voxels->width = plane.truth_voxels->width = grid.size();
+    plane.voxels->height = plane.truth_voxels->height = 1;
+}
+
+/**
+ * Extract the dominant planes of a pointcloud, removing their points from it
+ * 
+ * @param cloud     the pointcloud, from which the points of the planes are
+ *                  removed
+ * @param truth     the labelled pointcloud, with the same points, from which
+ *                  the points of the planes are removed too
+ * @param planes    the vector in which the planes are written
+ * @param normals   if given and not empty, the normals of the pointcloud, 
+ *                  from which the normals of the points of the planes are 
+ *                  removed too
+ */
+void PlaneExtractor::extract(PointCloudT::Ptr cloud, PointLCloudT::Ptr truth,
+        std::vector<planeSegment> &planes, NormalCloudT::Ptr normals) const {
+    planes.clear();
+    size_t min_points = std::max<size_t>(3,
+            PLANE_MIN_FRACTION * cloud->size());
+    std::vector<int> points(cloud->size());
+    for (size_t i = 0; i < points.size(); ++i)
+        points[i] = i;
+
+    std::vector<int> plane_points, other_points;
+    while (planes.size() < max_planes && points.size() >= min_points) {
+        // Hypotheses are scored on a regular subsample of the points left
+        std::vector<int> sample;
+        size_t stride = std::max<size_t>(1,
+                points.size() / PLANE_SCORING_POINTS);
+        for (size_t i = 0; i < points.size(); i += stride)
+            sample.push_back(points[i]);
+
+        std::vector<planeHypothesis> chunks(PLANE_HYPOTHESES_CHUNKS);
+        TaskGraph graph(pool);
+        for (size_t c = 0; c < chunks.size(); ++c)
+            graph.add_task("planes", boost::bind(
+                &PlaneExtractor::score_hypotheses, this, cloud.get(), &sample,
+                planes.size() * chunks.size() + c, &chunks[c]));
+        graph.run();
+        planeHypothesis best = chunks[0];
+        for (size_t c = 1; c < chunks.size(); ++c)
+            if (chunks[c].score > best.score)
+                best = chunks[c];
+        if (best.score == 0)
+            break;
+
+        // Refine the plane by least squares on its inliers
+        inliers(*cloud, points, best.coefficients, plane_points,
+                other_points);
+        PointCloudT plane_cloud;
+        plane_cloud.reserve(plane_points.size());
+        std::vector<int>::const_iterator it = plane_points.begin();
+        for (; it != plane_points.end(); ++it)
+            plane_cloud.push_back((*cloud)[*it]);
+        Eigen::Vector4f coefficients;
+        float curvature;
+        if (SegmentMoments::normal(SegmentMoments::compute(plane_cloud),
+                coefficients, curvature))
+            inliers(*cloud, points, coefficients, plane_points,
+                other_points);
+        else
+            coefficients = best.coefficients;
+        if (plane_points.size() < min_points)
+            break;
+
+        // Each large enough connected part of the inliers is a plane, the 
+        // points of the others are given back
+        std::vector<std::vector<int> > parts;
+        components(*cloud, plane_points, parts);
+        size_t found = planes.size();
+        std::vector<std::vector<int> >::const_iterator p_it = parts.begin();
+        for (; p_it != parts.end(); ++p_it) {
+            if (p_it->size() < min_points || planes.size() >= max_planes) {
+                other_points.insert(other_points.end(), p_it->begin(),
+                        p_it->end());
+                continue;
+            }
+            planeSegment plane;
+            plane.coefficients = coefficients;
+            voxelize(*cloud, *truth, *p_it, plane);
+            planes.push_back(plane);
+            pcl::console::print_debug("Plane %zu: %zu points, %zu voxels\n",
+                    planes.size(), p_it->size(), plane.voxels->size());
+        }
+        if (planes.size() == found)
+            break;
+        points.swap(other_points);
+    }
+    if (planes.empty())
+        return;
+
+    std::sort(points.begin(), points.end());
+    PointCloudT::Ptr rest_cloud = boost::make_shared<PointCloudT>();
+    PointLCloudT::Ptr rest_truth = boost::make_shared<PointLCloudT>();
+    rest_cloud->reserve(points.size());
+    rest_truth->reserve(points.size());
+    std::vector<int>::const_iterator it = points.begin();
+    for (; it != points.end(); ++it) {
+        rest_cloud->push_back((*cloud)[*it]);
+        rest_truth->push_back((*truth)[*it]);
+    }
+    *cloud = *rest_cloud;
+    *truth = *rest_truth;
+    cloud->width = truth->width = points.size();
+    cloud->height = truth->height = 1;
+    if (normals && !normals->empty()) {
+        NormalCloudT::Ptr rest_normals = boost::make_shared<NormalCloudT>();
+        rest_normals->reserve(points.size());
+        for (it = points.begin(); it != points.end(); ++it)
+            rest_normals->push_back((*normals)[*it]);
+        *normals = *rest_normals;
+        normals->width = points.size();
+        normals->height = 1;
+    }
+}
+
+/**
+ * Add extracted planes to a set of supervoxels, each as a single supervoxel
+ * with the labels following the largest one
+ * 
+ * @param planes    the planes
+ * @param segments  the supervoxels
+ */
+void PlaneExtractor::add_segments(const std::vector<planeSegment> &planes,
+        ClusteringT &segments) {
+    uint32_t label = (segments.empty()) ? 1 : segments.rbegin()->first + 1;
+    std::vector<planeSegment>::const_iterator it = planes.begin();
+    for (; it != planes.end(); ++it, ++label) {
+        SupervoxelT::Ptr s = boost::make_shared<SupervoxelT>();
+        *(s->voxels_) = *(it->voxels);
+        SegmentMoments::centroid(SegmentMoments::compute(*(it->voxels)),
+                s->centroid_);
+        // Normals point towards the camera, as those of the supervoxels
+        Eigen::Vector3f n = it->coefficients.head<3>();
+        if (n.dot(s->centroid_.getVector3fMap()) > 0)
+            n = -n;
+        s->normal_.normal_x = n[0];
+        s->normal_.normal_y = n[1];
+        s->normal_.normal_z = n[2];
+        s->normal_.curvature = 0;
+        for (size_t i = 0; i < it->voxels->size(); ++i)
+            s->normals_->push_back(s->normal_);
+        segments.insert(std::pair<uint32_t, SupervoxelT::Ptr>(label, s));
+    }
+}
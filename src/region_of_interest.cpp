@@ -0,0 +1,113 @@
+/*
+ * region_of_interest.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "supervoxel_clustering/region_of_interest.h"
+
+/**
+ * Constructor for the RegionOfInterest class, containing every point
+ */
+RegionOfInterest::RegionOfInterest() :
+type(ROI_NONE), min(Eigen::Vector3f::Zero()), max(Eigen::Vector3f::Zero()),
+rotation(Eigen::Matrix3f::Identity()), center(Eigen::Vector3f::Zero()),
+tan_h(0), tan_v(0) {
+}
+
+/**
+ * Parse a region of interest from its description
+ * 
+ * @param spec  the description of the region, as described in the class
+ * @param roi   the region, set if the description is valid
+ * 
+ * @return true if the description is valid, false otherwise
+ */
+bool RegionOfInterest::parse(std::string spec, RegionOfInterest &roi) {
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos)
+        return false;
+    std::string name = spec.substr(0, colon);
+    std::vector<float> values;
+    std::istringstream in(spec.substr(colon + 1));
+    float value;
+    char separator = ',';
+    while (separator == ',' && in >> value) {
+        values.push_back(value);
+        if (!(in >> separator))
+            separator = 0;
+    }
+    if (separator != 0)
+        return false;
+
+    RegionOfInterest r;
+    if (name == "box" && values.size() == 6) {
+        r.type = ROI_BOX;
+        r.min = Eigen::Vector3f(values[0], values[1], values[2]);
+        r.max = Eigen::Vector3f(values[3], values[4], values[5]);
+        if ((r.min.array() > r.max.array()).any())
+            return false;
+    } else if (name == "obb" && values.size() == 9) {
+        r.type = ROI_OBB;
+        r.center = Eigen::Vector3f(values[0], values[1], values[2]);
+        r.max = Eigen::Vector3f(values[3], values[4], values[5]);
+        r.min = -r.max;
+        if ((r.max.array() < 0).any())
+            return false;
+        r.rotation = (Eigen::AngleAxisf(values[8], Eigen::Vector3f::UnitZ())
+                * Eigen::AngleAxisf(values[7], Eigen::Vector3f::UnitY())
+                * Eigen::AngleAxisf(values[6], Eigen::Vector3f::UnitX()))
+                .toRotationMatrix();
+    } else if (name == "frustum" && values.size() == 4) {
+        r.type = ROI_FRUSTUM;
+        if (values[0] <= 0 || values[0] >= M_PI || values[1] <= 0
+                || values[1] >= M_PI || values[2] < 0 || values[3] <= values[2])
+            return false;
+        r.tan_h = std::tan(values[0] / 2);
+        r.tan_v = std::tan(values[1] / 2);
+        r.min = Eigen::Vector3f(0, 0, values[2]);
+        r.max = Eigen::Vector3f(0, 0, values[3]);
+    } else {
+        return false;
+    }
+    roi = r;
+    return true;
+}
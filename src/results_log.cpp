@@ -0,0 +1,201 @@
+/*
+ * results_log.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+#include <pcl/console/print.h>
+
+#include "supervoxel_clustering/results_log.h"
+
+/**
+ * Write a value as a JSON number, or as null if it is not finite
+ * 
+ * @param out   the output stream
+ * @param value the value
+ */
+static void write_number(std::ostream &out, double value) {
+    if (std::isfinite(value))
+        out << value;
+    else
+        out << "null";
+}
+
+/**
+ * Escape a string to be written in a JSON string
+ * 
+ * @param s the string
+ * 
+ * @return the escaped string, without the surrounding quotes
+ */
+std::string ResultsLog::escape(const std::string &s) {
+    std::string escaped;
+    escaped.reserve(s.size());
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if ((unsigned char) c < 0x20) {
+            char code[7];
+            std::snprintf(code, sizeof (code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * Write the record of a file evaluated at one threshold
+ * 
+ * @param file_id   the identifier of the file
+ * @param config    the arguments of the configuration used
+ * @param threshold the threshold
+ * @param best      whether it is the best threshold of the file
+ * @param p         the scores
+ * @param timings   the stage timings, already formatted as a JSON object
+ */
+void ResultsLog::write_row(const std::string &file_id,
+        const std::string &config, float threshold, bool best,
+        const performanceSet &p, const std::string &timings) {
+    file << "{\"file\":\"" << escape(file_id) << "\",\"config\":\""
+            << escape(config) << "\",\"thresh\":";
+    write_number(file, threshold);
+    file << ",\"best\":" << (best ? "true" : "false") << ",\"voi\":";
+    write_number(file, p.voi);
+    file << ",\"precision\":";
+    write_number(file, p.precision);
+    file << ",\"recall\":";
+    write_number(file, p.recall);
+    file << ",\"fscore\":";
+    write_number(file, p.fscore);
+    file << ",\"wov\":";
+    write_number(file, p.wov);
+    file << ",\"fpr\":";
+    write_number(file, p.fpr);
+    file << ",\"fnr\":";
+    write_number(file, p.fnr);
+    file << ",\"timings\":" << timings << "}\n";
+}
+
+/**
+ * Open the results file
+ * 
+ * @param filename  the name of the results file
+ * @param append    if true, the records are added to the ones already in the
+ *                  file, otherwise the file is emptied
+ * 
+ * @return true if the file was opened, false otherwise
+ */
+bool ResultsLog::open(std::string filename, bool append) {
+    boost::mutex::scoped_lock lock(mutex);
+    if (file.is_open())
+        file.close();
+    file.open(filename.c_str(), append ? std::ios::app : std::ios::trunc);
+    if (!file.is_open()) {
+        pcl::console::print_error("Cannot open results file '%s'\n",
+                filename.c_str());
+        return false;
+    }
+    // Values are written with enough digits to be read back unchanged
+    file << std::setprecision(9);
+    return true;
+}
+
+/**
+ * Check whether the results file is open
+ * 
+ * @return true if the results file is open
+ */
+bool ResultsLog::is_open() const {
+    return file.is_open();
+}
+
+/**
+ * Append the evaluation of a file, one record for each threshold tested, or a
+ * single record if only one threshold was used, and flush them to disk
+ * 
+ * @param file_id           the identifier of the file
+ * @param config            the arguments of the configuration used
+ * @param all_performances  the scores at each threshold tested, empty if only
+ *                          one threshold was used
+ * @param performance       the scores at the best threshold
+ * @param threshold         the best threshold
+ * @param timings           the time taken by each processing stage in ms
+ */
+void ResultsLog::write(const std::string &file_id, const std::string &config,
+        const std::map<float, performanceSet> &all_performances,
+        const performanceSet &performance, float threshold,
+        const std::vector<std::pair<std::string, double> > &timings) {
+    std::stringstream t;
+    t << std::setprecision(9) << "{";
+    for (size_t i = 0; i < timings.size(); ++i) {
+        t << (i > 0 ? "," : "") << "\"" << escape(timings[i].first) << "\":";
+        write_number(t, timings[i].second);
+    }
+    t << "}";
+
+    boost::mutex::scoped_lock lock(mutex);
+    if (!file.is_open())
+        return;
+    if (all_performances.empty()) {
+        write_row(file_id, config, threshold, true, performance, t.str());
+    } else {
+        std::map<float, performanceSet>::const_iterator m_it =
+                all_performances.begin();
+        for (; m_it != all_performances.end(); ++m_it)
+            write_row(file_id, config, m_it->first, m_it->first == threshold,
+                    m_it->second, t.str());
+    }
+    file.flush();
+}
+
+/**
+ * Close the results file
+ */
+void ResultsLog::close() {
+    boost::mutex::scoped_lock lock(mutex);
+    if (file.is_open())
+        file.close();
+}
@@ -0,0 +1,328 @@
+/*
+ * segment_index.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+#include "supervoxel_clustering/segment_index.h"
+
+#define BVH_LEAF_SIZE 4
+
+/**
+ * Orders segments by the center of their bounding box along an axis
+ */
+struct compareCenter {
+    int axis;
+
+    bool operator()(const indexedSegment &a, const indexedSegment &b) const {
+        return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis];
+    }
+};
+
+/**
+ * Constructor for the SegmentIndex class
+ */
+SegmentIndex::SegmentIndex() :
+reused(0), rebuilt(0) {
+}
+
+/**
+ * Update the index with the regions of a segmentation; regions already indexed
+ * are kept, and only the new ones are processed
+ * 
+ * @param segments  the regions of the segmentation
+ */
+void SegmentIndex::update(const ClusteringT &segments) {
+    reused = rebuilt = 0;
+    std::map<uint32_t, indexedSegment> updated;
+    ClusteringT::const_iterator it = segments.begin();
+    for (; it != segments.end(); ++it) {
+        std::map<uint32_t, indexedSegment>::iterator old =
+                indexed.find(it->first);
+        if (old != indexed.end() && old->second.segment == it->second) {
+            updated.insert(*old);
+            reused++;
+            continue;
+        }
+        indexedSegment s;
+        s.label = it->first;
+        s.segment = it->second;
+        s.min.setConstant(std::numeric_limits<float>::max());
+        s.max.setConstant(-std::numeric_limits<float>::max());
+        const pcl::PointCloud<PointT> &voxels = *(it->second->voxels_);
+        for (size_t i = 0; i < voxels.size(); ++i) {
+            Eigen::Vector3f p(voxels[i].x, voxels[i].y, voxels[i].z);
+            s.min = s.min.cwiseMin(p);
+            s.max = s.max.cwiseMax(p);
+        }
+        if (voxels.empty())
+            continue;
+        s.tree.reset(new pcl::KdTreeFLANN<PointT>);
+        s.tree->setInputCloud(it->second->voxels_);
+        updated.insert(std::pair<uint32_t, indexedSegment>(s.label, s));
+        rebuilt++;
+    }
+    indexed.swap(updated);
+
+    ordered.clear();
+    ordered.reserve(indexed.size());
+    std::map<uint32_t, indexedSegment>::const_iterator i_it = indexed.begin();
+    for (; i_it != indexed.end(); ++i_it)
+        ordered.push_back(i_it->second);
+    nodes.clear();
+    if (!ordered.empty())
+        build(0, ordered.size());
+}
+
+/**
+ * Remove all regions from the index
+ */
+void SegmentIndex::clear() {
+    indexed.clear();
+    ordered.clear();
+    nodes.clear();
+    reused = rebuilt = 0;
+}
+
+/**
+ * Build the node of the hierarchy holding a range of the ordered segments, 
+ * splitting it at the median along the longest axis of its bounding box
+ * 
+ * @param begin the first segment of the range
+ * @param end   the segment after the last one of the range
+ * 
+ * @return the index of the node
+ */
+uint32_t SegmentIndex::build(size_t begin, size_t end) {
+    uint32_t index = nodes.size();
+    nodes.push_back(bvhNode());
+    bvhNode node;
+    node.min = ordered[begin].min;
+    node.max = ordered[begin].max;
+    for (size_t i = begin + 1; i < end; ++i) {
+        node.min = node.min.cwiseMin(ordered[i].min);
+        node.max = node.max.cwiseMax(ordered[i].max);
+    }
+    node.left = node.right = 0;
+    if (end - begin <= BVH_LEAF_SIZE) {
+        node.begin = begin;
+        node.count = end - begin;
+    } else {
+        compareCenter compare;
+        (node.max - node.min).maxCoeff(&compare.axis);
+        size_t middle = (begin + end) / 2;
+        std::nth_element(ordered.begin() + begin, ordered.begin() + middle,
+                ordered.begin() + end, compare);
+        node.begin = node.count = 0;
+        node.left = build(begin, middle);
+        node.right = build(middle, end);
+    }
+    nodes[index] = node;
+    return index;
+}
+
+/**
+ * Compute the distance of a point from a box
+ * 
+ * @param min   the minimum corner of the box
+ * @param max   the maximum corner of the box
+ * @param p     the point
+ * 
+ * @return the distance, 0 if the point is in the box
+ */
+float SegmentIndex::box_distance(const Eigen::Vector3f &min,
+        const Eigen::Vector3f &max, const Eigen::Vector3f &p) {
+    Eigen::Vector3f d = (min - p).cwiseMax(p - max).cwiseMax(
+            Eigen::Vector3f::Zero());
+    return d.norm();
+}
+
+/**
+ * Check whether a segment has a voxel in a box
+ * 
+ * @param s     the segment
+ * @param min   the minimum corner of the box
+ * @param max   the maximum corner of the box
+ * 
+ * @return true if a voxel of the segment is in the box
+ */
+bool SegmentIndex::in_box(const indexedSegment &s, const Eigen::Vector3f &min,
+        const Eigen::Vector3f &max) {
+    if ((s.min.array() >= min.array()).all()
+            && (s.max.array() <= max.array()).all())
+        return true;
+    const pcl::PointCloud<PointT> &voxels = *(s.segment->voxels_);
+    for (size_t i = 0; i < voxels.size(); ++i)
+        if (voxels[i].x >= min[0] && voxels[i].x <= max[0]
+                && voxels[i].y >= min[1] && voxels[i].y <= max[1]
+                && voxels[i].z >= min[2] && voxels[i].z <= max[2])
+            return true;
+    return false;
+}
+
+/**
+ * Find the regions having voxels in a box
+ * 
+ * @param min       the minimum corner of the box
+ * @param max       the maximum corner of the box
+ * @param labels    the vector in which the labels of the regions are written
+ */
+void SegmentIndex::box_query(const Eigen::Vector3f &min,
+        const Eigen::Vector3f &max, std::vector<uint32_t> &labels) const {
+    labels.clear();
+    if (nodes.empty())
+        return;
+    std::vector<uint32_t> stack(1, 0);
+    while (!stack.empty()) {
+        const bvhNode &node = nodes[stack.back()];
+        stack.pop_back();
+        if ((node.max.array() < min.array()).any()
+                || (node.min.array() > max.array()).any())
+            continue;
+        if (node.count == 0) {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+            continue;
+        }
+        for (uint32_t i = node.begin; i < node.begin + node.count; ++i) {
+            const indexedSegment &s = ordered[i];
+            if ((s.max.array() >= min.array()).all()
+                    && (s.min.array() <= max.array()).all()
+                    && in_box(s, min, max))
+                labels.push_back(s.label);
+        }
+    }
+    std::sort(labels.begin(), labels.end());
+}
+
+/**
+ * Find the regions having voxels within a radius of a point
+ * 
+ * @param center    the point
+ * @param radius    the radius
+ * @param labels    the vector in which the labels of the regions are written
+ */
+void SegmentIndex::radius_query(const Eigen::Vector3f &center, float radius,
+        std::vector<uint32_t> &labels) const {
+    labels.clear();
+    if (nodes.empty())
+        return;
+    PointT query;
+    query.x = center[0];
+    query.y = center[1];
+    query.z = center[2];
+    std::vector<int> k_indices(1);
+    std::vector<float> k_sqr_dists(1);
+    std::vector<uint32_t> stack(1, 0);
+    while (!stack.empty()) {
+        const bvhNode &node = nodes[stack.back()];
+        stack.pop_back();
+        if (box_distance(node.min, node.max, center) > radius)
+            continue;
+        if (node.count == 0) {
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+            continue;
+        }
+        for (uint32_t i = node.begin; i < node.begin + node.count; ++i) {
+            const indexedSegment &s = ordered[i];
+            if (box_distance(s.min, s.max, center) <= radius
+                    && s.tree->nearestKSearch(query, 1, k_indices,
+                    k_sqr_dists) > 0 && k_sqr_dists[0] <= radius * radius)
+                labels.push_back(s.label);
+        }
+    }
+    std::sort(labels.begin(), labels.end());
+}
+
+/**
+ * Find the region having the voxel nearest to a point; nodes are visited in
+ * order of distance of their bounding box, and the search stops once no box 
+ * is nearer than the best voxel found
+ * 
+ * @param point     the point
+ * @param label     the label of the nearest region
+ * @param distance  the distance of the nearest voxel of the region
+ * 
+ * @return false if the index is empty
+ */
+bool SegmentIndex::nearest_query(const Eigen::Vector3f &point,
+        uint32_t &label, float &distance) const {
+    if (nodes.empty())
+        return false;
+    PointT query;
+    query.x = point[0];
+    query.y = point[1];
+    query.z = point[2];
+    std::vector<int> k_indices(1);
+    std::vector<float> k_sqr_dists(1);
+
+    typedef std::pair<float, uint32_t> QueueItemT;
+    std::priority_queue<QueueItemT, std::vector<QueueItemT>,
+            std::greater<QueueItemT> > queue;
+    queue.push(QueueItemT(box_distance(nodes[0].min, nodes[0].max, point), 0));
+    distance = std::numeric_limits<float>::infinity();
+    while (!queue.empty() && queue.top().first < distance) {
+        const bvhNode &node = nodes[queue.top().second];
+        queue.pop();
+        if (node.count == 0) {
+            queue.push(QueueItemT(box_distance(nodes[node.left].min,
+                    nodes[node.left].max, point), node.left));
+            queue.push(QueueItemT(box_distance(nodes[node.right].min,
+                    nodes[node.right].max, point), node.right));
+            continue;
+        }
+        for (uint32_t i = node.begin; i < node.begin + node.count; ++i) {
+            const indexedSegment &s = ordered[i];
+            if (box_distance(s.min, s.max, point) >= distance
+                    || s.tree->nearestKSearch(query, 1, k_indices,
+                    k_sqr_dists) <= 0)
+                continue;
+            float d = std::sqrt(k_sqr_dists[0]);
+            if (d < distance) {
+                distance = d;
+                label = s.label;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,227 @@
+/*
+ * segment_moments.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <cmath>
+
+#include <Eigen/Eigenvalues>
+
+#include "supervoxel_clustering/color_utilities.h"
+#include "supervoxel_clustering/segment_moments.h"
+
+/**
+ * Compute the moments of a set of voxels
+ * 
+ * @param voxels    the voxels
+ * 
+ * @return the moments
+ */
+segmentMoments SegmentMoments::compute(
+        const pcl::PointCloud<PointT> &voxels) {
+    segmentMoments m;
+    pcl::PointCloud<PointT>::const_iterator it = voxels.begin();
+    for (; it != voxels.end(); ++it) {
+        double x = it->x, y = it->y, z = it->z;
+        m.count++;
+        m.sum[0] += x;
+        m.sum[1] += y;
+        m.sum[2] += z;
+        m.sum_sq[0] += x * x;
+        m.sum_sq[1] += x * y;
+        m.sum_sq[2] += x * z;
+        m.sum_sq[3] += y * y;
+        m.sum_sq[4] += y * z;
+        m.sum_sq[5] += z * z;
+        m.sum_rgba[0] += it->r;
+        m.sum_rgba[1] += it->g;
+        m.sum_rgba[2] += it->b;
+        m.sum_rgba[3] += it->a;
+        m.min[0] = std::min(m.min[0], it->x);
+        m.min[1] = std::min(m.min[1], it->y);
+        m.min[2] = std::min(m.min[2], it->z);
+        m.max[0] = std::max(m.max[0], it->x);
+        m.max[1] = std::max(m.max[1], it->y);
+        m.max[2] = std::max(m.max[2], it->z);
+    }
+    return m;
+}
+
+/**
+ * Combine the moments of two regions into the moments of their union
+ * 
+ * @param a the moments of the first region
+ * @param b the moments of the second region
+ * 
+ * @return the moments of the union
+ */
+segmentMoments SegmentMoments::combine(const segmentMoments &a,
+        const segmentMoments &b) {
+    segmentMoments m;
+    m.count = a.count + b.count;
+    for (int i = 0; i < 3; ++i) {
+        m.sum[i] = a.sum[i] + b.sum[i];
+        m.min[i] = std::min(a.min[i], b.min[i]);
+        m.max[i] = std::max(a.max[i], b.max[i]);
+    }
+    for (int i = 0; i < 6; ++i)
+        m.sum_sq[i] = a.sum_sq[i] + b.sum_sq[i];
+    for (int i = 0; i < 4; ++i)
+        m.sum_rgba[i] = a.sum_rgba[i] + b.sum_rgba[i];
+    return m;
+}
+
+/**
+ * Get the mean position of the voxels of a region
+ * 
+ * @param m the moments of the region
+ * 
+ * @return the mean position
+ */
+Eigen::Vector3f SegmentMoments::mean(const segmentMoments &m) {
+    if (m.count == 0)
+        return Eigen::Vector3f::Zero();
+    return Eigen::Vector3f(m.sum[0] / m.count, m.sum[1] / m.count,
+            m.sum[2] / m.count);
+}
+
+/**
+ * Get the covariance matrix of the voxels of a region
+ * 
+ * @param m the moments of the region
+ * 
+ * @return the covariance matrix
+ */
+Eigen::Matrix3f SegmentMoments::covariance(const segmentMoments &m) {
+    Eigen::Matrix3f c = Eigen::Matrix3f::Zero();
+    if (m.count == 0)
+        return c;
+    double n = m.count;
+    double mx = m.sum[0] / n, my = m.sum[1] / n, mz = m.sum[2] / n;
+    c(0, 0) = m.sum_sq[0] / n - mx * mx;
+    c(0, 1) = c(1, 0) = m.sum_sq[1] / n - mx * my;
+    c(0, 2) = c(2, 0) = m.sum_sq[2] / n - mx * mz;
+    c(1, 1) = m.sum_sq[3] / n - my * my;
+    c(1, 2) = c(2, 1) = m.sum_sq[4] / n - my * mz;
+    c(2, 2) = m.sum_sq[5] / n - mz * mz;
+    return c;
+}
+
+/**
+ * Get the centroid of a region, with the mean position and color of its 
+ * voxels, as computed by pcl::computeCentroid
+ * 
+ * @param m         the moments of the region
+ * @param centroid  the centroid
+ */
+void SegmentMoments::centroid(const segmentMoments &m, PointT &centroid) {
+    Eigen::Vector3f p = mean(m);
+    centroid.x = p[0];
+    centroid.y = p[1];
+    centroid.z = p[2];
+    if (m.count == 0)
+        return;
+    centroid.r = m.sum_rgba[0] / m.count;
+    centroid.g = m.sum_rgba[1] / m.count;
+    centroid.b = m.sum_rgba[2] / m.count;
+    centroid.a = m.sum_rgba[3] / m.count;
+}
+
+/**
+ * Get the normal of the plane fitting the voxels of a region, and the surface
+ * curvature, as computed by pcl::computePointNormal
+ * 
+ * @param m         the moments of the region
+ * @param normal    the normal (x, y, z) and the plane offset
+ * @param curvature the curvature
+ * 
+ * @return false if the region has less than 3 voxels, in which case the 
+ *         normal and the curvature are NaN
+ */
+bool SegmentMoments::normal(const segmentMoments &m, Eigen::Vector4f &normal,
+        float &curvature) {
+    if (m.count < 3) {
+        normal.setConstant(std::numeric_limits<float>::quiet_NaN());
+        curvature = std::numeric_limits<float>::quiet_NaN();
+        return false;
+    }
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance(m));
+    Eigen::Vector3f values = solver.eigenvalues();
+    Eigen::Vector3f n = solver.eigenvectors().col(0);
+    normal.head<3>() = n;
+    normal[3] = -n.dot(mean(m));
+    float sum = values.sum();
+    curvature = (sum != 0) ? std::abs(values[0] / sum) : 0;
+    return true;
+}
+
+/**
+ * Get the descriptors of a region from its moments
+ * 
+ * @param label the label of the region
+ * @param m     the moments of the region
+ * 
+ * @return the descriptors
+ */
+segmentDescriptor SegmentMoments::describe(uint32_t label,
+        const segmentMoments &m) {
+    segmentDescriptor d;
+    d.label = label;
+    d.voxels = m.count;
+    d.centroid = mean(m);
+    d.min = Eigen::Vector3f(m.min[0], m.min[1], m.min[2]);
+    d.max = Eigen::Vector3f(m.max[0], m.max[1], m.max[2]);
+
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance(m));
+    // Eigenvalues come in increasing order
+    for (int i = 0; i < 3; ++i) {
+        d.axes.col(i) = solver.eigenvectors().col(2 - i);
+        d.variances[i] = std::max(0.0f, solver.eigenvalues()[2 - i]);
+        // A uniform distribution on [-h, h] has variance h^2 / 3
+        d.obb_half_sizes[i] = std::sqrt(3 * d.variances[i]);
+    }
+
+    for (int i = 0; i < 3; ++i)
+        d.mean_rgb[i] = (m.count > 0) ? m.sum_rgba[i] / m.count : 0;
+    ColorUtilities::rgb2lab(d.mean_rgb, d.mean_lab);
+
+    Eigen::Vector4f plane;
+    normal(m, plane, d.curvature);
+    d.normal = plane.head<3>();
+    return d;
+}
@@ -0,0 +1,203 @@
+/*
+ * segmentation_client.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <sstream>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <pcl/common/time.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/print.h>
+#include <pcl/io/pcd_io.h>
+
+#include "supervoxel_clustering/segmentation_server.h"
+
+using namespace boost;
+using namespace pcl;
+
+struct clientResult {
+
+    clientResult() :
+    completed_jobs(0), time(0) {
+    }
+    size_t completed_jobs;
+    double time;
+};
+
+/**
+ * Send a number of jobs to the server over a single connection, waiting for
+ * the reply to each of them before sending the next one
+ */
+void run_client(std::string socket_path, std::string request,
+        std::vector<wirePoint> *payload, size_t jobs, size_t id,
+        clientResult *result) {
+    try {
+        SocketStream stream(SocketStream::connect(socket_path));
+        for (size_t j = 0; j < jobs; ++j) {
+            StopWatch watch;
+            std::string reply;
+            if (!stream.write_line(request) || (!payload->empty()
+                    && !stream.write(&(*payload)[0],
+                    payload->size() * sizeof (wirePoint)))
+                    || !stream.read_line(reply)) {
+                console::print_error("Client %zu: connection lost\n", id);
+                return;
+            }
+            std::vector<std::string> fields =
+                    SegmentationServer::tokenize(reply);
+            if (fields.empty() || fields[0] != "OK") {
+                console::print_error("Client %zu: %s\n", id, reply.c_str());
+                continue;
+            }
+            size_t voxels = std::atol(fields[1].c_str());
+            std::vector<wireLabel> labels(voxels);
+            if (voxels != 0 && !stream.read(&labels[0],
+                    voxels * sizeof (wireLabel))) {
+                console::print_error("Client %zu: connection lost\n", id);
+                return;
+            }
+            double time = watch.getTime();
+            ++result->completed_jobs;
+            result->time += time;
+            console::print_info("Client %zu, job %zu: %s voxels, %s segments, "
+                    "threshold %s, F-score %s, voi %s (server %s ms, round "
+                    "trip %f ms)\n", id, j, fields[1].c_str(),
+                    fields[2].c_str(), fields[3].c_str(), fields[6].c_str(),
+                    fields[7].c_str(), fields[9].c_str(), time);
+        }
+        stream.write_line("QUIT");
+    } catch (std::exception &e) {
+        console::print_error("Client %zu: %s\n", id, e.what());
+    }
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 4) {
+        console::print_info(
+                "Syntax is: "
+                "%s <socket-path> -p <pcd-file> [options] [arguments] \n"
+                "\n\t"
+                "Sends segmentation jobs to a server started with "
+                "'supervoxel_clustering -u <socket-path>'. The arguments are "
+                "forwarded to the server, see supervoxel_clustering for their "
+                "list. \n\t"
+                "\n\t"
+                "CLIENT optional arguments: \n\t"
+                " --inline                       (reads the file locally and "
+                "sends the points to the server; if not given, the server "
+                "reads the file) \n\t"
+                " --clients <clients>            (default: 1) \n\t"
+                " --jobs <jobs-per-client>       (default: 1) \n",
+                argv[0]);
+        return (1);
+    }
+
+    std::string socket_path = argv[1];
+    std::string path;
+    bool send_inline = false;
+    int clients = 1, jobs = 1;
+    std::string arguments;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc)
+            path = argv[++i];
+        else if (arg == "--inline")
+            send_inline = true;
+        else if (arg == "--clients" && i + 1 < argc)
+            clients = std::atoi(argv[++i]);
+        else if (arg == "--jobs" && i + 1 < argc)
+            jobs = std::atoi(argv[++i]);
+        else
+            arguments += " " + arg;
+    }
+    if (path.empty()) {
+        console::print_error("No input file specified\n");
+        return (1);
+    }
+    if (clients < 1 || jobs < 1) {
+        console::print_error("The number of clients and jobs must be "
+                "positive\n");
+        return (1);
+    }
+
+    std::vector<wirePoint> payload;
+    std::ostringstream request;
+    if (send_inline) {
+        PointCloud<PointXYZRGBL> cloud;
+        if (pcl::io::loadPCDFile(path, cloud) < 0) {
+            console::print_error("Cannot load PCD file '%s'\n", path.c_str());
+            return (1);
+        }
+        payload.resize(cloud.size());
+        for (size_t i = 0; i < cloud.size(); ++i) {
+            payload[i].x = cloud.points[i].x;
+            payload[i].y = cloud.points[i].y;
+            payload[i].z = cloud.points[i].z;
+            payload[i].rgba = cloud.points[i].rgba;
+            payload[i].label = cloud.points[i].label;
+        }
+        request << "SEGMENT " << payload.size() << arguments;
+    } else {
+        request << "SEGMENT_FILE " << path << arguments;
+    }
+
+    StopWatch watch;
+    std::vector<clientResult> results(clients);
+    thread_group threads;
+    for (int c = 0; c < clients; ++c)
+        threads.create_thread(bind(&run_client, socket_path, request.str(),
+            &payload, jobs, c, &results[c]));
+    threads.join_all();
+    double elapsed = watch.getTimeSeconds();
+
+    clientResult total;
+    for (int c = 0; c < clients; ++c) {
+        total.completed_jobs += results[c].completed_jobs;
+        total.time += results[c].time;
+    }
+    size_t completed = total.completed_jobs;
+    size_t requested = static_cast<size_t>(clients) * jobs;
+    console::print_info("Completed %zu/%zu jobs in %f s (%f jobs/s, mean "
+            "round trip %f ms)\n", completed, requested, elapsed,
+            completed / elapsed, (completed == 0) ? 0.0 :
+            total.time / completed);
+
+    return (completed == requested) ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+/*
+ * segmentation_server.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <pcl/common/time.h>
+#include <pcl/console/print.h>
+
+#include "supervoxel_clustering/segmentation_server.h"
+
+// Largest inline cloud accepted, to refuse malformed requests
+#define MAX_INLINE_POINTS 10000000
+// Points of an inline cloud received at once, so that the memory taken by a
+// request grows with the data actually received
+#define INLINE_CHUNK_POINTS 65536
+// Idle segmenters cached for each worker
+#define IDLE_SEGMENTERS_PER_WORKER 2
+
+/**
+ * Constructor for the SegmentationServer class
+ * 
+ * @param socket_path   the filesystem path of the socket to listen on
+ * @param workers       the number of connections served at the same time; if
+ *                      0, one for each hardware core
+ * @param stage_workers the number of threads on which the stages of the jobs
+ *                      run; if 0, one for each hardware core
+ */
+SegmentationServer::SegmentationServer(std::string socket_path,
+        size_t workers, size_t stage_workers) :
+path(socket_path), server(SocketStream::listen(socket_path)), pool(workers),
+stage_pool(stage_workers) {
+    max_idle = IDLE_SEGMENTERS_PER_WORKER * pool.size();
+}
+
+/**
+ * Destructor for the SegmentationServer class
+ */
+SegmentationServer::~SegmentationServer() {
+    stop();
+}
+
+/**
+ * Accept connections until the server is stopped, handing each of them to the
+ * thread pool
+ */
+void SegmentationServer::run() {
+    pcl::console::print_info("Listening on '%s' with %zu workers\n",
+            path.c_str(), pool.size());
+    int client;
+    while ((client = SocketStream::accept(server)) >= 0) {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            ++stats.connections;
+        }
+        pool.submit(boost::bind(&SegmentationServer::serve, this, client));
+    }
+}
+
+/**
+ * Stop accepting connections and remove the socket file
+ */
+void SegmentationServer::stop() {
+    if (server < 0)
+        return;
+    ::shutdown(server, SHUT_RDWR);
+    close(server);
+    ::unlink(path.c_str());
+    server = -1;
+}
+
+/**
+ * Get the number of connections and jobs served so far
+ * 
+ * @return the server statistics
+ */
+serverStats SegmentationServer::get_stats() {
+    boost::mutex::scoped_lock lock(mutex);
+    return stats;
+}
+
+/**
+ * Split a request line into whitespace separated tokens
+ * 
+ * @param line  the request line
+ * 
+ * @return the tokens
+ */
+std::vector<std::string> SegmentationServer::tokenize(
+        const std::string &line) {
+    std::vector<std::string> tokens;
+    std::istringstream in(line);
+    std::string token;
+    while (in >> token)
+        tokens.push_back(token);
+    return tokens;
+}
+
+/**
+ * Serve the requests of a client until it disconnects
+ * 
+ * @param client    the connected socket descriptor
+ */
+void SegmentationServer::serve(int client) {
+    SocketStream stream(client);
+    std::string key;
+    boost::shared_ptr<Segmenter> segmenter;
+    std::string request;
+    while (stream.read_line(request)) {
+        std::vector<std::string> tokens = tokenize(request);
+        if (tokens.empty())
+            continue;
+        if (tokens[0] == "QUIT")
+            break;
+        if (tokens[0] == "STATS") {
+            serverStats s = get_stats();
+            std::ostringstream reply;
+            reply << "OK " << s.connections << " " << s.jobs << " "
+                    << s.failed_jobs;
+            if (!stream.write_line(reply.str()))
+                break;
+            continue;
+        }
+        bool success = run_job(stream, request, key, segmenter);
+        boost::mutex::scoped_lock lock(mutex);
+        ++stats.jobs;
+        if (!success)
+            ++stats.failed_jobs;
+    }
+    if (segmenter)
+        release(key, segmenter);
+}
+
+/**
+ * Run a segmentation job and send back its results
+ * 
+ * @param stream    the connection of the client
+ * @param request   the request line
+ * @param key       the parameters of the segmenter held by the connection,
+ *                  updated if the job uses different ones
+ * @param segmenter the segmenter held by the connection, replaced if the job
+ *                  uses different parameters
+ * 
+ * @return true if the job was completed, false otherwise
+ */
+bool SegmentationServer::run_job(SocketStream &stream,
+        const std::string &request, std::string &key,
+        boost::shared_ptr<Segmenter> &segmenter) {
+    std::vector<std::string> tokens = tokenize(request);
+    if ((tokens[0] != "SEGMENT" && tokens[0] != "SEGMENT_FILE")
+            || tokens.size() < 2) {
+        stream.write_line("ERROR Unknown request '" + tokens[0] + "'");
+        return false;
+    }
+
+    // Receive the input cloud before anything else, so that a failure doesn't
+    // leave its payload in the stream
+    PointLCCloudT::Ptr input = boost::make_shared<PointLCCloudT>();
+    NormalCloudT::Ptr normals = boost::make_shared<NormalCloudT>();
+    if (tokens[0] == "SEGMENT") {
+        long points = std::atol(tokens[1].c_str());
+        if (points <= 0 || points > MAX_INLINE_POINTS) {
+            // The payload can't be skipped without knowing its size, so the
+            // rest of the stream can't be parsed
+            stream.write_line("ERROR Invalid number of points");
+            stream.close();
+            return false;
+        }
+        std::vector<wirePoint> payload(std::min<long>(points,
+                INLINE_CHUNK_POINTS));
+        for (long received = 0; received < points;) {
+            long chunk = std::min<long>(points - received, payload.size());
+            if (!stream.read(&payload[0], chunk * sizeof (wirePoint)))
+                return false;
+            for (long i = 0; i < chunk; ++i) {
+                PointLCT p;
+                p.x = payload[i].x;
+                p.y = payload[i].y;
+                p.z = payload[i].z;
+                p.rgba = payload[i].rgba;
+                p.label = payload[i].label;
+                input->points.push_back(p);
+            }
+            received += chunk;
+        }
+        input->width = points;
+        input->height = 1;
+    } else if (!Segmenter::load(tokens[1], input, normals)) {
+        stream.write_line("ERROR Cannot load PCD file '" + tokens[1] + "'");
+        return false;
+    }
+
+    // Parse the arguments as if they were given on the command line
+    std::vector<char *> argv;
+    argv.push_back(&tokens[0][0]);
+    std::string job_key;
+    for (size_t i = 2; i < tokens.size(); ++i) {
+        argv.push_back(&tokens[i][0]);
+        job_key += tokens[i] + " ";
+    }
+    segmenterParameters params;
+    if (!Segmenter::parse_arguments(argv.size(), &argv[0], params)) {
+        stream.write_line("ERROR Invalid arguments");
+        return false;
+    }
+
+    if (!segmenter || job_key != key) {
+        if (segmenter)
+            release(key, segmenter);
+        segmenter = acquire(job_key, params);
+        key = job_key;
+    }
+
+    pcl::StopWatch watch;
+    frameResult result;
+    try {
+        result = segmenter->process(input, normals);
+    } catch (std::exception &e) {
+        stream.write_line(std::string("ERROR ") + e.what());
+        return false;
+    }
+    double time = watch.getTime();
+
+    PointLCloudT::Ptr labels = result.labeled_voxel_cloud;
+    std::vector<wireLabel> reply_labels(labels->size());
+    std::set<uint32_t> segments;
+    for (size_t i = 0; i < labels->size(); ++i) {
+        const PointLT &p = labels->points[i];
+        reply_labels[i].x = p.x;
+        reply_labels[i].y = p.y;
+        reply_labels[i].z = p.z;
+        reply_labels[i].label = p.label;
+        segments.insert(p.label);
+    }
+
+    std::ostringstream reply;
+    performanceSet perf = result.performance;
+    reply << "OK " << labels->size() << " " << segments.size() << " "
+            << result.threshold << " " << perf.precision << " "
+            << perf.recall << " " << perf.fscore << " " << perf.voi << " "
+            << perf.wov << " " << time;
+    return stream.write_line(reply.str()) && (reply_labels.empty()
+            || stream.write(&reply_labels[0],
+            reply_labels.size() * sizeof (wireLabel)));
+}
+
+/**
+ * Take a cached segmenter with the given parameters, or create one running its
+ * stages on the stage pool if none is available
+ * 
+ * @param key       the arguments the parameters were parsed from
+ * @param params    the segmenter parameters
+ * 
+ * @return the segmenter
+ */
+boost::shared_ptr<Segmenter> SegmentationServer::acquire(
+        const std::string &key, const segmenterParameters &params) {
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        std::list<std::pair<std::string, boost::shared_ptr<Segmenter> > >::
+        iterator it = idle_segmenters.begin();
+        for (; it != idle_segmenters.end(); ++it) {
+            if (it->first != key)
+                continue;
+            boost::shared_ptr<Segmenter> segmenter = it->second;
+            idle_segmenters.erase(it);
+            return segmenter;
+        }
+    }
+    boost::shared_ptr<Segmenter> segmenter(new Segmenter(params));
+    segmenter->set_thread_pool(&stage_pool);
+    return segmenter;
+}
+
+/**
+ * Return a segmenter to the cache, forgetting the frames it processed; if the
+ * cache is full, the least recently used segmenter is dropped
+ * 
+ * @param key       the arguments the segmenter parameters were parsed from
+ * @param segmenter the segmenter
+ */
+void SegmentationServer::release(const std::string &key,
+        boost::shared_ptr<Segmenter> segmenter) {
+    segmenter->reset();
+    boost::mutex::scoped_lock lock(mutex);
+    idle_segmenters.push_front(std::make_pair(key, segmenter));
+    if (idle_segmenters.size() > max_idle)
+        idle_segmenters.pop_back();
+}
@@ -0,0 +1,929 @@
+/*
+ * segmenter.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/PCLPointCloud2.h>
+#include <pcl/common/io.h>
+#include <pcl/console/parse.h>
+#include <pcl/conversions.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/kdtree/kdtree_flann.h>
+
+#include "supervoxel_clustering/label_file.h"
+#include "supervoxel_clustering/segmenter.h"
+#include "supervoxel_clustering/task_graph.h"
+
+namespace {
+/*
+ * Label of a point of an input pointcloud: points without a label field all
+ * belong to the same groundtruth segment
+ */
+inline uint32_t point_label(const PointLCT &p) {
+    return p.label;
+}
+
+template <typename PointInT>
+inline uint32_t point_label(const PointInT &) {
+    return 0;
+}
+}
+
+/**
+ * Prepare a loaded pointcloud for the segmentation, fixing negative depths and
+ * removing the points belonging to the label to be removed (if any) and the
+ * points outside of the region of interest (if any). The points are read 
+ * straight from the input type, which is split in one pass into the colored
+ * pointcloud and its groundtruth.
+ * 
+ * @param input         the loaded pointcloud, of any point type having a 
+ *                      color field; points without a label get label 0
+ * @param input_normals the normals of the loaded pointcloud, or an empty 
+ *                      pointer if it has none
+ * @param cloud         the colored pointcloud to be segmented
+ * @param normals       the normals of the pointcloud to be segmented, empty
+ *                      if the loaded pointcloud has none; invalid normals are
+ *                      set to zero, so that they are ignored when averaged
+ * @param truth         the labelled pointcloud to be used as groundtruth
+ * @param indices       the vector in which the index in the input of each 
+ *                      point kept is written
+ */
+template <typename PointInT>
+void Segmenter::preprocess(pcl::PointCloud<PointInT> &input,
+        NormalCloudT::ConstPtr input_normals, PointCloudT::Ptr cloud,
+        NormalCloudT::Ptr normals, PointLCloudT::Ptr truth,
+        std::vector<int> &indices) const {
+    bool has_label = true; //TODO should be false
+    bool has_normals = input_normals
+            && input_normals->size() == input.size();
+
+    cloud->clear();
+    normals->clear();
+    truth->clear();
+    indices.clear();
+    for (size_t i = 0; i < input.size(); ++i) {
+        PointInT &in = input[i];
+        uint32_t label = point_label(in);
+        if (in.z < 0) {
+            pcl::console::print_debug(
+                    "Found point with z<0, setting to absolute value\n");
+            in.z = std::abs(in.z);
+        }
+        /*
+         * TODO 
+         * this doesn't work if label = 0 exists and is the one to be
+         * removed
+         */
+        if (!has_label && label != 0) {
+            pcl::console::print_debug("Found label data, evaluation is going "
+                    "to be performed\n");
+            has_label = true;
+        }
+        if (params.roi_specified && !params.roi.contains(in.x, in.y, in.z))
+            continue;
+        if (!has_label || !params.remove_label
+                || (label != params.label_to_be_removed
+                && !std::isnan(in.z))) {
+            PointT p;
+            p.x = in.x;
+            p.y = in.y;
+            p.z = in.z;
+            p.rgba = in.rgba;
+            cloud->push_back(p);
+            PointLT l;
+            l.x = in.x;
+            l.y = in.y;
+            l.z = in.z;
+            l.label = label;
+            truth->push_back(l);
+            indices.push_back(i);
+            if (has_normals) {
+                Normal n = (*input_normals)[i];
+                if (!std::isfinite(n.normal_x) || !std::isfinite(n.normal_y)
+                        || !std::isfinite(n.normal_z)
+                        || !std::isfinite(n.curvature))
+                    n.normal_x = n.normal_y = n.normal_z = n.curvature = 0;
+                normals->push_back(n);
+            }
+        }
+    }
+    cloud->width = truth->width = cloud->size();
+    cloud->height = truth->height = 1;
+    normals->width = normals->size();
+    normals->height = 1;
+}
+
+/**
+ * Prepare a frame read from shared memory for the segmentation, copying its
+ * points straight into the segmentation workspace; invalid points and points
+ * outside of the region of interest (if any) are skipped and negative depths
+ * are fixed
+ * 
+ * @param points    the points of the frame
+ * @param size      the number of points
+ * @param cloud     the colored pointcloud to be segmented
+ * @param truth     the labelled pointcloud to be used as groundtruth, where
+ *                  all points get label 0
+ * @param indices   the vector in which the index in the frame of each point 
+ *                  kept is written
+ */
+void Segmenter::preprocess(const shmPoint *points, size_t size,
+        PointCloudT::Ptr cloud, PointLCloudT::Ptr truth,
+        std::vector<int> &indices) const {
+    cloud->clear();
+    truth->clear();
+    indices.clear();
+    cloud->reserve(size);
+    truth->reserve(size);
+    indices.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        const shmPoint &in = points[i];
+        if (std::isnan(in.x) || std::isnan(in.y) || std::isnan(in.z))
+            continue;
+        PointT p;
+        p.x = in.x;
+        p.y = in.y;
+        p.z = std::abs(in.z);
+        if (params.roi_specified && !params.roi.contains(p.x, p.y, p.z))
+            continue;
+        p.rgba = in.rgba;
+        cloud->push_back(p);
+        PointLT l;
+        l.x = p.x;
+        l.y = p.y;
+        l.z = p.z;
+        l.label = 0;
+        truth->push_back(l);
+        indices.push_back(i);
+    }
+    cloud->width = truth->width = cloud->size();
+    cloud->height = truth->height = 1;
+}
+
+/**
+ * Apply the supervoxel parameters to a supervoxel extraction
+ * 
+ * @param super     the supervoxel extraction
+ * @param cloud     the pointcloud to be oversegmented
+ * @param normals   the normals of the pointcloud, averaged in each voxel 
+ *                  instead of being estimated; if empty, they are estimated
+ */
+void Segmenter::init_supervoxels(pcl::SupervoxelClustering<PointT> &super,
+        PointCloudT::Ptr cloud, NormalCloudT::ConstPtr normals) const {
+    super.setUseSingleCameraTransform(!params.disable_transform);
+    super.setInputCloud(cloud);
+    if (normals && !normals->empty())
+        super.setNormalCloud(normals);
+    super.setColorImportance(params.color_importance);
+    super.setSpatialImportance(params.spatial_importance);
+    super.setNormalImportance(params.normal_importance);
+}
+
+/**
+ * Voxelize the groundtruth with the same voxel grid used for the segmentation
+ * 
+ * @param truth         the labelled groundtruth
+ * @param planes        the planes extracted from the pointcloud, whose 
+ *                      voxelized groundtruth is added
+ * @param voxel_truth   the pointcloud in which the voxelized labelled 
+ *                      groundtruth is written
+ * @param colored_truth the pointcloud in which the voxelized groundtruth, 
+ *                      colored according to its labels, is written
+ */
+void Segmenter::voxelize_truth(PointLCloudT::Ptr truth,
+        const std::vector<planeSegment> &planes, PointLCloudT &voxel_truth,
+        PointCloudT::Ptr colored_truth) const {
+    Clustering::label2color(*truth, *colored_truth, pool);
+    if (!truth->empty()) {
+        pcl::SupervoxelClustering<PointT> super_label(params.voxel_resolution,
+                params.seed_resolution);
+        init_supervoxels(super_label, colored_truth, normal_cloud);
+        ClusteringT supervoxel_label_clusters;
+        super_label.extract(supervoxel_label_clusters);
+        *colored_truth = *(super_label.getVoxelCentroidCloud());
+    }
+    std::vector<planeSegment>::const_iterator p_it = planes.begin();
+    for (; p_it != planes.end(); ++p_it) {
+        Clustering::label2color(*(p_it->truth_voxels), *plane_colors);
+        *colored_truth += *plane_colors;
+    }
+    Clustering::color2label(*colored_truth, voxel_truth);
+    Clustering::label2color(voxel_truth, *colored_truth, pool);
+}
+
+/**
+ * Apply the segmentation parameters to a clustering
+ * 
+ * @param segmentation  the clustering
+ */
+void Segmenter::init_clustering(Clustering &segmentation) const {
+    segmentation.set_thread_pool(pool);
+    segmentation.set_delta_c(params.delta_c);
+    segmentation.set_delta_g(params.delta_g);
+    segmentation.set_merging(params.merging);
+    if (params.merging == MANUAL_LAMBDA && params.lambda != 0)
+        segmentation.set_lambda(params.lambda);
+    else if (params.merging == EQUALIZATION && params.bins_num != 0)
+        segmentation.set_bins_num(params.bins_num);
+}
+
+/**
+ * Extract the supervoxels of a pointcloud
+ * 
+ * @param cloud     the pointcloud to be oversegmented
+ * @param normals   the normals of the pointcloud, or an empty pointcloud to
+ *                  estimate them
+ * @param result    the frame results, where supervoxels, voxel centroids and
+ *                  supervoxel normals are stored
+ * @param adjacency the adjacency between the extracted supervoxels
+ * @param labels    the supervoxel label of each point of the pointcloud
+ */
+void Segmenter::extract_supervoxels(PointCloudT::Ptr cloud,
+        NormalCloudT::ConstPtr normals, frameResult &result,
+        AdjacencyMapT &adjacency, PointLCloudT::Ptr labels) {
+    boost::shared_ptr<pcl::SupervoxelClustering<PointT> > super;
+    pcl::console::print_info("Extracting supervoxels...\n");
+    if (params.temporal) {
+        boost::shared_ptr<SeededSupervoxelClustering> seeded(
+                new SeededSupervoxelClustering(params.voxel_resolution,
+                params.seed_resolution));
+        init_supervoxels(*seeded, cloud, normals);
+        seeded->set_previous_centroids(
+                temporal_cache.get_previous_centroids());
+        seeded->extract(result.supervoxels);
+        super = seeded;
+    } else {
+        super.reset(new pcl::SupervoxelClustering<PointT>(
+                params.voxel_resolution, params.seed_resolution));
+        init_supervoxels(*super, cloud, normals);
+        super->extract(result.supervoxels);
+    }
+    pcl::console::print_info("Found %zu supervoxels\n",
+            result.supervoxels.size());
+    result.voxel_centroid_cloud = super->getVoxelCentroidCloud();
+
+    pcl::console::print_info("Getting supervoxel adjacency...\n");
+    super->getSupervoxelAdjacency(adjacency);
+    *labels = *(super->getLabeledCloud());
+
+    ClusteringT refined_supervoxel_clusters;
+    pcl::console::print_info("Refining supervoxels...\n");
+    super->refineSupervoxels(3, refined_supervoxel_clusters);
+    result.refined_normal_cloud = super->makeSupervoxelNormalCloud(
+            refined_supervoxel_clusters);
+}
+
+/**
+ * Extract the supervoxels of a pointcloud, segmenting only the points which 
+ * changed with respect to the background and carrying over the background 
+ * supervoxels for all the others
+ * 
+ * @param cloud     the pointcloud to be oversegmented
+ * @param result    the frame results, where supervoxels, voxel centroids and
+ *                  supervoxel normals are stored
+ * @param adjacency the adjacency between the extracted supervoxels
+ */
+void Segmenter::extract_changed_supervoxels(PointCloudT::Ptr cloud,
+        frameResult &result, AdjacencyMapT &adjacency) {
+    pcl::console::print_info("Comparing with background...\n");
+    std::vector<int> changed_indices;
+    PointCloudT::Ptr changed_cloud = background.classify(cloud,
+            changed_indices);
+    result.background = background.get_stats();
+
+    if (!changed_cloud->empty()) {
+        // The given normals, if any, are kept for the changed points only
+        NormalCloudT::Ptr changed_normals = boost::make_shared<NormalCloudT>();
+        if (!normal_cloud->empty()) {
+            changed_normals->reserve(changed_indices.size());
+            std::vector<int>::const_iterator it = changed_indices.begin();
+            for (; it != changed_indices.end(); ++it)
+                changed_normals->push_back((*normal_cloud)[*it]);
+        }
+        extract_supervoxels(changed_cloud, changed_normals, result,
+                adjacency, supervoxel_labels);
+    } else {
+        result.voxel_centroid_cloud = boost::make_shared<PointCloudT>();
+        result.refined_normal_cloud = boost::make_shared<PointNCloudT>();
+    }
+
+    ClusteringT carried = background.get_carried();
+    ClusteringT::iterator c_it = carried.begin();
+    for (; c_it != carried.end(); ++c_it)
+        *(result.voxel_centroid_cloud) += *(c_it->second->voxels_);
+    *(result.refined_normal_cloud) +=
+            *(pcl::SupervoxelClustering<PointT>::makeSupervoxelNormalCloud(
+            carried));
+
+    background.link(result.supervoxels, adjacency);
+    pcl::console::print_info("Linked %zu carried and %zu new supervoxels\n",
+            carried.size(), result.supervoxels.size() - carried.size());
+}
+
+/**
+ * Record the number of heap allocations performed by a processing stage
+ * 
+ * @param result        the frame results, where the count is stored
+ * @param stage         the name of the stage
+ * @param allocations   the allocations counted at the beginning of the stage,
+ *                      updated with the current count
+ */
+void Segmenter::count_allocations(frameResult &result, std::string stage,
+        size_t &allocations) const {
+    if (!allocation_counter)
+        return;
+    size_t current = allocation_counter();
+    result.allocations.push_back(std::pair<std::string, size_t>(stage,
+            current - allocations));
+    allocations = current;
+}
+
+/**
+ * Record the number of heap allocations performed by a stage of the frame
+ * being processed; when stages run in parallel, each count includes the 
+ * allocations of the stages overlapping it
+ * 
+ * @param job   the state of the frame being processed
+ * @param stage the name of the stage
+ */
+void Segmenter::count_allocations(frameJob *job, std::string stage) const {
+    boost::mutex::scoped_lock lock(job->mutex);
+    count_allocations(*job->result, stage, job->allocations);
+}
+
+/**
+ * Constructor for the Segmenter class
+ * 
+ * @param p the parameters of the segmentation
+ */
+Segmenter::Segmenter(segmenterParameters p) :
+background(p.voxel_resolution, p.background_tolerance, !p.disable_transform) {
+    params = p;
+    allocation_counter = NULL;
+    pool = NULL;
+    cloud = boost::make_shared<PointCloudT>();
+    normal_cloud = boost::make_shared<NormalCloudT>();
+    truth_cloud = boost::make_shared<PointLCloudT>();
+    supervoxel_labels = boost::make_shared<PointLCloudT>();
+    plane_colors = boost::make_shared<PointCloudT>();
+    job.result = NULL;
+    job.voxel_truth_cloud = boost::make_shared<PointLCloudT>();
+    job.allocations = 0;
+}
+
+/**
+ * Segment a pointcloud and evaluate the result against its labels
+ * 
+ * @param input     a pointcloud with labels
+ * @param normals   the normals of the pointcloud, as given by the sensor; if
+ *                  given, they are used instead of estimating new ones
+ * 
+ * @return the segmentation results
+ */
+frameResult Segmenter::process(PointLCCloudT::Ptr input,
+        NormalCloudT::ConstPtr normals) {
+    frameResult result;
+    process(*input, normals, result);
+    return result;
+}
+
+/**
+ * Segment a pointcloud and evaluate the result against its labels, reusing the
+ * memory of the results of a previous frame; explicitly instantiated for 
+ * PointXYZRGB, PointXYZRGBA and PointXYZRGBL, so that clouds of any of them
+ * are segmented without being converted first
+ * 
+ * @param input     a pointcloud, with labels if it has a label field
+ * @param normals   the normals of the pointcloud, as given by the sensor; if
+ *                  given, they are used instead of estimating new ones
+ * @param result    the results of a previous frame, or empty results, 
+ *                  overwritten with the segmentation results
+ */
+template <typename PointInT>
+void Segmenter::process(pcl::PointCloud<PointInT> &input,
+        NormalCloudT::ConstPtr normals, frameResult &result) {
+    size_t allocations = (allocation_counter) ? allocation_counter() : 0;
+    result.allocations.clear();
+
+    preprocess(input, normals, cloud, normal_cloud, truth_cloud,
+            result.point_indices);
+
+    pcl::console::print_info("Pointcloud loaded\n");
+    count_allocations(result, "preprocessing", allocations);
+
+    segment(result, allocations);
+}
+
+/**
+ * Segment a frame read from shared memory; as the frame has no labels, the
+ * evaluation results are not meaningful
+ * 
+ * @param points    the points of the frame
+ * @param size      the number of points
+ * 
+ * @return the segmentation results
+ */
+frameResult Segmenter::process(const shmPoint *points, size_t size) {
+    frameResult result;
+    process(points, size, result);
+    return result;
+}
+
+/**
+ * Segment a frame read from shared memory, reusing the memory of the results
+ * of a previous frame; as the frame has no labels, the evaluation results are
+ * not meaningful
+ * 
+ * @param points    the points of the frame
+ * @param size      the number of points
+ * @param result    the results of a previous frame, or empty results, 
+ *                  overwritten with the segmentation results
+ */
+void Segmenter::process(const shmPoint *points, size_t size,
+        frameResult &result) {
+    size_t allocations = (allocation_counter) ? allocation_counter() : 0;
+    result.allocations.clear();
+
+    preprocess(points, size, cloud, truth_cloud, result.point_indices);
+    normal_cloud->clear();
+
+    pcl::console::print_info("Pointcloud received\n");
+    count_allocations(result, "preprocessing", allocations);
+
+    segment(result, allocations);
+}
+
+/**
+ * Build the task graph of the stages of a frame: the dominant planes are 
+ * extracted first, if enabled, then the groundtruth is voxelized while 
+ * supervoxels are extracted, and the segmentation is colored while it is 
+ * evaluated and, if requested, its whole hierarchy is recorded. The graph is 
+ * built once and run for each frame.
+ */
+void Segmenter::build_graph() {
+    graph.reset(new TaskGraph(pool));
+    std::vector<size_t> deps;
+    if (params.planes_num > 0)
+        deps.push_back(graph->add_task("planes",
+            boost::bind(&Segmenter::planes_stage, this, &job)));
+    size_t supervoxels = graph->add_task("supervoxels",
+            boost::bind(&Segmenter::extract_stage, this, &job), deps);
+    size_t truth = graph->add_task("groundtruth",
+            boost::bind(&Segmenter::truth_stage, this, &job), deps);
+    deps.clear();
+    deps.push_back(supervoxels);
+    if (!params.thresh_specified)
+        deps.push_back(truth);
+    size_t clustering = graph->add_task("clustering",
+            boost::bind(&Segmenter::clustering_stage, this, &job), deps);
+    graph->add_task("coloring",
+            boost::bind(&Segmenter::coloring_stage, this, &job),
+            std::vector<size_t>(1, clustering));
+    if (params.hierarchy)
+        graph->add_task("hierarchy",
+            boost::bind(&Segmenter::hierarchy_stage, this, &job),
+            std::vector<size_t>(1, clustering));
+    deps.clear();
+    deps.push_back(clustering);
+    deps.push_back(truth);
+    graph->add_task("testing",
+            boost::bind(&Segmenter::testing_stage, this, &job), deps);
+}
+
+/**
+ * Run supervoxel extraction, clustering and evaluation on the preprocessed 
+ * pointcloud, as the stages of a task graph; if a thread pool is set, 
+ * independent stages run in parallel. The results of the previous frame are
+ * cleared, keeping their memory.
+ * 
+ * @param result        the frame results, filled by the segmentation
+ * @param allocations   the allocations counted so far, updated after each
+ *                      stage
+ */
+void Segmenter::segment(frameResult &result, size_t &allocations) {
+    result.supervoxels.clear();
+    result.all_performances.clear();
+    result.performance = performanceSet();
+    result.threshold = 0;
+    result.temporal = temporalStats();
+    result.background = backgroundStats();
+    result.hierarchy_merges.clear();
+    job.result = &result;
+    job.adjacency.clear();
+    job.planes.clear();
+    job.allocations = allocations;
+
+    if (!graph)
+        build_graph();
+    graph->run();
+
+    graph->get_timings(result.timings);
+    allocations = job.allocations;
+}
+
+/**
+ * Extract the dominant planes of the frame, removing their points from the
+ * pointcloud to be oversegmented and from its groundtruth
+ * 
+ * @param job   the state of the frame being processed
+ */
+void Segmenter::planes_stage(frameJob *job) {
+    pcl::console::print_info("Extracting planes...\n");
+    PlaneExtractor extractor(params.voxel_resolution, params.planes_num);
+    extractor.set_thread_pool(pool);
+    extractor.extract(cloud, truth_cloud, job->planes, normal_cloud);
+    pcl::console::print_info("Found %zu planes, %zu points left\n",
+            job->planes.size(), cloud->size());
+    count_allocations(job, "planes");
+}
+
+/**
+ * Extract the supervoxels of the frame, or only of its changed part if the
+ * background mode is enabled; the extracted planes, if any, are added as 
+ * supervoxels without neighbors
+ * 
+ * @param job   the state of the frame being processed
+ */
+void Segmenter::extract_stage(frameJob *job) {
+    frameResult &result = *job->result;
+    if (params.background && background.has_background()) {
+        extract_changed_supervoxels(cloud, result, job->adjacency);
+    } else if (cloud->empty()) {
+        result.voxel_centroid_cloud = boost::make_shared<PointCloudT>();
+        result.refined_normal_cloud = boost::make_shared<PointNCloudT>();
+    } else {
+        extract_supervoxels(cloud, normal_cloud, result, job->adjacency,
+                supervoxel_labels);
+        if (params.background) {
+            pcl::console::print_info("Caching background segmentation...\n");
+            background.set_background(cloud, supervoxel_labels,
+                    result.supervoxels, job->adjacency);
+        }
+    }
+    if (!job->planes.empty()) {
+        ClusteringT planes;
+        PlaneExtractor::add_segments(job->planes, planes);
+        uint32_t offset = (result.supervoxels.empty()) ? 0
+                : result.supervoxels.rbegin()->first;
+        ClusteringT::iterator p_it = planes.begin();
+        for (; p_it != planes.end(); ++p_it) {
+            result.supervoxels.insert(std::pair<uint32_t, SupervoxelT::Ptr>(
+                    p_it->first + offset, p_it->second));
+            *(result.voxel_centroid_cloud) += *(p_it->second->voxels_);
+        }
+        *(result.refined_normal_cloud) +=
+                *(pcl::SupervoxelClustering<PointT>::makeSupervoxelNormalCloud(
+                planes));
+    }
+    count_allocations(job, "supervoxels");
+}
+
+/**
+ * Voxelize the groundtruth of the frame
+ * 
+ * @param job   the state of the frame being processed
+ */
+void Segmenter::truth_stage(frameJob *job) {
+    frameResult &result = *job->result;
+    if (!result.colored_truth_cloud)
+        result.colored_truth_cloud = boost::make_shared<PointCloudT>();
+    voxelize_truth(truth_cloud, job->planes, *job->voxel_truth_cloud,
+            result.colored_truth_cloud);
+    count_allocations(job, "groundtruth");
+}
+
+/**
+ * Cluster the supervoxels of the frame, choosing the best threshold against
+ * the groundtruth if no threshold was given
+ * 
+ * @param job   the state of the frame being processed
+ */
+void Segmenter::clustering_stage(frameJob *job) {
+    frameResult &result = *job->result;
+    pcl::console::print_info("Segmentation initialization...\n");
+
+    init_clustering(segmentation);
+    segmentation.set_voxel_normals(!normal_cloud->empty());
+    if (params.temporal) {
+        temporal_cache.begin_frame(result.supervoxels);
+        segmentation.set_temporal_cache(&temporal_cache);
+    }
+    segmentation.set_initialstate(result.supervoxels, job->adjacency);
+    if (params.merging != EQUALIZATION)
+        pcl::console::print_debug("Lambda: %f\n", segmentation.get_lambda());
+
+    float thresh = params.thresh;
+    if (!params.thresh_specified) {
+        result.all_performances = segmentation.all_thresh(
+                job->voxel_truth_cloud, params.start_thresh,
+                params.end_thresh, params.step_thresh);
+        std::pair<float, performanceSet> best = segmentation.best_thresh(
+                result.all_performances);
+        pcl::console::print_info(
+                "Using best threshold: %f (F-score %f, voi %f)\n",
+                best.first, best.second.fscore, best.second.voi);
+        thresh = best.first;
+    }
+
+    pcl::console::print_info(
+            "Initialization complete\nStarting clustering...\n");
+
+    segmentation.cluster(thresh);
+    pcl::console::print_info("Clustering complete\n");
+    if (params.temporal) {
+        result.temporal = temporal_cache.get_stats();
+        temporal_cache.end_frame();
+    }
+
+    if (!result.labeled_voxel_cloud)
+        result.labeled_voxel_cloud = boost::make_shared<PointLCloudT>();
+    segmentation.get_labeled_cloud(*result.labeled_voxel_cloud);
+    segmentation.get_adjacency(result.adjacency);
+    result.threshold = thresh;
+    count_allocations(job, "clustering");
+}
+
+/**
+ * Record the whole hierarchy of the clustering of the frame
+ * 
+ * @param job   the state of the frame being processed
+ */
+void Segmenter::hierarchy_stage(frameJob *job) {
+    frameResult &result = *job->result;
+    result.hierarchy_state = segmentation.get_initialstate();
+    segmentation.hierarchy(result.hierarchy_merges);
+    count_allocations(job, "hierarchy");
+}
+
+/**
+ * Color the segmentation of the frame according to its labels
+ * 
+ * @param job   the state of the frame being processed
+ */
+void Segmenter::coloring_stage(frameJob *job) {
+    frameResult &result = *job->result;
+    if (!result.colored_voxel_cloud)
+        result.colored_voxel_cloud = boost::make_shared<PointCloudT>();
+    Clustering::label2color(*result.labeled_voxel_cloud,
+            *result.colored_voxel_cloud, pool);
+    count_allocations(job, "coloring");
+}
+
+/**
+ * Evaluate the segmentation of the frame against its groundtruth
+ * 
+ * @param job   the state of the frame being processed
+ */
+void Segmenter::testing_stage(frameJob *job) {
+    pcl::console::print_info("Initializing testing suite...\n");
+    test.set_clouds(job->result->labeled_voxel_cloud, job->voxel_truth_cloud);
+    job->result->performance = test.eval_performance();
+    count_allocations(job, "testing");
+}
+
+/**
+ * Get the label of each point of a processed pointcloud, in the order of its
+ * points, from the label of the nearest voxel of the segmentation; points 
+ * that were not segmented get LABEL_NONE. Explicitly instantiated for the 
+ * same point types as 'process'.
+ * 
+ * @param input     the pointcloud given to 'process'
+ * @param result    the results of 'process' on the pointcloud
+ * @param labels    the vector in which the labels are written
+ */
+template <typename PointInT>
+void Segmenter::point_labels(const pcl::PointCloud<PointInT> &input,
+        const frameResult &result, std::vector<uint32_t> &labels) const {
+    labels.assign(input.size(), LABEL_NONE);
+    PointLCloudT::ConstPtr labeled_voxels = result.labeled_voxel_cloud;
+    if (!labeled_voxels || labeled_voxels->empty())
+        return;
+    pcl::KdTreeFLANN<PointLT> voxel_tree;
+    voxel_tree.setInputCloud(labeled_voxels);
+    std::vector<int> k_indices(1);
+    std::vector<float> k_sqr_dists(1);
+    PointLT query;
+    std::vector<int>::const_iterator index_itr = result.point_indices.begin();
+    for (; index_itr != result.point_indices.end(); ++index_itr) {
+        const PointInT &p = input[*index_itr];
+        if (!std::isfinite(p.x) || !std::isfinite(p.y)
+                || !std::isfinite(p.z))
+            continue;
+        query.x = p.x;
+        query.y = p.y;
+        query.z = p.z;
+        if (voxel_tree.nearestKSearch(query, 1, k_indices, k_sqr_dists) > 0)
+            labels[*index_itr] = (*labeled_voxels)[k_indices[0]].label;
+    }
+}
+
+/**
+ * Forget all previously processed frames
+ */
+void Segmenter::reset() {
+    temporal_cache.clear();
+    background.clear();
+}
+
+/**
+ * Parse the segmentation parameters from a list of command line arguments
+ * 
+ * @param argc      the number of arguments
+ * @param argv      the arguments
+ * @param params    the parameters, updated with the given arguments
+ * 
+ * @return true if the arguments are valid, false otherwise
+ */
+bool Segmenter::parse_arguments(int argc, char **argv,
+        segmenterParameters &params) {
+    params.thresh_specified = pcl::console::find_switch(argc, argv, "-t");
+
+    if (params.thresh_specified) {
+        pcl::console::parse_argument(argc, argv, "-t", params.thresh);
+        pcl::console::print_debug("Using threshold: %f\n", params.thresh);
+    } else {
+        pcl::console::print_debug("Using automatic threshold\n");
+    }
+
+    // Supervoxel segmentation parameters
+    params.disable_transform = pcl::console::find_switch(argc, argv, "--NT");
+
+    if (pcl::console::find_switch(argc, argv, "-v"))
+        pcl::console::parse(argc, argv, "-v", params.voxel_resolution);
+
+    if (pcl::console::find_switch(argc, argv, "-s"))
+        pcl::console::parse(argc, argv, "-s", params.seed_resolution);
+
+    if (pcl::console::find_switch(argc, argv, "-c"))
+        pcl::console::parse(argc, argv, "-c", params.color_importance);
+
+    if (pcl::console::find_switch(argc, argv, "-z"))
+        pcl::console::parse(argc, argv, "-z", params.spatial_importance);
+
+    if (pcl::console::find_switch(argc, argv, "-n"))
+        pcl::console::parse(argc, argv, "-n", params.normal_importance);
+
+    // Segmentation parameters
+    bool rgb_color_space_specified = pcl::console::find_switch(argc, argv,
+            "--RGB");
+    bool convexity_specified = pcl::console::find_switch(argc, argv, "--CVX");
+    bool manual_lambda_specified = pcl::console::find_switch(argc, argv,
+            "--ML");
+    bool adapt_lambda_specified = pcl::console::find_switch(argc, argv,
+            "--AL");
+    bool equalization_specified = pcl::console::find_switch(argc, argv,
+            "--EQ");
+    if (!(manual_lambda_specified || adapt_lambda_specified
+            || equalization_specified)) {
+        adapt_lambda_specified = true;
+        pcl::console::print_debug("No merging criterion specified, Adaptive "
+                "Lambda is going to be used\n");
+    } else if (!(manual_lambda_specified ^ adapt_lambda_specified
+            ^ equalization_specified)) {
+        pcl::console::print_error("Only one parameter between --ML --AL and "
+                "--EQ can be specified at a time\n");
+        return false;
+    }
+
+    if (rgb_color_space_specified)
+        params.delta_c = RGB_EUCL;
+
+    if (convexity_specified)
+        params.delta_g = CONVEX_NORMALS_DIFF;
+
+    if (manual_lambda_specified) {
+        params.merging = MANUAL_LAMBDA;
+        pcl::console::parse_argument(argc, argv, "--ML", params.lambda);
+    } else if (equalization_specified) {
+        params.merging = EQUALIZATION;
+        pcl::console::parse_argument(argc, argv, "--EQ", params.bins_num);
+    }
+
+    params.remove_label = pcl::console::find_switch(argc, argv, "-r");
+    if (params.remove_label)
+        pcl::console::parse_argument(argc, argv, "-r",
+            params.label_to_be_removed);
+
+    params.temporal = pcl::console::find_switch(argc, argv, "--TW");
+
+    params.background = pcl::console::find_switch(argc, argv, "--BG");
+    if (params.background)
+        pcl::console::parse_argument(argc, argv, "--BG",
+            params.background_tolerance);
+
+    params.hierarchy = pcl::console::find_switch(argc, argv, "--HS");
+
+    if (pcl::console::find_switch(argc, argv, "--PL")) {
+        params.planes_num = 3;
+        pcl::console::parse_argument(argc, argv, "--PL", params.planes_num);
+        if (params.temporal || params.background) {
+            pcl::console::print_error(
+                    "--PL can't be used together with --TW or --BG\n");
+            return false;
+        }
+    }
+
+    params.roi_specified = pcl::console::find_switch(argc, argv, "--ROI");
+    if (params.roi_specified) {
+        std::string roi;
+        pcl::console::parse_argument(argc, argv, "--ROI", roi);
+        if (!RegionOfInterest::parse(roi, params.roi)) {
+            pcl::console::print_error("Invalid region of interest '%s'\n",
+                    roi.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Load a pointcloud from a PCD file
+ * 
+ * @param filename  the path of the PCD file
+ * @param input     the pointcloud in which the file is loaded
+ * @param normals   if given, the pointcloud in which the normals of the file
+ *                  are loaded, left empty if the file has no normals
+ * 
+ * @return true if the file was loaded, false otherwise
+ */
+bool Segmenter::load(std::string filename, PointLCCloudT::Ptr input,
+        NormalCloudT::Ptr normals) {
+    pcl::console::print_info("Loading pointcloud from PCD file '%s'...\n",
+            filename.c_str());
+    if (!normals) {
+        if (pcl::io::loadPCDFile(filename, *input) < 0) {
+            pcl::console::print_error("Cannot load PCD file '%s'\n",
+                    filename.c_str());
+            return false;
+        }
+        return true;
+    }
+    // The file is read once, and its normals are only converted if present
+    pcl::PCLPointCloud2 blob;
+    if (pcl::io::loadPCDFile(filename, blob) < 0) {
+        pcl::console::print_error("Cannot load PCD file '%s'\n",
+                filename.c_str());
+        return false;
+    }
+    pcl::fromPCLPointCloud2(blob, *input);
+    normals->clear();
+    if (pcl::getFieldIndex(blob, "normal_x") != -1) {
+        pcl::console::print_info("Using the normals of the file\n");
+        pcl::fromPCLPointCloud2(blob, *normals);
+    }
+    return true;
+}
+
+template void Segmenter::process<pcl::PointXYZRGB>(
+        pcl::PointCloud<pcl::PointXYZRGB> &, NormalCloudT::ConstPtr,
+        frameResult &);
+template void Segmenter::process<pcl::PointXYZRGBA>(
+        pcl::PointCloud<pcl::PointXYZRGBA> &, NormalCloudT::ConstPtr,
+        frameResult &);
+template void Segmenter::process<pcl::PointXYZRGBL>(
+        pcl::PointCloud<pcl::PointXYZRGBL> &, NormalCloudT::ConstPtr,
+        frameResult &);
+template void Segmenter::point_labels<pcl::PointXYZRGB>(
+        const pcl::PointCloud<pcl::PointXYZRGB> &, const frameResult &,
+        std::vector<uint32_t> &) const;
+template void Segmenter::point_labels<pcl::PointXYZRGBA>(
+        const pcl::PointCloud<pcl::PointXYZRGBA> &, const frameResult &,
+        std::vector<uint32_t> &) const;
+template void Segmenter::point_labels<pcl::PointXYZRGBL>(
+        const pcl::PointCloud<pcl::PointXYZRGBL> &, const frameResult &,
+        std::vector<uint32_t> &) const;
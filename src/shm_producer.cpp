@@ -0,0 +1,162 @@
+/*
+ * shm_producer.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+#include <pcl/common/time.h>
+#include <pcl/console/parse.h>
+#include <pcl/console/print.h>
+#include <pcl/io/pcd_io.h>
+
+#include "supervoxel_clustering/cloud_types.h"
+#include "supervoxel_clustering/file_list.h"
+#include "supervoxel_clustering/shm_ring_buffer.h"
+
+using namespace boost;
+using namespace pcl;
+
+int main(int argc, char ** argv) {
+    if (argc < 4) {
+        console::print_info(
+                "Syntax is: "
+                "%s <shm-name> {-d <direcory-of-pcd-files> OR -p <pcd-file>} "
+                "[arguments] \n"
+                "\n\t"
+                "Writes the given files as frames to the shared memory ring "
+                "buffer of 'supervoxel_clustering -m <shm-name>', which has "
+                "to be started first. \n\t"
+                "\n\t"
+                "PRODUCER optional arguments: \n\t"
+                " -r <frame-rate>                (default: 30) \n\t"
+                " -n <repetitions>               (default: 1) \n",
+                argv[0]);
+        return (1);
+    }
+
+    std::string name = argv[1];
+    std::string path;
+    std::vector<std::string> file_list;
+    if (console::find_switch(argc, argv, "-d")) {
+        console::parse(argc, argv, "-d", path);
+        if (!filesystem::exists(path) || !filesystem::is_directory(path)) {
+            console::print_error(
+                    "Specified directory doesn't exists or can't be opened\n");
+            return (1);
+        }
+        filesystem::recursive_directory_iterator it(path);
+        filesystem::recursive_directory_iterator end_it;
+        for (; it != end_it; ++it) {
+            if (filesystem::is_regular_file(*it)
+                    && it->path().extension() == ".pcd")
+                file_list.push_back(it->path().string());
+        }
+        FileList::sort(file_list);
+    } else if (console::find_switch(argc, argv, "-p")) {
+        console::parse(argc, argv, "-p", path);
+        file_list.push_back(path);
+    } else {
+        console::print_error("No input file or directory specified\n");
+        return (1);
+    }
+
+    float rate = 30;
+    int repetitions = 1;
+    if (console::find_switch(argc, argv, "-r"))
+        console::parse(argc, argv, "-r", rate);
+    if (console::find_switch(argc, argv, "-n"))
+        console::parse(argc, argv, "-n", repetitions);
+
+    // Frames are loaded in advance, so that disk reads don't limit the rate
+    std::vector<PointCloudT::Ptr> frames;
+    std::vector<std::string>::iterator file_it = file_list.begin();
+    for (; file_it != file_list.end(); ++file_it) {
+        PointCloudT::Ptr cloud(new PointCloudT);
+        if (pcl::io::loadPCDFile(*file_it, *cloud) < 0) {
+            console::print_error("Cannot load PCD file '%s'\n",
+                    file_it->c_str());
+            continue;
+        }
+        frames.push_back(cloud);
+    }
+    if (frames.empty()) {
+        console::print_error("No frames to be written\n");
+        return (1);
+    }
+
+    size_t written = 0, dropped = 0;
+    try {
+        ShmRingBuffer ring(name);
+        chrono::microseconds period((long) (1e6 / std::max(rate, 0.001f)));
+        chrono::steady_clock::time_point next = chrono::steady_clock::now();
+        StopWatch watch;
+        for (int r = 0; r < repetitions; ++r) {
+            std::vector<PointCloudT::Ptr>::iterator f_it = frames.begin();
+            for (; f_it != frames.end(); ++f_it) {
+                this_thread::sleep_until(next);
+                next += period;
+
+                PointCloudT &cloud = **f_it;
+                shmPoint *points = ring.begin_write();
+                if (points == NULL || cloud.size()
+                        > ring.get_slot_capacity()) {
+                    console::print_debug("Frame dropped\n");
+                    ++dropped;
+                    continue;
+                }
+                for (size_t i = 0; i < cloud.size(); ++i) {
+                    points[i].x = cloud.points[i].x;
+                    points[i].y = cloud.points[i].y;
+                    points[i].z = cloud.points[i].z;
+                    points[i].rgba = cloud.points[i].rgba;
+                }
+                ring.commit_write(cloud.size(), cloud.width, cloud.height);
+                ++written;
+            }
+        }
+        ring.close();
+        console::print_info("Written %zu frames, dropped %zu, in %f s\n",
+                written, dropped, watch.getTimeSeconds());
+    } catch (std::exception &e) {
+        console::print_error("%s\n", e.what());
+        return (1);
+    }
+
+    return (0);
+}
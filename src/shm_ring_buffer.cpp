@@ -0,0 +1,249 @@
+/*
+ * shm_ring_buffer.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "supervoxel_clustering/shm_ring_buffer.h"
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+        "The ring buffer needs lock-free 32 and 64 bit atomics to be shared "
+        "between processes");
+
+/**
+ * Compute the size of a slot
+ * 
+ * @param slot_capacity the maximum number of points of a frame
+ * 
+ * @return the size of the slot in bytes, rounded to whole cache lines
+ */
+static size_t slot_size(uint32_t slot_capacity) {
+    size_t size = sizeof (shmFrame) + slot_capacity * sizeof (shmPoint);
+    return (size + 63) / 64 * 64;
+}
+
+/**
+ * Map a shared memory object
+ * 
+ * @param fd    the descriptor of the object
+ * @param size  the size of the mapping
+ * 
+ * @return the address of the mapping
+ */
+static void * map_segment(int fd, size_t size) {
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+            0);
+    if (memory == MAP_FAILED)
+        throw std::runtime_error("Cannot map shared memory: "
+            + std::string(std::strerror(errno)));
+    return memory;
+}
+
+/**
+ * Constructor for the ShmRingBuffer class, creating a new shared memory
+ * segment; the segment is removed when the buffer is destroyed. An existing
+ * segment with the same name is never replaced, as another process may be
+ * using it.
+ * 
+ * @param shm_name      the name of the shared memory object (e.g. "/frames")
+ * @param slots         the number of frames the buffer can hold
+ * @param slot_capacity the maximum number of points of a frame
+ */
+ShmRingBuffer::ShmRingBuffer(std::string shm_name, uint32_t slots,
+        uint32_t slot_capacity) :
+name(shm_name), owner(true) {
+    if (slots == 0 || slot_capacity == 0)
+        throw std::invalid_argument("The ring buffer needs at least one slot "
+            "and a positive slot capacity");
+    size = sizeof (shmHeader) + slots * slot_size(slot_capacity);
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST)
+        throw std::runtime_error("Shared memory '" + name + "' already "
+            "exists: it may be in use by another process, or left by one "
+            "that crashed, in which case it has to be removed by hand");
+    if (fd < 0)
+        throw std::runtime_error("Cannot create shared memory '" + name
+            + "': " + std::strerror(errno));
+    if (ftruncate(fd, size) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::runtime_error("Cannot resize shared memory '" + name
+                + "': " + error);
+    }
+    memory = map_segment(fd, size);
+    ::close(fd);
+
+    header = new (memory) shmHeader;
+    header->slots = slots;
+    header->slot_capacity = slot_capacity;
+    header->version = SHM_VERSION;
+    header->closed.store(0, std::memory_order_relaxed);
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    // The magic number is written last, so that a producer opening the
+    // segment never sees it half initialized
+    header->magic.store(SHM_MAGIC, std::memory_order_release);
+}
+
+/**
+ * Constructor for the ShmRingBuffer class, opening an existing shared memory
+ * segment
+ * 
+ * @param shm_name  the name of the shared memory object
+ */
+ShmRingBuffer::ShmRingBuffer(std::string shm_name) :
+name(shm_name), owner(false) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open shared memory '" + name
+            + "': " + std::strerror(errno));
+    struct stat info;
+    if (fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof (shmHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid shared memory '" + name + "'");
+    }
+    size = info.st_size;
+    memory = map_segment(fd, size);
+    ::close(fd);
+
+    header = static_cast<shmHeader *> (memory);
+    if (header->magic.load(std::memory_order_acquire) != SHM_MAGIC
+            || header->version != SHM_VERSION
+            || size < sizeof (shmHeader)
+            + header->slots * slot_size(header->slot_capacity)) {
+        munmap(memory, size);
+        throw std::runtime_error("Invalid shared memory '" + name + "'");
+    }
+}
+
+/**
+ * Destructor for the ShmRingBuffer class
+ */
+ShmRingBuffer::~ShmRingBuffer() {
+    munmap(memory, size);
+    if (owner)
+        shm_unlink(name.c_str());
+}
+
+/**
+ * Get the frame header of a slot
+ * 
+ * @param index the index of the frame
+ * 
+ * @return the header of the slot holding the frame
+ */
+shmFrame * ShmRingBuffer::slot(uint64_t index) const {
+    char *slots = static_cast<char *> (memory) + sizeof (shmHeader);
+    return reinterpret_cast<shmFrame *> (slots
+            + (index % header->slots) * slot_size(header->slot_capacity));
+}
+
+/**
+ * Get the slot in which the next frame is to be written
+ * 
+ * @return the points of the free slot, or NULL if the buffer is full
+ */
+shmPoint * ShmRingBuffer::begin_write() {
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    if (head - tail >= header->slots)
+        return NULL;
+    return reinterpret_cast<shmPoint *> (slot(head) + 1);
+}
+
+/**
+ * Publish the frame written in the slot returned by begin_write
+ * 
+ * @param points    the number of points written
+ * @param width     the width of the frame
+ * @param height    the height of the frame
+ */
+void ShmRingBuffer::commit_write(uint32_t points, uint32_t width,
+        uint32_t height) {
+    if (points > header->slot_capacity)
+        throw std::invalid_argument("Frame larger than the slot capacity");
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    shmFrame *frame = slot(head);
+    frame->sequence = head;
+    frame->points = points;
+    frame->width = width;
+    frame->height = height;
+    header->head.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * Signal the consumer that no more frames will be written
+ */
+void ShmRingBuffer::close() {
+    header->closed.store(1, std::memory_order_release);
+}
+
+/**
+ * Get the oldest frame not yet read; its points stay valid until end_read is
+ * called
+ * 
+ * @param frame the header of the frame
+ * 
+ * @return the points of the frame, or NULL if the buffer is empty
+ */
+const shmPoint * ShmRingBuffer::begin_read(shmFrame &frame) {
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    if (tail == head)
+        return NULL;
+    shmFrame *s = slot(tail);
+    frame = *s;
+    return reinterpret_cast<const shmPoint *> (s + 1);
+}
+
+/**
+ * Give back to the producer the slot of the frame returned by begin_read
+ */
+void ShmRingBuffer::end_read() {
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    header->tail.store(tail + 1, std::memory_order_release);
+}
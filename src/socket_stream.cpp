@@ -0,0 +1,270 @@
+/*
+ * socket_stream.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "supervoxel_clustering/socket_stream.h"
+
+// Longest request line accepted, so that a peer that never sends a line
+// terminator can't make the buffer grow without bound
+#define MAX_LINE_LENGTH 65536
+
+/**
+ * Constructor for the SocketStream class
+ * 
+ * @param socket    a connected socket descriptor, owned by the stream
+ */
+SocketStream::SocketStream(int socket) :
+fd(socket) {
+}
+
+/**
+ * Destructor for the SocketStream class
+ */
+SocketStream::~SocketStream() {
+    close();
+}
+
+/**
+ * Close the socket, so that nothing else is read from or written to it; any
+ * data still buffered is dropped
+ */
+void SocketStream::close() {
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    buffer.clear();
+}
+
+/**
+ * Read a line of text, terminated by '\n'
+ * 
+ * @param line  the line read, without the terminator
+ * 
+ * @return true if a line was read, false if the connection was closed, an
+ * error occurred or the line is longer than MAX_LINE_LENGTH
+ */
+bool SocketStream::read_line(std::string &line) {
+    size_t end;
+    while ((end = buffer.find('\n')) == std::string::npos) {
+        if (fd < 0 || buffer.size() > MAX_LINE_LENGTH)
+            return false;
+        char chunk[4096];
+        ssize_t n = ::recv(fd, chunk, sizeof (chunk), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, n);
+    }
+    line = buffer.substr(0, end);
+    if (!line.empty() && line[line.size() - 1] == '\r')
+        line.erase(line.size() - 1);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+/**
+ * Read exactly the given number of bytes
+ * 
+ * @param data  the buffer in which the bytes are stored
+ * @param size  the number of bytes to be read
+ * 
+ * @return true if all the bytes were read, false otherwise
+ */
+bool SocketStream::read(void *data, size_t size) {
+    if (fd < 0)
+        return false;
+    char *out = static_cast<char *> (data);
+    size_t buffered = std::min(size, buffer.size());
+    buffer.copy(out, buffered);
+    buffer.erase(0, buffered);
+    size_t done = buffered;
+    while (done < size) {
+        ssize_t n = ::recv(fd, out + done, size - done, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+/**
+ * Write exactly the given number of bytes
+ * 
+ * @param data  the bytes to be written
+ * @param size  the number of bytes
+ * 
+ * @return true if all the bytes were written, false otherwise
+ */
+bool SocketStream::write(const void *data, size_t size) {
+    if (fd < 0)
+        return false;
+    const char *in = static_cast<const char *> (data);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::send(fd, in + done, size - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+/**
+ * Write a line of text, appending the '\n' terminator
+ * 
+ * @param line  the line to be written
+ * 
+ * @return true if the line was written, false otherwise
+ */
+bool SocketStream::write_line(const std::string &line) {
+    std::string terminated = line + "\n";
+    return write(terminated.data(), terminated.size());
+}
+
+/**
+ * Build the address of a Unix-domain socket
+ * 
+ * @param path  the filesystem path of the socket
+ * 
+ * @return the socket address
+ */
+static sockaddr_un socket_address(const std::string &path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof (address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof (address.sun_path))
+        throw std::invalid_argument("Socket path too long: " + path);
+    std::strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+/**
+ * Create a socket listening on the given path; a stale socket file left at
+ * that path is removed, while any other file, or a socket another server is
+ * listening on, is left in place and makes the call fail
+ * 
+ * @param path      the filesystem path of the socket
+ * @param backlog   the maximum number of pending connections
+ * 
+ * @return the listening socket descriptor
+ */
+int SocketStream::listen(const std::string &path, int backlog) {
+    sockaddr_un address = socket_address(path);
+    struct stat file;
+    if (::lstat(path.c_str(), &file) == 0) {
+        if (!S_ISSOCK(file.st_mode))
+            throw std::runtime_error("Cannot listen on '" + path
+                + "': the file exists and is not a socket");
+        int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        bool in_use = probe >= 0 && ::connect(probe,
+                reinterpret_cast<sockaddr *> (&address),
+                sizeof (address)) == 0;
+        if (probe >= 0)
+            ::close(probe);
+        if (in_use)
+            throw std::runtime_error("Cannot listen on '" + path
+                + "': another server is listening on it");
+        ::unlink(path.c_str());
+    }
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0)
+        throw std::runtime_error("Cannot create socket: "
+            + std::string(std::strerror(errno)));
+    if (::bind(server, reinterpret_cast<sockaddr *> (&address),
+            sizeof (address)) < 0 || ::listen(server, backlog) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(server);
+        throw std::runtime_error("Cannot listen on '" + path + "': " + error);
+    }
+    return server;
+}
+
+/**
+ * Wait for a connection on a listening socket
+ * 
+ * @param server    the listening socket descriptor
+ * 
+ * @return the connected socket descriptor, or -1 if the listening socket was
+ * closed
+ */
+int SocketStream::accept(int server) {
+    for (;;) {
+        int client = ::accept(server, NULL, NULL);
+        if (client >= 0)
+            return client;
+        if (errno != EINTR && errno != ECONNABORTED)
+            return -1;
+    }
+}
+
+/**
+ * Connect to a listening Unix-domain socket
+ * 
+ * @param path  the filesystem path of the socket
+ * 
+ * @return the connected socket descriptor
+ */
+int SocketStream::connect(const std::string &path) {
+    sockaddr_un address = socket_address(path);
+    int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client < 0)
+        throw std::runtime_error("Cannot create socket: "
+            + std::string(std::strerror(errno)));
+    if (::connect(client, reinterpret_cast<sockaddr *> (&address),
+            sizeof (address)) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(client);
+        throw std::runtime_error("Cannot connect to '" + path + "': " + error);
+    }
+    return client;
+}
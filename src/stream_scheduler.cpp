@@ -0,0 +1,284 @@
+/*
+ * stream_scheduler.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdexcept>
+
+#include <pcl/console/print.h>
+
+#include "supervoxel_clustering/stream_scheduler.h"
+
+/**
+ * Get the milliseconds elapsed since a time point
+ * 
+ * @param since the time point
+ * 
+ * @return the elapsed milliseconds
+ */
+static double elapsed_ms(ClockT::time_point since) {
+    return boost::chrono::duration<double, boost::milli>(ClockT::now()
+            - since).count();
+}
+
+/**
+ * Constructor for the StreamScheduler class
+ * 
+ * @param p         the segmentation parameters, shared by all streams
+ * @param workers   the number of frames segmented at the same time; if 0, one
+ *                  for each hardware core
+ */
+StreamScheduler::StreamScheduler(segmenterParameters p, size_t workers) :
+params(p), next_stream(0), processing(0), stopping(false), pool(workers) {
+    for (size_t i = 0; i < pool.size(); ++i)
+        pool.submit(boost::bind(&StreamScheduler::work, this));
+}
+
+/**
+ * Destructor for the StreamScheduler class
+ */
+StreamScheduler::~StreamScheduler() {
+    stop();
+}
+
+/**
+ * Add a stream to be scheduled
+ * 
+ * @param name      the name of the stream
+ * @param deadline  the maximum age in milliseconds of a frame when its 
+ *                  segmentation is completed; if 0, frames have no deadline
+ */
+void StreamScheduler::add_stream(std::string name, double deadline) {
+    boost::mutex::scoped_lock lock(mutex);
+    if (streams.count(name) != 0)
+        throw std::invalid_argument("Stream '" + name + "' already exists");
+    streamState &stream = streams[name];
+    stream.segmenter = boost::shared_ptr<Segmenter>(new Segmenter(params));
+    stream.deadline = deadline;
+    order.push_back(name);
+}
+
+/**
+ * Set a function to be called with the results of each segmented frame; it
+ * is called from the workers, so it has to be thread-safe
+ * 
+ * @param result_callback   the function to be called
+ */
+void StreamScheduler::set_callback(ResultCallbackT result_callback) {
+    boost::mutex::scoped_lock lock(mutex);
+    callback = result_callback;
+}
+
+/**
+ * Submit a new frame of a stream, replacing its waiting frame (if any)
+ * 
+ * @param name  the name of the stream
+ * @param frame the frame
+ */
+void StreamScheduler::submit(std::string name, PointLCCloudT::Ptr frame) {
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        std::map<std::string, streamState>::iterator it = streams.find(name);
+        if (it == streams.end())
+            throw std::invalid_argument("Unknown stream '" + name + "'");
+        streamState &stream = it->second;
+        ++stream.stats.submitted;
+        if (stream.pending)
+            ++stream.stats.replaced;
+        stream.pending = frame;
+        stream.pending_time = ClockT::now();
+    }
+    frame_available.notify_one();
+}
+
+/**
+ * Pick the next frame to be segmented, visiting the streams in round-robin
+ * order; frames past their deadline are dropped on the way
+ * 
+ * @param name  the name of the stream of the frame
+ * @param frame the frame
+ * @param time  the time the frame was submitted
+ * @param expired   set to true if any frame was dropped
+ * 
+ * @return true if a frame was found, false otherwise
+ */
+bool StreamScheduler::next_job(std::string &name, PointLCCloudT::Ptr &frame,
+        ClockT::time_point &time, bool &expired) {
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t index = (next_stream + i) % order.size();
+        streamState &stream = streams[order[index]];
+        if (stream.busy || !stream.pending)
+            continue;
+        if (stream.deadline > 0
+                && elapsed_ms(stream.pending_time) > stream.deadline) {
+            ++stream.stats.expired;
+            stream.pending.reset();
+            expired = true;
+            continue;
+        }
+        name = order[index];
+        frame = stream.pending;
+        time = stream.pending_time;
+        stream.pending.reset();
+        stream.busy = true;
+        next_stream = index + 1;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Loop executed by each worker: segment the frames picked by next_job until 
+ * the scheduler is stopped
+ */
+void StreamScheduler::work() {
+    boost::mutex::scoped_lock lock(mutex);
+    for (;;) {
+        std::string name;
+        PointLCCloudT::Ptr frame;
+        ClockT::time_point time;
+        bool expired = false;
+        while (!stopping && !next_job(name, frame, time, expired)) {
+            // Expired frames may have been dropped, so waiters are woken up
+            if (expired)
+                frame_done.notify_all();
+            frame_available.wait(lock);
+        }
+        if (stopping)
+            return;
+
+        streamState &stream = streams[name];
+        ++processing;
+        lock.unlock();
+        // A failed frame is only counted, so that the stream is released and
+        // the worker keeps serving the other streams
+        frameResult result;
+        bool failed = false;
+        try {
+            result = stream.segmenter->process(frame);
+        } catch (std::exception &e) {
+            pcl::console::print_error("Stream '%s': %s\n", name.c_str(),
+                    e.what());
+            failed = true;
+        }
+        double latency = elapsed_ms(time);
+        lock.lock();
+        if (callback && !failed) {
+            ResultCallbackT call = callback;
+            lock.unlock();
+            try {
+                call(name, result);
+            } catch (std::exception &e) {
+                pcl::console::print_error("Stream '%s': %s\n", name.c_str(),
+                        e.what());
+            }
+            lock.lock();
+        }
+
+        --processing;
+        stream.busy = false;
+        if (failed) {
+            ++stream.stats.failed;
+            frame_available.notify_one();
+            frame_done.notify_all();
+            continue;
+        }
+        ++stream.stats.processed;
+        stream.stats.total_latency += latency;
+        stream.stats.max_latency = std::max(stream.stats.max_latency,
+                latency);
+        if (stream.deadline > 0 && latency > stream.deadline)
+            ++stream.stats.deadline_misses;
+        // The stream may have received a frame while busy
+        frame_available.notify_one();
+        frame_done.notify_all();
+    }
+}
+
+/**
+ * Block until all the submitted frames have been segmented or dropped
+ */
+void StreamScheduler::wait() {
+    boost::mutex::scoped_lock lock(mutex);
+    for (;;) {
+        bool pending = processing != 0;
+        std::map<std::string, streamState>::iterator it = streams.begin();
+        for (; it != streams.end() && !pending; ++it)
+            pending = static_cast<bool> (it->second.pending);
+        if (!pending)
+            return;
+        frame_done.wait(lock);
+    }
+}
+
+/**
+ * Stop the workers once the frames being segmented are completed; waiting
+ * frames are discarded
+ */
+void StreamScheduler::stop() {
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stopping = true;
+    }
+    frame_available.notify_all();
+    pool.wait();
+}
+
+/**
+ * Get the names of the streams, in the order they were added
+ * 
+ * @return the stream names
+ */
+std::vector<std::string> StreamScheduler::get_streams() {
+    boost::mutex::scoped_lock lock(mutex);
+    return order;
+}
+
+/**
+ * Get the statistics of a stream
+ * 
+ * @param name  the name of the stream
+ * 
+ * @return the statistics of the stream
+ */
+streamStats StreamScheduler::get_stats(std::string name) {
+    boost::mutex::scoped_lock lock(mutex);
+    std::map<std::string, streamState>::iterator it = streams.find(name);
+    if (it == streams.end())
+        throw std::invalid_argument("Unknown stream '" + name + "'");
+    return it->second.stats;
+}
@@ -50,38 +50,73 @@
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/segmentation/supervoxel_clustering.h>
 
+#include <unordered_set>
+
 #include <vtkImageReader2Factory.h>
 #include <vtkImageReader2.h>
 #include <vtkImageData.h>
 #include <vtkImageFlip.h>
-#include <vtkPolyLine.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 
 //#include <boost/filesystem.hpp>
 
+#include "supervoxel_clustering/allocation_counter.h"
+#include "supervoxel_clustering/cloud_types.h"
 #include "supervoxel_clustering/clustering.h"
+#include "supervoxel_clustering/file_list.h"
+#include "supervoxel_clustering/hierarchy_file.h"
+#include "supervoxel_clustering/hierarchy_index.h"
+#include "supervoxel_clustering/label_file.h"
+#include "supervoxel_clustering/performance_report.h"
+#include "supervoxel_clustering/results_log.h"
+#include "supervoxel_clustering/segmentation_server.h"
+#include "supervoxel_clustering/segmenter.h"
+#include "supervoxel_clustering/shm_ring_buffer.h"
+#include "supervoxel_clustering/stream_scheduler.h"
 #include "supervoxel_clustering/testing.h"
 
 using namespace boost;
 using namespace pcl;
 
-typedef PointXYZRGBA PointT;
-typedef PointCloud<PointT> PointCloudT;
-typedef PointNormal PointNT;
-typedef PointCloud<PointNT> PointNCloudT;
-typedef PointXYZL PointLT;
-typedef PointCloud<PointLT> PointLCloudT;
-typedef PointXYZRGBL PointLCT;
-typedef PointCloud<PointLCT> PointLCCloudT;
-
 bool show_voxel_centroids = false;
 bool show_segmentation = true;
 bool show_supervoxels = false;
 bool show_supervoxel_normals = false;
 bool show_graph = true;
 bool show_help = false;
-float start_thresh = 0.8;
-float end_thresh = 1;
-float step_thresh = 0.005;
+// Set when a key changes what is shown, so that the viewer is only updated
+// when something changed
+bool viewer_changed = true;
+// Steps taken from the threshold of the segmentation with the (]) and ([) 
+// keys, as (+) and (-) already change the point size in the PCL viewer
+int threshold_steps = 0;
+// Set while a mouse button is pressed, that is while the camera is moved
+bool camera_moving = false;
+
+/**
+ * Pyramid of decimations of a cloud shown by the viewer: each level keeps one
+ * point for each cell of a grid twice as coarse as the one of the level 
+ * below, up to the first level small enough to be drawn while the camera 
+ * moves. Levels are indices in the cloud, so that the decimated cloud always
+ * has the current colors of the cloud.
+ */
+struct lodPyramid {
+    std::vector<std::vector<int> > levels;
+};
+
+/**
+ * Segmentation shown by the viewer when stepping through the thresholds: the
+ * voxels of the initial supervoxels, colored again from the hierarchy index 
+ * at each threshold without clustering again
+ */
+struct thresholdView {
+    boost::shared_ptr<HierarchyIndex> index;
+    std::vector<uint64_t> offsets;
+    PointCloudT::Ptr cloud;
+    float base_threshold, threshold, step;
+};
 
 void keyboard_callback(const visualization::KeyboardEvent& event, void*) {
     int key = event.getKeyCode();
@@ -107,28 +142,58 @@ void keyboard_callback(const visualization::KeyboardEvent& event, void*) {
             case (int) 'H':
                 show_help = !show_help;
                 break;
-            default:
+            case (int) ']':
+                threshold_steps++;
+                break;
+            case (int) '[':
+                threshold_steps--;
                 break;
+            default:
+                return;
         }
+    else
+        return;
+    viewer_changed = true;
 }
 
-inline bool isNan(float f) {
-    return f != f;
+void mouse_callback(const visualization::MouseEvent& event, void*) {
+    if (event.getType() == visualization::MouseEvent::MouseButtonPress)
+        camera_moving = true;
+    else if (event.getType() == visualization::MouseEvent::MouseButtonRelease)
+        camera_moving = false;
+    else
+        return;
+    viewer_changed = true;
 }
 
-void manageAllPerformances(
-        std::vector<std::map<float, performanceSet> > all_performances,
-        std::string filename);
-void printBestPerformances(std::vector<performanceSet> best_performances);
-
-void addSupervoxelConnectionsToViewer(PointT &supervoxel_center,
-        PointCloudT &adjacent_supervoxel_centers, std::string supervoxel_name,
-        shared_ptr<visualization::PCLVisualizer> & viewer);
+void printFrameResult(const frameResult &result,
+        const segmenterParameters &params, bool count_allocations);
+void printStageTimings(const frameResult &result);
+std::string relativePath(std::string file, std::string directory);
+void processStreams(std::vector<std::string> file_list, std::string root,
+        segmenterParameters params, float rate, size_t workers,
+        std::vector<performanceSet> &best_performances);
+int processSweep(std::vector<std::string> file_list, std::string sweep_file,
+        size_t workers, std::string test_filename, bool save_csv);
+
+vtkSmartPointer<vtkPolyData> makeGraphPolyData(
+        const std::map<uint32_t, Supervoxel<PointT>::Ptr> &supervoxel_clusters,
+        const std::multimap<uint32_t, uint32_t> &adjacency);
+
+bool makeThresholdView(const frameResult &result, float step,
+        thresholdView &view);
+void cutThresholdView(thresholdView &view);
+
+void buildPyramid(const PointCloudT &cloud, float resolution,
+        size_t max_points, lodPyramid &pyramid);
+PointCloudT::Ptr lodCloud(PointCloudT::Ptr cloud,
+        const std::map<const PointCloudT *, lodPyramid> &pyramids);
 
 void visualize(std::map<uint32_t, Supervoxel<PointT>::Ptr> supervoxel_clusters,
         PointCloudT::Ptr colored_cloud, PointCloudT::Ptr segm_cloud,
         PointCloudT::Ptr truth_cloud, PointNCloudT::Ptr normal_cloud,
-        std::multimap<uint32_t, uint32_t> adjacency);
+        std::multimap<uint32_t, uint32_t> adjacency, thresholdView *view,
+        float resolution, size_t lod_points);
 
 void printText(shared_ptr<visualization::PCLVisualizer> viewer);
 void removeText(shared_ptr<visualization::PCLVisualizer> viewer);
@@ -137,7 +202,8 @@ int main(int argc, char ** argv) {
     if (argc < 3) {
         console::print_info(
                 "Syntax is: "
-                "%s {-d <direcory-of-pcd-files> OR -p <pcd-file>} [arguments] \n"
+                "%s {-d <direcory-of-pcd-files> OR -p <pcd-file> OR "
+                "-m <shm-name> OR -u <socket-path>} [arguments] \n"
                 "\n\t"
                 "SUPERVOXEL optional arguments: \n\t"
                 " -v <voxel-resolution>          (default: 0.008) \n\t"
@@ -173,6 +239,69 @@ int main(int argc, char ** argv) {
                 "going to be used)\n\t"
                 " --NT                           (disables use of single "
                 "camera transform) \n\t"
+                " --TW                           (temporal warm-start: "
+                "processes the files as a sequence of frames, seeding each "
+                "frame from the previous one and reusing the distances of "
+                "unchanged supervoxels) \n\t"
+                " --BG [color-tolerance]         (static background: caches "
+                "the segmentation of the first file and only segments again "
+                "the voxels that changed in the following ones; if no "
+                "parameter is given, a tolerance of 0.05 is used) \n\t"
+                " --PL [max-planes]              (extracts up to the given "
+                "number of dominant planes before the supervoxels, each kept "
+                "as a single segment; can't be used with --TW or --BG; if no "
+                "parameter is given, 3 planes are used) \n\t"
+                " --ROI <region>                 (only segments the points "
+                "inside the region: 'box:xmin,ymin,zmin,xmax,ymax,zmax', "
+                "'obb:cx,cy,cz,hx,hy,hz,roll,pitch,yaw' or "
+                "'frustum:hfov,vfov,near,far', in the camera frame with angles "
+                "in radians) \n\t"
+                " --HS                           (saves the whole hierarchy "
+                "of the clustering of each file in a binary file next to it, "
+                "with extension .hier, from which the segmentation at any "
+                "threshold can be extracted with hierarchy_extract) \n\t"
+                " --LO [rle]                     (saves the label of each "
+                "point of each file, in the order of the file, in a binary "
+                "file next to it with extension .labels, written in the "
+                "background; with 'rle' the labels are run-length encoded) "
+                "\n\t"
+                " --LOD [max-points]             (while the camera is moved "
+                "in the viewer, only draws a decimation of each cloud with at "
+                "most the given number of points; if no parameter is given, "
+                "200000 points are used) \n\t"
+                " --AC                           (reports the number of heap "
+                "allocations of each processing stage; allocations are only "
+                "counted when this option is given) \n\t"
+                " --CSV                          (also saves the scores at "
+                "each threshold in one CSV file per metric, "
+                "<test-results-filename>_<metric>.csv) \n\t"
+                " --TG [threads]                 (runs the independent stages "
+                "of each frame in parallel and reports their timings; if no "
+                "parameter is given, one thread for each core is used; with "
+                "-u, the stages of every job run in parallel on that many "
+                "threads) \n\t"
+                " --MS [frame-rate]              (multi-stream: with -d, "
+                "segments each subdirectory as a separate camera stream fed at "
+                "the given rate, sharing the workers given by -w; frames not "
+                "segmented within one period are dropped; if no parameter is "
+                "given, 30 fps are used) \n\t"
+                " -m <shm-name>                  (reads the frames from a shared "
+                "memory ring buffer with the given name, until its producer "
+                "closes it) \n\t"
+                " --shard <i>/<N>                (with -d, only processes the "
+                "i-th of N shards of the directory, and saves the results as "
+                "<test-results-filename>_shard<i>of<N>, to be combined with "
+                "merge_results) \n\t"
+                " --SW <sweep-file>              (sweep: segments all files "
+                "with each configuration of the sweep file, one line of "
+                "arguments per configuration, on a work-stealing pool of "
+                "workers given by -w; with --CSV, the CSV files of "
+                "configuration i are saved with filename "
+                "<test-results-filename>_i) \n\t"
+                " -w <workers>                   (with -u, --MS or --SW, number "
+                "of jobs served at the same time; if not given, one for each "
+                "core) "
+                "\n\t"
                 " --V                            (verbose) \n",
                 argv[0]);
         return (1);
@@ -189,22 +318,41 @@ int main(int argc, char ** argv) {
         console::setVerbosityLevel(console::L_DEBUG);
     }
 
-    bool disable_transform = console::find_switch(argc, argv, "--NT");
+    if (console::find_switch(argc, argv, "-u")) {
+        std::string socket_path;
+        int workers = 0;
+        int stage_threads = 0;
+        console::parse(argc, argv, "-u", socket_path);
+        if (console::find_switch(argc, argv, "-w"))
+            console::parse(argc, argv, "-w", workers);
+        if (console::find_switch(argc, argv, "--TG"))
+            console::parse_argument(argc, argv, "--TG", stage_threads);
+        try {
+            SegmentationServer server(socket_path, std::max(workers, 0),
+                    std::max(stage_threads, 0));
+            server.run();
+        } catch (std::exception &e) {
+            console::print_error("%s\n", e.what());
+            return (1);
+        }
+        return (0);
+    }
 
     std::string test_filename = "test";
     if (console::find_switch(argc, argv, "-f"))
         console::parse(argc, argv, "-f", test_filename);
 
     // Input parameters
-    PointCloudT::Ptr cloud = make_shared<PointCloudT>();
-    PointLCloudT::Ptr truth_cloud = make_shared<PointLCloudT>();
+    segmenterParameters params;
     PointLCCloudT::Ptr input_cloud = make_shared<PointLCCloudT>();
+    NormalCloudT::Ptr input_normals = make_shared<NormalCloudT>();
 
     std::string path;
     std::vector<std::string> file_list;
 
     bool directory_specified = console::find_switch(argc, argv, "-d");
     bool pcd_file_specified = console::find_switch(argc, argv, "-p");
+    bool shm_specified = console::find_switch(argc, argv, "-m");
 
     if (directory_specified) {
         console::parse(argc, argv, "-d", path);
@@ -224,237 +372,282 @@ int main(int argc, char ** argv) {
                 console::print_debug("File found: %s\n", it->path().c_str());
             }
         }
-        console::print_info("Found %d files\n", file_list.size());
+        // Files are processed in natural order, so that sequences of frames
+        // are read in the right order even when they are not zero-padded
+        FileList::sort(file_list);
+        console::print_info("Found %zu files\n", file_list.size());
     } else if (pcd_file_specified) {
         console::parse(argc, argv, "-p", path);
         file_list.push_back(path);
+    } else if (shm_specified) {
+        console::parse(argc, argv, "-m", path);
     } else {
         console::print_error("No input file or directory specified\n");
         return (1);
     }
 
-    bool thresh_specified = console::find_switch(argc, argv, "-t");
-    float thresh = 0;
+    bool shard_specified = console::find_switch(argc, argv, "--shard");
+    if (shard_specified) {
+        std::string shard_spec;
+        size_t shard = 0, shards = 0;
+        console::parse(argc, argv, "--shard", shard_spec);
+        char separator;
+        std::istringstream spec(shard_spec);
+        if (!directory_specified || !(spec >> shard >> separator >> shards)
+                || separator != '/' || shards == 0 || shard >= shards) {
+            console::print_error("--shard needs -d and a shard index i/N with "
+                    "0 <= i < N\n");
+            return (1);
+        }
+        // Files are assigned to shards by hashing their path relative to the
+        // directory, so that every machine makes the same split
+        std::vector<std::string> shard_list;
+        std::vector<std::string>::iterator f_it = file_list.begin();
+        for (; f_it != file_list.end(); ++f_it)
+            if (PerformanceReport::in_shard(relativePath(*f_it, path), shard,
+                    shards))
+                shard_list.push_back(*f_it);
+        file_list = shard_list;
+        std::stringstream shard_filename;
+        shard_filename << test_filename << "_shard" << shard << "of" << shards;
+        test_filename = shard_filename.str();
+        console::print_info("Processing %zu files in shard %zu/%zu\n",
+                file_list.size(), shard, shards);
+    }
 
-    if (thresh_specified) {
-        console::parse_argument(argc, argv, "-t", thresh);
-        console::print_debug("Using threshold: %f\n", thresh);
-    } else {
-        console::print_debug("Using automatic threshold\n");
-    }
-
-    // Supervoxel segmentation parameters
-    float voxel_resolution = 0.008f;
-    bool voxel_res_specified = console::find_switch(argc, argv, "-v");
-    if (voxel_res_specified)
-        console::parse(argc, argv, "-v", voxel_resolution);
-
-    float seed_resolution = 0.08f;
-    bool seed_res_specified = console::find_switch(argc, argv, "-s");
-    if (seed_res_specified)
-        console::parse(argc, argv, "-s", seed_resolution);
-
-    float color_importance = 0.2f;
-    if (console::find_switch(argc, argv, "-c"))
-        console::parse(argc, argv, "-c", color_importance);
-
-    float spatial_importance = 0.4f;
-    if (console::find_switch(argc, argv, "-z"))
-        console::parse(argc, argv, "-z", spatial_importance);
-
-    float normal_importance = 1.0f;
-    if (console::find_switch(argc, argv, "-n"))
-        console::parse(argc, argv, "-n", normal_importance);
-
-    // Segmentation parameters
-    bool rgb_color_space_specified = console::find_switch(argc, argv, "--RGB");
-    bool convexity_specified = console::find_switch(argc, argv, "--CVX");
-    bool manual_lambda_specified = console::find_switch(argc, argv, "--ML");
-    bool adapt_lambda_specified = console::find_switch(argc, argv, "--AL");
-    bool equalization_specified = console::find_switch(argc, argv, "--EQ");
-    if (!(manual_lambda_specified || adapt_lambda_specified
-            || equalization_specified)) {
-        adapt_lambda_specified = true;
-        console::print_debug("No merging criterion specified, Adaptive Lambda "
-                "is going to be used\n");
-    } else if (!(manual_lambda_specified ^ adapt_lambda_specified
-            ^ equalization_specified)) {
-        console::print_error("Only one parameter between --ML --AL and --EQ "
-                "can be specified at a time\n");
+    if (!Segmenter::parse_arguments(argc, argv, params))
         return (1);
-    }
 
-    float lambda = 0;
-    if (manual_lambda_specified)
-        console::parse_argument(argc, argv, "--ML", lambda);
+    bool csv_specified = console::find_switch(argc, argv, "--CSV");
+    // Labels are written by a background thread while the next file is 
+    // being segmented
+    shared_ptr<LabelWriter> label_writer;
+    if (console::find_switch(argc, argv, "--LO")) {
+        std::string encoding;
+        console::parse(argc, argv, "--LO", encoding);
+        label_writer.reset(new LabelWriter(
+                (encoding == "rle") ? RLE_LABELS : RAW_LABELS));
+    }
+    bool count_allocations = console::find_switch(argc, argv, "--AC");
+    size_t lod_points = 0;
+    if (console::find_switch(argc, argv, "--LOD")) {
+        int max_points = 200000;
+        console::parse_argument(argc, argv, "--LOD", max_points);
+        lod_points = std::max(max_points, 1);
+    }
 
-    int bin_num = 0;
-    if (equalization_specified)
-        console::parse_argument(argc, argv, "--EQ", bin_num);
+    // The viewer of a single file steps through the thresholds on the whole
+    // hierarchy, so it is recorded even if it is not saved; this is done in
+    // its own stage, after the clustering
+    bool save_hierarchy = params.hierarchy;
+    if (file_list.size() == 1)
+        params.hierarchy = true;
+
+    Segmenter segmenter(params);
+    if (count_allocations) {
+        AllocationCounter::enable();
+        segmenter.set_allocation_counter(&AllocationCounter::count);
+    }
 
-    bool remove_label = console::find_switch(argc, argv, "-r");
-    uint32_t label_to_be_removed = 0;
-    if (remove_label)
-        console::parse_argument(argc, argv, "-r", label_to_be_removed);
+    bool task_graph_specified = console::find_switch(argc, argv, "--TG");
+    int stage_threads = 0;
+    if (task_graph_specified)
+        console::parse_argument(argc, argv, "--TG", stage_threads);
+    boost::scoped_ptr<ThreadPool> stage_pool;
+    if (task_graph_specified) {
+        stage_pool.reset(new ThreadPool(std::max(stage_threads, 0)));
+        segmenter.set_thread_pool(stage_pool.get());
+    }
 
     std::vector<performanceSet> best_performances;
     std::vector<std::map<float, performanceSet> > all_performances;
-    std::vector<std::string>::iterator file_it = file_list.begin();
-    for (; file_it != file_list.end(); ++file_it) {
-
-        ////////////////////////////////////////////////////////////
-        ////// File reading
-        ////////////////////////////////////////////////////////////
 
-        bool has_label = true; //TODO should be false
-
-        console::print_info("Loading pointcloud from PCD file '%s'...\n",
-                file_it->c_str());
-        pcl::io::loadPCDFile(*file_it, *input_cloud);
-        PointLCCloudT::Ptr cloud_temp = make_shared<PointLCCloudT>();
-        PointLCCloudT::iterator cloud_itr = input_cloud->begin();
-        for (; cloud_itr != input_cloud->end(); ++cloud_itr) {
-            if (cloud_itr->z < 0) {
-                console::print_debug(
-                        "Found point with z<0, setting to absolute value\n");
-                cloud_itr->z = std::abs(cloud_itr->z);
-            }
-            /*
-             * TODO 
-             * this doesn't work if label = 0 exists and is the one to be
-             * removed
-             */
-            if (!has_label && cloud_itr->label != 0) {
-                console::print_debug("Found label data, evaluation is going "
-                        "to be performed\n");
-                has_label = true;
+    if (shm_specified) {
+        try {
+            ShmRingBuffer ring(path, SHM_DEFAULT_SLOTS, SHM_DEFAULT_CAPACITY);
+            console::print_info("Waiting for frames on shared memory "
+                    "'%s'...\n", path.c_str());
+            frameResult result;
+            for (;;) {
+                // The closed flag is read before looking for frames, so that
+                // the frames written before closing are never missed
+                bool closed = ring.is_closed();
+                shmFrame frame;
+                const shmPoint *points = ring.begin_read(frame);
+                if (points == NULL) {
+                    if (closed)
+                        break;
+                    this_thread::sleep_for(chrono::milliseconds(1));
+                    continue;
+                }
+                // The frame header is written by another process, so it is
+                // not trusted to stay within the slot
+                if (frame.points > ring.get_slot_capacity()) {
+                    ring.end_read();
+                    console::print_error("Frame %llu: %u points, more than "
+                            "the slot capacity\n",
+                            static_cast<unsigned long long>(frame.sequence),
+                            frame.points);
+                    continue;
+                }
+                try {
+                    segmenter.process(points, frame.points, result);
+                } catch (std::exception &e) {
+                    ring.end_read();
+                    console::print_error("Frame %llu: %s\n",
+                            static_cast<unsigned long long>(frame.sequence),
+                            e.what());
+                    continue;
+                }
+                ring.end_read();
+                console::print_info("Frame %llu segmented (%u points)\n",
+                        static_cast<unsigned long long>(frame.sequence),
+                        frame.points);
+                printFrameResult(result, params, count_allocations);
             }
-            if (!has_label || !remove_label
-                    || (cloud_itr->label != label_to_be_removed
-                    && !isNan(cloud_itr->z))) {
-                cloud_temp->push_back(*cloud_itr);
+        } catch (std::exception &e) {
+            console::print_error("%s\n", e.what());
+            return (1);
+        }
+        return (0);
+    }
+
+    if (console::find_switch(argc, argv, "--SW")) {
+        std::string sweep_file;
+        int workers = 0;
+        console::parse(argc, argv, "--SW", sweep_file);
+        if (console::find_switch(argc, argv, "-w"))
+            console::parse(argc, argv, "-w", workers);
+        return processSweep(file_list, sweep_file, std::max(workers, 0),
+                test_filename, csv_specified);
+    }
+
+    if (directory_specified && console::find_switch(argc, argv, "--MS")) {
+        float rate = 30;
+        int workers = 0;
+        console::parse_argument(argc, argv, "--MS", rate);
+        if (console::find_switch(argc, argv, "-w"))
+            console::parse(argc, argv, "-w", workers);
+        processStreams(file_list, path, params, rate, std::max(workers, 0),
+                best_performances);
+        PerformanceReport::print_best(best_performances);
+        return (0);
+    }
+
+    // When processing a directory, the results of each file are appended to a
+    // journal as soon as they are ready, so that a run interrupted midway can
+    // be restarted with the same arguments without recomputing them
+    std::string signature;
+    for (int i = 1; i < argc; ++i)
+        signature += (i > 1 ? " " : "") + std::string(argv[i]);
+    std::map<std::string, fileResult> journaled;
+    std::ofstream journal;
+    if (directory_specified) {
+        std::string journal_filename = test_filename + ".results";
+        std::vector<fileResult> recovered;
+        if (filesystem::exists(journal_filename)) {
+            std::string journal_signature;
+            if (!PerformanceReport::load_results(journal_filename, recovered,
+                    &journal_signature))
+                console::print_warn("Discarding the incomplete tail of the "
+                        "journal\n");
+            if (journal_signature != signature) {
+                console::print_warn("Journal %s was written by a run with "
+                        "different arguments, starting over\n",
+                        journal_filename.c_str());
+                recovered.clear();
+            } else {
+                console::print_info("Resuming from journal %s, %zu files "
+                        "already done\n", journal_filename.c_str(),
+                        recovered.size());
             }
         }
+        std::vector<fileResult>::iterator r_it = recovered.begin();
+        for (; r_it != recovered.end(); ++r_it)
+            journaled[r_it->filename] = *r_it;
+        // Rewriting the recovered files drops any partial record left by the
+        // interrupted run before new ones are appended
+        PerformanceReport::save_results(recovered, journal_filename, signature);
+        journal.open(journal_filename.c_str(), std::ios::app);
+    }
+    // The records of the files skipped when resuming are already there
+    ResultsLog results_log;
+    results_log.open(test_filename + ".jsonl", !journaled.empty());
 
-        copyPointCloud(*cloud_temp, *cloud);
-        copyPointCloud(*cloud_temp, *truth_cloud);
+    // The results of each file overwrite the ones of the previous file, so
+    // that their memory is reused
+    frameResult result;
+    std::vector<std::string>::iterator file_it = file_list.begin();
+    for (; file_it != file_list.end(); ++file_it) {
 
-        console::print_info("Pointcloud loaded\n");
+        std::string relative_path = *file_it;
+        if (directory_specified) {
+            relative_path = relativePath(*file_it, path);
+            std::map<std::string, fileResult>::iterator j_it =
+                    journaled.find(relative_path);
+            if (j_it != journaled.end()) {
+                console::print_info("Skipping %s, already in the journal\n",
+                        file_it->c_str());
+                if (!params.thresh_specified)
+                    all_performances.push_back(j_it->second.all_performances);
+                best_performances.push_back(j_it->second.performance);
+                continue;
+            }
+        }
 
         ////////////////////////////////////////////////////////////
-        ////// Supervoxel generation
+        ////// File reading
         ////////////////////////////////////////////////////////////
 
-        SupervoxelClustering<PointT> super(voxel_resolution, seed_resolution);
-        super.setUseSingleCameraTransform(!disable_transform);
-        super.setInputCloud(cloud);
-        super.setColorImportance(color_importance);
-        super.setSpatialImportance(spatial_importance);
-        super.setNormalImportance(normal_importance);
-        std::map<uint32_t, Supervoxel<PointT>::Ptr> supervoxel_clusters;
-
-        console::print_info("Extracting supervoxels...\n");
-        super.extract(supervoxel_clusters);
-        console::print_info("Found %d supervoxels\n",
-                supervoxel_clusters.size());
-        PointCloudT::Ptr voxel_centroid_cloud = super.getVoxelCentroidCloud();
-        PointNCloudT::Ptr sv_normal_cloud = super.makeSupervoxelNormalCloud(
-                supervoxel_clusters);
-        PointLCloudT::Ptr full_labeled_cloud = super.getLabeledCloud();
-
-        console::print_info("Getting supervoxel adjacency...\n");
-        std::multimap<uint32_t, uint32_t> label_adjacency;
-        super.getSupervoxelAdjacency(label_adjacency);
-
-        std::map<uint32_t, Supervoxel<PointT>::Ptr> refined_supervoxel_clusters;
-        console::print_info("Refining supervoxels...\n");
-        super.refineSupervoxels(3, refined_supervoxel_clusters);
-
-        PointNCloudT::Ptr refined_sv_normal_cloud =
-                super.makeSupervoxelNormalCloud(refined_supervoxel_clusters);
-        PointLCloudT::Ptr refined_full_labeled_cloud = super.getLabeledCloud();
-        
-        console::print_info(
-                "Constructing Boost Graph Library Adjacency List...\n");
-        typedef adjacency_list<setS, setS, undirectedS, uint32_t, float>
-                VoxelAdjacencyList;
-        typedef VoxelAdjacencyList::vertex_descriptor VoxelID;
-        typedef VoxelAdjacencyList::edge_descriptor EdgeID;
-        VoxelAdjacencyList supervoxel_adjacency_list;
-        super.getSupervoxelAdjacencyList(supervoxel_adjacency_list);
-
-        // Voxelizing ground truth cloud
-        PointCloudT::Ptr colored_truth_cloud = Clustering::label2color(
-                truth_cloud);
-        SupervoxelClustering<PointT> super_label(voxel_resolution,
-                seed_resolution);
-        super_label.setUseSingleCameraTransform(!disable_transform);
-        super_label.setInputCloud(colored_truth_cloud);
-        super_label.setColorImportance(color_importance);
-        super_label.setSpatialImportance(spatial_importance);
-        super_label.setNormalImportance(normal_importance);
-        std::map<uint32_t, Supervoxel<PointT>::Ptr> supervoxel_label_clusters;
-        super_label.extract(supervoxel_label_clusters);
-        colored_truth_cloud = super_label.getVoxelCentroidCloud();
-        truth_cloud = Clustering::color2label(colored_truth_cloud);
-        colored_truth_cloud = Clustering::label2color(truth_cloud);
+        if (!Segmenter::load(*file_it, input_cloud, input_normals))
+            continue;
 
         ////////////////////////////////////////////////////////////
-        ////// Segmentation
+        ////// Segmentation and testing
         ////////////////////////////////////////////////////////////
 
-        console::print_info("Segmentation initialization...\n");
-
-        Clustering segmentation;
-        if (rgb_color_space_specified)
-            segmentation.set_delta_c(RGB_EUCL);
-
-        if (convexity_specified)
-            segmentation.set_delta_g(CONVEX_NORMALS_DIFF);
-
-        if (manual_lambda_specified) {
-            segmentation.set_merging(MANUAL_LAMBDA);
-            if (lambda != 0)
-                segmentation.set_lambda(lambda);
-        } else if (equalization_specified) {
-            segmentation.set_merging(EQUALIZATION);
-            if (bin_num != 0)
-                segmentation.set_bins_num(bin_num);
+        try {
+            segmenter.process(*input_cloud, input_normals, result);
+        } catch (std::exception &e) {
+            console::print_error("%s: %s\n", file_it->c_str(), e.what());
+            continue;
         }
-        segmentation.set_initialstate(supervoxel_clusters, label_adjacency);
-        if (manual_lambda_specified || adapt_lambda_specified)
-            console::print_debug("Lambda: %f\n", segmentation.get_lambda());
-
-        if (!thresh_specified) {
-            std::map<float, performanceSet> all = segmentation.all_thresh(
-                    truth_cloud, start_thresh, end_thresh, step_thresh);
-            all_performances.push_back(all);
-            std::pair<float, performanceSet> best = segmentation.best_thresh(
-                    all);
-            console::print_info(
-                    "Using best threshold: %f (F-score %f, voi %f)\n",
-                    best.first, best.second.fscore, best.second.voi);
-            thresh = best.first;
+        if (!params.thresh_specified)
+            all_performances.push_back(result.all_performances);
+        best_performances.push_back(result.performance);
+        if (save_hierarchy) {
+            std::string hierarchy_filename = filesystem::path(*file_it)
+                    .replace_extension(".hier").string();
+            try {
+                HierarchyFile::save(hierarchy_filename, result.hierarchy_state,
+                        result.hierarchy_merges);
+                console::print_info("Hierarchy saved in %s\n",
+                        hierarchy_filename.c_str());
+            } catch (std::exception &e) {
+                console::print_error("%s\n", e.what());
+            }
+        }
+        if (label_writer) {
+            shared_ptr<std::vector<uint32_t> > labels =
+                    make_shared<std::vector<uint32_t> >();
+            segmenter.point_labels(*input_cloud, result, *labels);
+            label_writer->write(filesystem::path(*file_it)
+                    .replace_extension(".labels").string(), labels);
+        }
+        results_log.write(relative_path, signature, result.all_performances,
+                result.performance, result.threshold, result.timings);
+        if (directory_specified) {
+            fileResult r;
+            r.filename = relative_path;
+            r.performance = result.performance;
+            r.all_performances = result.all_performances;
+            PerformanceReport::write_result(journal, r);
+            journal.flush();
         }
 
-        console::print_info(
-                "Initialization complete\nStarting clustering...\n");
-
-        segmentation.cluster(thresh);
-        console::print_info("Clustering complete\n");
-        std::pair<ClusteringT, AdjacencyMapT> s =
-                segmentation.get_currentstate();
-
-        PointCloudT::Ptr colored_voxel_cloud = segmentation.get_colored_cloud();
-        label_adjacency = s.second;
-
-        ////////////////////////////////////////////////////////////
-        ////// Testing
-        ////////////////////////////////////////////////////////////
-
-        console::print_info("Initializing testing suite...\n");
-        Testing test(segmentation.get_labeled_cloud(), truth_cloud);
-        best_performances.push_back(test.eval_performance());
+        printFrameResult(result, params, count_allocations);
+        if (task_graph_specified)
+            printStageTimings(result);
 
         ////////////////////////////////////////////////////////////
         ////// Visualization
@@ -462,240 +655,615 @@ int main(int argc, char ** argv) {
 
         if (file_list.size() == 1) {
             console::print_info("Loading visualization...\n");
-            visualize(supervoxel_clusters, voxel_centroid_cloud,
-                    colored_voxel_cloud, colored_truth_cloud,
-                    refined_sv_normal_cloud, label_adjacency);
+            thresholdView view;
+            bool has_view = makeThresholdView(result, params.step_thresh,
+                    view);
+            visualize(result.supervoxels, result.voxel_centroid_cloud,
+                    result.colored_voxel_cloud, result.colored_truth_cloud,
+                    result.refined_normal_cloud, result.adjacency,
+                    (has_view) ? &view : NULL, params.voxel_resolution,
+                    lod_points);
         }
     }
 
-    manageAllPerformances(all_performances, test_filename);
+    results_log.close();
+    if (label_writer) {
+        label_writer->flush();
+        console::print_info("Label files written: %zu\n",
+                label_writer->get_written());
+    }
+    if (csv_specified)
+        PerformanceReport::save_all(all_performances, test_filename);
 
-    printBestPerformances(best_performances);
+    PerformanceReport::print_best(best_performances);
 
     return (0);
 }
 
-void manageAllPerformances(
-        std::vector<std::map<float, performanceSet> > all_performances,
-        std::string filename) {
-    ofstream file_voi((filename + "_voi.csv").c_str());
-    ofstream file_prec((filename + "_precision.csv").c_str());
-    ofstream file_recall((filename + "_recall.csv").c_str());
-    ofstream file_fscore((filename + "_fscore.csv").c_str());
-    ofstream file_wov((filename + "_wov.csv").c_str());
-    ofstream file_fpr((filename + "_fpr.csv").c_str());
-    ofstream file_fnr((filename + "_fnr.csv").c_str());
-
-    std::vector<std::map<float, performanceSet> >::iterator p_it =
-            all_performances.begin();
-    for (; p_it != all_performances.end(); ++p_it) {
-        std::map<float, performanceSet>::iterator m_it = p_it->begin();
-        for (; m_it != p_it->end(); ++m_it) {
-            file_voi << m_it->second.voi << ";";
-            file_prec << m_it->second.precision << ";";
-            file_recall << m_it->second.recall << ";";
-            file_fscore << m_it->second.fscore << ";";
-            file_wov << m_it->second.wov << ";";
-            file_fpr << m_it->second.fpr << ";";
-            file_fnr << m_it->second.fnr << ";";
+/**
+ * Get the path of a file relative to a directory containing it, with '/' as
+ * separator on every platform
+ */
+std::string relativePath(std::string file, std::string directory) {
+    std::string relative = filesystem::path(file).generic_string();
+    std::string root = filesystem::path(directory).generic_string();
+    if (relative.compare(0, root.size(), root) == 0)
+        relative = relative.substr(root.size());
+    while (!relative.empty() && relative[0] == '/')
+        relative.erase(0, 1);
+    return relative;
+}
+
+/**
+ * Collect the evaluation of the frames segmented by the stream scheduler
+ */
+struct streamResultCollector {
+    mutex *results_mutex;
+    std::vector<performanceSet> *best_performances;
+
+    void operator()(const std::string &stream,
+            const frameResult &result) const {
+        mutex::scoped_lock lock(*results_mutex);
+        console::print_info("Stream '%s': frame segmented\n", stream.c_str());
+        best_performances->push_back(result.performance);
+    }
+};
+
+/**
+ * Segment the files of each subdirectory as the frames of a separate camera
+ * stream, all sharing the same workers; frames are submitted to all streams
+ * at the given rate, and each frame has one period as deadline
+ */
+void processStreams(std::vector<std::string> file_list, std::string root,
+        segmenterParameters params, float rate, size_t workers,
+        std::vector<performanceSet> &best_performances) {
+    std::map<std::string, std::vector<std::string> > stream_files;
+    std::vector<std::string>::iterator file_it = file_list.begin();
+    for (; file_it != file_list.end(); ++file_it) {
+        std::string name = filesystem::path(*file_it).parent_path().string();
+        if (name.compare(0, root.size(), root) == 0)
+            name = name.substr(root.size());
+        if (name.empty() || name == "/")
+            name = ".";
+        stream_files[name].push_back(*file_it);
+    }
+
+    double period = 1000.0 / std::max(rate, 0.001f);
+    mutex results_mutex;
+    StreamScheduler scheduler(params, workers);
+    streamResultCollector collector = {&results_mutex, &best_performances};
+    scheduler.set_callback(collector);
+    size_t frames = 0;
+    std::map<std::string, std::vector<std::string> >::iterator s_it =
+            stream_files.begin();
+    for (; s_it != stream_files.end(); ++s_it) {
+        scheduler.add_stream(s_it->first, period);
+        frames = std::max(frames, s_it->second.size());
+    }
+    console::print_info("Scheduling %zu streams at %f fps\n",
+            stream_files.size(), rate);
+
+    chrono::steady_clock::time_point next = chrono::steady_clock::now();
+    for (size_t f = 0; f < frames; ++f) {
+        this_thread::sleep_until(next);
+        next += chrono::microseconds((long) (period * 1000));
+        for (s_it = stream_files.begin(); s_it != stream_files.end(); ++s_it) {
+            if (f >= s_it->second.size())
+                continue;
+            PointLCCloudT::Ptr frame = make_shared<PointLCCloudT>();
+            if (Segmenter::load(s_it->second[f], frame))
+                scheduler.submit(s_it->first, frame);
         }
-        file_voi << "\n";
-        file_prec << "\n";
-        file_recall << "\n";
-        file_fscore << "\n";
-        file_wov << "\n";
-        file_fpr << "\n";
-        file_fnr << "\n";
-
-    }
-    file_voi.close();
-    file_prec.close();
-    file_recall.close();
-    file_fscore.close();
-    file_wov.close();
-    file_fpr.close();
-    file_fnr.close();
+    }
+    scheduler.wait();
+    scheduler.stop();
+
+    for (s_it = stream_files.begin(); s_it != stream_files.end(); ++s_it) {
+        streamStats s = scheduler.get_stats(s_it->first);
+        console::print_info("Stream '%s': %zu/%zu frames segmented, %zu "
+                "replaced, %zu expired, %zu failed, %zu deadline misses, "
+                "latency %f ms mean %f ms max\n", s_it->first.c_str(), s.processed,
+                s.submitted, s.replaced, s.expired, s.failed,
+                s.deadline_misses, (s.processed == 0)
+                ? 0.0 : s.total_latency / s.processed, s.max_latency);
+    }
 }
 
-void printBestPerformances(std::vector<performanceSet> best_performances) {
-    if (best_performances.size() == 1) {
-        performanceSet p = best_performances.back();
-        console::print_info(
-                "Scores:\nVOI\t%f\nPrec.\t%f\nRecall\t%f\nF-score\t%f\n"
-                "WOv\t%f\nFPR\t%f\nFNR\t%f\n",
-                p.voi, p.precision, p.recall, p.fscore, p.wov, p.fpr, p.fnr);
-    } else {
-        std::vector<performanceSet>::iterator p_it = best_performances.begin();
-        float mean_v = 0;
-        float mean_p = 0;
-        float mean_r = 0;
-        float mean_f = 0;
-        float mean_w = 0;
-        float mean_pr = 0;
-        float mean_nr = 0;
-        int count = 0;
-        for (; p_it != best_performances.end(); ++p_it) {
-            count++;
-            mean_v = mean_v + (1 / count) * (p_it->voi - mean_v);
-            mean_p = mean_p + (1 / count) * (p_it->precision - mean_p);
-            mean_r = mean_r + (1 / count) * (p_it->recall - mean_r);
-            mean_f = mean_f + (1 / count) * (p_it->fscore - mean_f);
-            mean_w = mean_w + (1 / count) * (p_it->wov - mean_w);
-            mean_pr = mean_pr + (1 / count) * (p_it->fpr - mean_pr);
-            mean_nr = mean_nr + (1 / count) * (p_it->fnr - mean_nr);
-            console::print_debug(
-                    "Scores:\nVOI\t%f\nPrec.\t%f\nRecall\t%f\nF-score\t%f\n"
-                    "WOv\t%f\nFPR\t%f\nFNR\t%f\n",
-                    p_it->voi, p_it->precision, p_it->recall, p_it->fscore,
-                    p_it->wov, p_it->fpr, p_it->fnr);
+/**
+ * Evaluation of one file with one configuration of a sweep; only the scores
+ * are kept until the sweep ends, the clouds of the frame are dropped by the
+ * job that segmented it
+ */
+struct sweepResult {
+
+    sweepResult() :
+    completed(false) {
+    }
+    bool completed;
+    performanceSet performance;
+    std::map<float, performanceSet> all_performances;
+};
+
+/**
+ * Segment one file with one configuration of a sweep
+ */
+void runSweepJob(PointLCCloudT::Ptr input, segmenterParameters params,
+        ThreadPool *pool, sweepResult *result, std::string file_id,
+        std::string config, ResultsLog *results_log) {
+    Segmenter segmenter(params);
+    segmenter.set_thread_pool(pool);
+    frameResult frame;
+    try {
+        frame = segmenter.process(input);
+    } catch (std::exception &e) {
+        console::print_error("%s (%s): %s\n", file_id.c_str(),
+                config.c_str(), e.what());
+        return;
+    }
+    results_log->write(file_id, config, frame.all_performances,
+            frame.performance, frame.threshold, frame.timings);
+    result->performance = frame.performance;
+    result->all_performances = frame.all_performances;
+    result->completed = true;
+}
+
+/**
+ * Load one file of a sweep and queue its segmentation with each configuration;
+ * the jobs are queued on the worker that loaded the file, and the other
+ * workers steal them when idle
+ */
+void loadSweepFile(std::string filename,
+        const std::vector<segmenterParameters> *configurations,
+        const std::vector<std::string> *lines, ThreadPool *pool,
+        std::vector<sweepResult> *results, ResultsLog *results_log) {
+    PointLCCloudT::Ptr input = make_shared<PointLCCloudT>();
+    if (!Segmenter::load(filename, input))
+        return;
+    for (size_t c = 0; c < configurations->size(); ++c) {
+        // Each job gets its own copy, as preprocessing modifies the input
+        PointLCCloudT::Ptr copy(new PointLCCloudT(*input));
+        pool->submit(bind(&runSweepJob, copy, (*configurations)[c], pool,
+                &(*results)[c], filename, (*lines)[c], results_log));
+    }
+}
+
+/**
+ * Segment all files with each configuration listed in a sweep file (one line 
+ * of arguments per configuration) on a work-stealing thread pool, saving and
+ * printing the results of each configuration
+ */
+int processSweep(std::vector<std::string> file_list, std::string sweep_file,
+        size_t workers, std::string test_filename, bool save_csv) {
+    std::ifstream file(sweep_file.c_str());
+    if (!file.is_open()) {
+        console::print_error("Cannot open sweep file '%s'\n",
+                sweep_file.c_str());
+        return (1);
+    }
+    std::vector<std::string> lines;
+    std::vector<segmenterParameters> configurations;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> tokens = SegmentationServer::tokenize(line);
+        if (tokens.empty() || tokens[0][0] == '#')
+            continue;
+        std::vector<char *> args;
+        std::string name = "sweep";
+        args.push_back(&name[0]);
+        for (size_t i = 0; i < tokens.size(); ++i)
+            args.push_back(&tokens[i][0]);
+        segmenterParameters params;
+        if (!Segmenter::parse_arguments(args.size(), &args[0], params)) {
+            console::print_error("Invalid configuration '%s'\n",
+                    line.c_str());
+            return (1);
         }
-        console::print_info(
-                "Average scores:\nVOI\t%f\nPrec.\t%f\nRecall\t%f\nF-score\t%f\n"
-                "WOv\t%f\nFPR\t%f\nFNR\t%f\n",
-                mean_v, mean_p, mean_r, mean_f, mean_w, mean_pr, mean_nr);
+        // Each job runs on a new segmenter, so sequences can't be followed
+        params.temporal = params.background = false;
+        lines.push_back(line);
+        configurations.push_back(params);
     }
+    console::print_info("Sweeping %zu files with %zu configurations\n",
+            file_list.size(), configurations.size());
+
+    // results[f][c] is the result of file f with configuration c
+    std::vector<std::vector<sweepResult> > results(file_list.size(),
+            std::vector<sweepResult>(configurations.size()));
+    ResultsLog results_log;
+    results_log.open(test_filename + ".jsonl", false);
+    ThreadPool pool(workers);
+    for (size_t f = 0; f < file_list.size(); ++f)
+        pool.submit(bind(&loadSweepFile, file_list[f], &configurations,
+            &lines, &pool, &results[f], &results_log));
+    pool.wait();
+    results_log.close();
+
+    for (size_t c = 0; c < configurations.size(); ++c) {
+        std::vector<performanceSet> best_performances;
+        std::vector<std::map<float, performanceSet> > all_performances;
+        for (size_t f = 0; f < file_list.size(); ++f) {
+            if (!results[f][c].completed)
+                continue;
+            if (!configurations[c].thresh_specified)
+                all_performances.push_back(results[f][c].all_performances);
+            best_performances.push_back(results[f][c].performance);
+        }
+        std::stringstream config_filename;
+        config_filename << test_filename << "_" << c;
+        console::print_info("Configuration %zu: %s\n", c, lines[c].c_str());
+        if (save_csv)
+            PerformanceReport::save_all(all_performances,
+                    config_filename.str());
+        if (!best_performances.empty())
+            PerformanceReport::print_best(best_performances);
+    }
+
+    poolStats stats = pool.get_stats();
+    console::print_info("Workers: %zu, tasks: %zu (%zu stolen), utilization: "
+            "%.1f%%\n", pool.size(), stats.tasks, stats.stolen_tasks,
+            100.0 * stats.utilization);
+    return (0);
 }
 
-void addSupervoxelConnectionsToViewer(PointT &supervoxel_center,
-        PointCloudT &adjacent_supervoxel_centers, std::string supervoxel_name,
-        shared_ptr<visualization::PCLVisualizer> & viewer) {
+/**
+ * Print the time taken by each processing stage of a frame
+ */
+void printStageTimings(const frameResult &result) {
+    std::vector<std::pair<std::string, double> >::const_iterator t_it =
+            result.timings.begin();
+    for (; t_it != result.timings.end(); ++t_it)
+        console::print_info("Stage %s: %f ms\n", t_it->first.c_str(),
+            t_it->second);
+}
+
+/**
+ * Print the statistics of a processed frame
+ */
+void printFrameResult(const frameResult &result,
+        const segmenterParameters &params, bool count_allocations) {
+    if (params.temporal) {
+        temporalStats t = result.temporal;
+        console::print_info("Temporal reuse: %zu/%zu supervoxels (%.1f%%), "
+                "%zu/%zu edges (%.1f%%)\n", t.matched_supervoxels,
+                t.supervoxels, (t.supervoxels == 0) ? 0.0 :
+                100.0 * t.matched_supervoxels / t.supervoxels,
+                t.reused_edges, t.edges, (t.edges == 0) ? 0.0 :
+                100.0 * t.reused_edges / t.edges);
+    }
+
+    if (count_allocations) {
+        size_t total = 0;
+        std::vector<std::pair<std::string, size_t> >::const_iterator a_it =
+                result.allocations.begin();
+        for (; a_it != result.allocations.end(); ++a_it) {
+            console::print_info("Allocations (%s): %zu\n",
+                    a_it->first.c_str(), a_it->second);
+            total += a_it->second;
+        }
+        console::print_info("Allocations (frame): %zu\n", total);
+    }
+
+    if (params.background && result.background.points != 0) {
+        backgroundStats b = result.background;
+        console::print_info("Background: %zu/%zu points changed (%.1f%%), "
+                "%zu/%zu supervoxels carried over\n", b.changed_points,
+                b.points, 100.0 * b.changed_points / b.points,
+                b.carried_supervoxels, b.supervoxels);
+    }
+}
+
+/**
+ * Build the adjacency graph of the supervoxels as a single set of lines, one
+ * for each pair of adjacent supervoxels, so that it is drawn by a single 
+ * actor instead of one for each supervoxel
+ */
+vtkSmartPointer<vtkPolyData> makeGraphPolyData(
+        const std::map<uint32_t, Supervoxel<PointT>::Ptr> &supervoxel_clusters,
+        const std::multimap<uint32_t, uint32_t> &adjacency) {
     vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
     vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
-    vtkSmartPointer<vtkPolyLine> polyLine = vtkSmartPointer<vtkPolyLine>::New();
 
-    // Iterate through all adjacent points, and add a center point to adjacent 
-    // point pair
-    PointCloudT::iterator adjacent_itr = adjacent_supervoxel_centers.begin();
-    for (; adjacent_itr != adjacent_supervoxel_centers.end(); ++adjacent_itr) {
-        points->InsertNextPoint(supervoxel_center.data);
-        points->InsertNextPoint(adjacent_itr->data);
+    // Each centroid is a point of the dataset, shared by all its lines
+    std::map<uint32_t, vtkIdType> point_ids;
+    std::map<uint32_t, Supervoxel<PointT>::Ptr>::const_iterator sv_itr =
+            supervoxel_clusters.begin();
+    for (; sv_itr != supervoxel_clusters.end(); ++sv_itr)
+        point_ids[sv_itr->first] =
+            points->InsertNextPoint(sv_itr->second->centroid_.data);
+
+    // The adjacency may have both directions of a pair, only one line is 
+    // drawn for each
+    std::set<std::pair<uint32_t, uint32_t> > drawn;
+    std::multimap<uint32_t, uint32_t>::const_iterator adj_itr =
+            adjacency.begin();
+    for (; adj_itr != adjacency.end(); ++adj_itr) {
+        std::map<uint32_t, vtkIdType>::const_iterator first =
+                point_ids.find(adj_itr->first);
+        std::map<uint32_t, vtkIdType>::const_iterator second =
+                point_ids.find(adj_itr->second);
+        if (first == point_ids.end() || second == point_ids.end()
+                || !drawn.insert(std::make_pair(
+                std::min(adj_itr->first, adj_itr->second),
+                std::max(adj_itr->first, adj_itr->second))).second)
+            continue;
+        cells->InsertNextCell(2);
+        cells->InsertCellPoint(first->second);
+        cells->InsertCellPoint(second->second);
     }
-    // Create a polydata to store everything in
+
     vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
-    // Add the points to the dataset
     polyData->SetPoints(points);
-    polyLine->GetPointIds()->SetNumberOfIds(points->GetNumberOfPoints());
-    for (unsigned int i = 0; i < points->GetNumberOfPoints(); i++)
-        polyLine->GetPointIds()->SetId(i, i);
-    cells->InsertNextCell(polyLine);
-    // Add the lines to the dataset
     polyData->SetLines(cells);
-    viewer->addModelFromPolyData(polyData, supervoxel_name);
+    return polyData;
+}
+
+/**
+ * Prepare the stepping through the thresholds of the segmentation of a frame
+ * 
+ * @param result    the results of the frame, with its hierarchy
+ * @param step      the threshold change of each step
+ * @param view      the view, colored at the threshold of the segmentation
+ * 
+ * @return false if the frame has no hierarchy
+ */
+bool makeThresholdView(const frameResult &result, float step,
+        thresholdView &view) {
+    const ClusteringT &segments = result.hierarchy_state.get_segments();
+    if (segments.empty())
+        return false;
+    try {
+        view.index.reset(new HierarchyIndex(result.hierarchy_state,
+                result.hierarchy_merges));
+    } catch (std::exception &e) {
+        console::print_error("%s\n", e.what());
+        return false;
+    }
+    // Voxels are numbered by the index in the order of their supervoxels
+    view.cloud = make_shared<PointCloudT>();
+    view.offsets.assign(1, 0);
+    ClusteringT::const_iterator it = segments.begin();
+    for (; it != segments.end(); ++it) {
+        *(view.cloud) += *(it->second->voxels_);
+        view.offsets.push_back(view.cloud->size());
+    }
+    view.base_threshold = view.threshold = result.threshold;
+    view.step = (step > 0) ? step : 0.005f;
+    cutThresholdView(view);
+    return true;
+}
+
+/**
+ * Color the voxels of a view as segmented at its threshold, with the same 
+ * colors given by Clustering::state2color to the same segmentation
+ * 
+ * @param view  the view
+ */
+void cutThresholdView(thresholdView &view) {
+    size_t segments_num = view.index->get_segments_num();
+    std::vector<uint32_t> regions(segments_num);
+    for (size_t s = 0; s < segments_num; ++s)
+        regions[s] = view.index->segment_region(s, view.threshold);
+    // Regions are colored in the order of their labels
+    std::vector<uint32_t> labels(regions);
+    std::sort(labels.begin(), labels.end());
+    labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+    uint8_t rgb[3];
+    for (size_t s = 0; s < segments_num; ++s) {
+        ColorUtilities::get_glasbey(std::lower_bound(labels.begin(),
+                labels.end(), regions[s]) - labels.begin(), rgb);
+        for (uint64_t v = view.offsets[s]; v < view.offsets[s + 1]; ++v) {
+            PointT &p = (*view.cloud)[v];
+            p.r = rgb[0];
+            p.g = rgb[1];
+            p.b = rgb[2];
+        }
+    }
+}
+
+/**
+ * Build the pyramid of decimations of a cloud
+ * 
+ * @param cloud         the cloud
+ * @param resolution    the cell size of the first level
+ * @param max_points    the largest number of points of the last level
+ * @param pyramid       the pyramid
+ */
+void buildPyramid(const PointCloudT &cloud, float resolution,
+        size_t max_points, lodPyramid &pyramid) {
+    const int key_bits = 21;
+    const int64_t key_offset = 1 << (key_bits - 1);
+    const uint64_t key_mask = (1 << key_bits) - 1;
+
+    pyramid.levels.clear();
+    std::vector<int> below(cloud.size());
+    for (size_t i = 0; i < below.size(); ++i)
+        below[i] = i;
+    while (below.size() > max_points && resolution > 0) {
+        std::vector<int> level;
+        std::unordered_set<uint64_t> cells;
+        std::vector<int>::const_iterator it = below.begin();
+        for (; it != below.end(); ++it) {
+            const PointT &p = cloud[*it];
+            uint64_t key = ((static_cast<uint64_t> (static_cast<int64_t> (
+                    std::floor(p.x / resolution)) + key_offset) & key_mask)
+                    << (2 * key_bits))
+                    | ((static_cast<uint64_t> (static_cast<int64_t> (
+                    std::floor(p.y / resolution)) + key_offset) & key_mask)
+                    << key_bits)
+                    | (static_cast<uint64_t> (static_cast<int64_t> (
+                    std::floor(p.z / resolution)) + key_offset) & key_mask);
+            if (cells.insert(key).second)
+                level.push_back(*it);
+        }
+        pyramid.levels.push_back(level);
+        below.swap(level);
+        resolution *= 2;
+    }
+}
+
+/**
+ * Get the cloud to be drawn in place of a cloud: its most decimated level if
+ * the camera is moving and it has a pyramid, the cloud itself otherwise
+ * 
+ * @param cloud     the cloud
+ * @param pyramids  the pyramids of the clouds
+ * 
+ * @return the cloud to be drawn
+ */
+PointCloudT::Ptr lodCloud(PointCloudT::Ptr cloud,
+        const std::map<const PointCloudT *, lodPyramid> &pyramids) {
+    if (!camera_moving)
+        return cloud;
+    std::map<const PointCloudT *, lodPyramid>::const_iterator p_it =
+            pyramids.find(cloud.get());
+    if (p_it == pyramids.end() || p_it->second.levels.empty())
+        return cloud;
+    const std::vector<int> &level = p_it->second.levels.back();
+    PointCloudT::Ptr decimated = make_shared<PointCloudT>();
+    decimated->reserve(level.size());
+    std::vector<int>::const_iterator it = level.begin();
+    for (; it != level.end(); ++it)
+        decimated->push_back((*cloud)[*it]);
+    return decimated;
+}
+
+/**
+ * Bring the viewer up to date with what is to be shown
+ */
+void updateViewer(shared_ptr<visualization::PCLVisualizer> viewer,
+        const std::map<uint32_t, Supervoxel<PointT>::Ptr> &supervoxel_clusters,
+        PointCloudT::Ptr colored_cloud, PointCloudT::Ptr segm_cloud,
+        PointCloudT::Ptr truth_cloud, PointNCloudT::Ptr normal_cloud,
+        const std::multimap<uint32_t, uint32_t> &adjacency, thresholdView *view,
+        const std::map<const PointCloudT *, lodPyramid> &pyramids,
+        bool &graph_added) {
+    if (view) {
+        float threshold = std::min(1.0f, std::max(0.0f,
+                view->base_threshold + threshold_steps * view->step));
+        threshold_steps = (int) round((threshold - view->base_threshold)
+                / view->step);
+        if (threshold != view->threshold) {
+            view->threshold = threshold;
+            cutThresholdView(*view);
+        }
+        segm_cloud = view->cloud;
+        char text[128];
+        snprintf(text, sizeof (text), "Threshold %.3f: %zu regions, press "
+                "(]) or ([) to change it", view->threshold,
+                view->index->regions_num(view->threshold));
+        if (!viewer->updateText(text, 5, 90, 12, 1.0, 1.0, 1.0,
+                "threshold_text"))
+            viewer->addText(text, 5, 90, 12, 1.0, 1.0, 1.0, "threshold_text");
+    }
+
+    if (show_voxel_centroids) {
+        PointCloudT::Ptr shown = lodCloud(colored_cloud, pyramids);
+        if (!viewer->updatePointCloud(shown, "voxel centroids"))
+            viewer->addPointCloud(shown, "voxel centroids");
+        viewer->setPointCloudRenderingProperties(
+                visualization::PCL_VISUALIZER_POINT_SIZE, 2.0,
+                "voxel centroids");
+        if (show_segmentation)
+            viewer->setPointCloudRenderingProperties(
+                visualization::PCL_VISUALIZER_OPACITY, 0.5,
+                "voxel centroids");
+        else
+            viewer->setPointCloudRenderingProperties(
+                visualization::PCL_VISUALIZER_OPACITY, 1.0,
+                "voxel centroids");
+    } else {
+        viewer->removePointCloud("voxel centroids");
+    }
+
+    if (show_segmentation) {
+        PointCloudT::Ptr shown = lodCloud(
+                (show_supervoxels) ? truth_cloud : segm_cloud, pyramids);
+        if (!viewer->updatePointCloud(shown, "colored voxels"))
+            viewer->addPointCloud(shown, "colored voxels");
+        viewer->setPointCloudRenderingProperties(
+                visualization::PCL_VISUALIZER_POINT_SIZE, 2.0,
+                "colored voxels");
+        viewer->setPointCloudRenderingProperties(
+                visualization::PCL_VISUALIZER_OPACITY, 0.9,
+                "colored voxels");
+    } else {
+        viewer->removePointCloud("colored voxels");
+    }
+
+    viewer->removePointCloud("supervoxel_normals");
+    if (show_supervoxel_normals)
+        viewer->addPointCloudNormals<PointNormal>(normal_cloud, 1, 0.05f,
+                "supervoxel_normals");
+
+    // The graph is built once, and then only hidden or shown again
+    if (show_graph && !graph_added) {
+        viewer->addModelFromPolyData(
+                makeGraphPolyData(supervoxel_clusters, adjacency), "graph");
+        graph_added = true;
+    }
+    if (graph_added)
+        viewer->setShapeRenderingProperties(
+                visualization::PCL_VISUALIZER_OPACITY, (show_graph) ? 1.0 : 0.0,
+                "graph");
+
+    if (show_help) {
+        viewer->removeShape("help_text");
+        printText(viewer);
+    } else {
+        removeText(viewer);
+        if (!viewer->updateText("Press h to show help", 5, 10, 12, 1.0, 1.0,
+                1.0, "help_text"))
+            viewer->addText("Press h to show help", 5, 10, 12, 1.0, 1.0,
+                1.0, "help_text");
+    }
 }
 
 void visualize(std::map<uint32_t, Supervoxel<PointT>::Ptr> supervoxel_clusters,
         PointCloudT::Ptr colored_cloud, PointCloudT::Ptr segm_cloud,
         PointCloudT::Ptr truth_cloud, PointNCloudT::Ptr normal_cloud,
-        std::multimap<uint32_t, uint32_t> adjacency) {
+        std::multimap<uint32_t, uint32_t> adjacency, thresholdView *view,
+        float resolution, size_t lod_points) {
     shared_ptr<visualization::PCLVisualizer> viewer(
             new visualization::PCLVisualizer("3D Viewer"));
     viewer->setBackgroundColor(0, 0, 0);
     viewer->registerKeyboardCallback(keyboard_callback, 0);
 
+    // Large clouds are decimated while the camera moves, with the pyramids
+    // built before the viewer opens
+    std::map<const PointCloudT *, lodPyramid> pyramids;
+    if (lod_points > 0) {
+        std::vector<PointCloudT::Ptr> clouds;
+        clouds.push_back(colored_cloud);
+        clouds.push_back(segm_cloud);
+        clouds.push_back(truth_cloud);
+        if (view)
+            clouds.push_back(view->cloud);
+        std::vector<PointCloudT::Ptr>::const_iterator c_it = clouds.begin();
+        for (; c_it != clouds.end(); ++c_it)
+            if (*c_it && (*c_it)->size() > lod_points
+                    && pyramids.count(c_it->get()) == 0)
+                buildPyramid(**c_it, 2 * resolution, lod_points,
+                    pyramids[c_it->get()]);
+        camera_moving = false;
+        viewer->registerMouseCallback(mouse_callback, 0);
+    }
+
     bool graph_added = false;
-    std::vector<std::string> poly_names;
+    viewer_changed = true;
+    threshold_steps = 0;
     console::print_info("Loading viewer...\n");
+    // The scene is only updated after a key changed it; in between, the 
+    // viewer just waits for events, rendering when the camera moves
     while (!viewer->wasStopped()) {
-        if (show_voxel_centroids) {
-            if (!viewer->updatePointCloud(colored_cloud, "voxel centroids"))
-                viewer->addPointCloud(colored_cloud, "voxel centroids");
-            viewer->setPointCloudRenderingProperties(
-                    visualization::PCL_VISUALIZER_POINT_SIZE, 2.0,
-                    "voxel centroids");
-            if (show_segmentation)
-                viewer->setPointCloudRenderingProperties(
-                    visualization::PCL_VISUALIZER_OPACITY, 0.5,
-                    "voxel centroids");
-            else
-                viewer->setPointCloudRenderingProperties(
-                    visualization::PCL_VISUALIZER_OPACITY, 1.0,
-                    "voxel centroids");
-        } else {
-            viewer->removePointCloud("voxel centroids");
-        }
-
-        if (show_segmentation) {
-            if (!viewer->updatePointCloud(
-                    (show_supervoxels) ? truth_cloud : segm_cloud,
-                    "colored voxels"))
-                viewer->addPointCloud(
-                    (show_supervoxels) ? truth_cloud : segm_cloud,
-                    "colored voxels");
-            viewer->setPointCloudRenderingProperties(
-                    visualization::PCL_VISUALIZER_POINT_SIZE, 2.0,
-                    "colored voxels");
-            viewer->setPointCloudRenderingProperties(
-                    visualization::PCL_VISUALIZER_OPACITY, 0.9,
-                    "colored voxels");
-        } else {
-            viewer->removePointCloud("colored voxels");
-        }
-
-        if (show_supervoxel_normals) {
-            viewer->addPointCloudNormals<PointNormal>(normal_cloud, 1, 0.05f,
-                    "supervoxel_normals");
-        } else if (!show_supervoxel_normals) {
-            viewer->removePointCloud("supervoxel_normals");
-        }
-
-        if (show_graph && !graph_added) {
-            poly_names.clear();
-            std::multimap<uint32_t, uint32_t>::iterator label_itr =
-                    adjacency.begin();
-            for (; label_itr != adjacency.end();) {
-                // First get the label
-                uint32_t supervoxel_label = label_itr->first;
-                // Now get the supervoxel corresponding to the label
-                Supervoxel<PointT>::Ptr supervoxel = supervoxel_clusters.at(
-                        supervoxel_label);
-                // Now we need to iterate through the adjacent supervoxels and
-                // make a point cloud of them
-                PointCloudT adjacent_supervoxel_centers;
-                std::multimap<uint32_t, uint32_t>::iterator adjacent_itr =
-                        adjacency.equal_range(supervoxel_label).first;
-                for (;
-                        adjacent_itr
-                        != adjacency.equal_range(supervoxel_label).second;
-                        ++adjacent_itr) {
-                    Supervoxel<PointT>::Ptr neighbor_supervoxel =
-                            supervoxel_clusters.at(adjacent_itr->second);
-                    adjacent_supervoxel_centers.push_back(
-                            neighbor_supervoxel->centroid_);
-                }
-                // Now we make a name for this polygon
-                std::stringstream ss;
-                ss << "supervoxel_" << supervoxel_label;
-                poly_names.push_back(ss.str());
-                addSupervoxelConnectionsToViewer(supervoxel->centroid_,
-                        adjacent_supervoxel_centers, ss.str(), viewer);
-                // Move iterator forward to next label
-                label_itr = adjacency.upper_bound(supervoxel_label);
-            }
-
-            graph_added = true;
-        } else if (!show_graph && graph_added) {
-            for (std::vector<std::string>::iterator name_itr =
-                    poly_names.begin(); name_itr != poly_names.end();
-                    ++name_itr) {
-                viewer->removeShape(*name_itr);
-            }
-            graph_added = false;
-        }
-
-        if (show_help) {
-            viewer->removeShape("help_text");
-            printText(viewer);
+        if (viewer_changed) {
+            viewer_changed = false;
+            updateViewer(viewer, supervoxel_clusters, colored_cloud,
+                    segm_cloud, truth_cloud, normal_cloud, adjacency, view,
+                    pyramids, graph_added);
+            viewer->spinOnce(1, true);
         } else {
-            removeText(viewer);
-            if (!viewer->updateText("Press h to show help", 5, 10, 12, 1.0, 1.0,
-                    1.0, "help_text"))
-                viewer->addText("Press h to show help", 5, 10, 12, 1.0, 1.0,
-                    1.0, "help_text");
+            viewer->spinOnce(100);
         }
-
-        viewer->spinOnce(100);
-        this_thread::sleep(posix_time::microseconds(100000));
-
     }
 }
 
@@ -0,0 +1,243 @@
+/*
+ * task_graph.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdexcept>
+
+#include <boost/chrono.hpp>
+
+#include "supervoxel_clustering/task_graph.h"
+
+/**
+ * Constructor for the TaskGraph class
+ * 
+ * @param thread_pool   the pool on which ready tasks are offered; if NULL, all
+ *                      tasks are executed by the thread calling run
+ */
+TaskGraph::TaskGraph(ThreadPool *thread_pool) :
+state(new graphState) {
+    state->pool = thread_pool;
+    state->remaining = 0;
+}
+
+/**
+ * Add a task to the graph
+ * 
+ * @param name          the name of the task, used to report its timing
+ * @param task          the function to be executed
+ * @param dependencies  the indices of the tasks to be completed before this
+ *                      one is started
+ * 
+ * @return the index of the task
+ */
+size_t TaskGraph::add_task(std::string name, TaskT task,
+        std::vector<size_t> dependencies) {
+    std::vector<taskNode> &nodes = state->nodes;
+    size_t index = nodes.size();
+    taskNode node;
+    node.name = name;
+    node.task = task;
+    node.dependencies = dependencies.size();
+    node.waiting = 0;
+    node.skipped = false;
+    node.time = 0;
+    std::vector<size_t>::iterator it = dependencies.begin();
+    for (; it != dependencies.end(); ++it) {
+        if (*it >= index)
+            throw std::invalid_argument("Task '" + name
+                + "' depends on a task not yet added");
+        nodes[*it].successors.push_back(index);
+    }
+    nodes.push_back(node);
+    return index;
+}
+
+/**
+ * Skip a task, and all the tasks depending on it, because a task it depends on
+ * failed; it has to be called holding the mutex of the state
+ * 
+ * @param state the state of the graph
+ * @param index the index of the task
+ */
+void TaskGraph::skip(graphState &state, size_t index) {
+    taskNode &node = state.nodes[index];
+    if (node.skipped)
+        return;
+    node.skipped = true;
+    --state.remaining;
+    std::vector<size_t>::iterator it = node.successors.begin();
+    for (; it != node.successors.end(); ++it)
+        skip(state, *it);
+}
+
+/**
+ * Execute a task and release the tasks depending on it, or skip them if it
+ * fails
+ * 
+ * @param state the state of the graph
+ * @param index the index of the task
+ */
+void TaskGraph::execute(boost::shared_ptr<graphState> state, size_t index) {
+    taskNode &node = state->nodes[index];
+    boost::chrono::steady_clock::time_point start =
+            boost::chrono::steady_clock::now();
+    std::string failure;
+    try {
+        node.task();
+    } catch (std::exception &e) {
+        failure = node.name + ": " + e.what();
+    } catch (...) {
+        failure = node.name + ": unknown error";
+    }
+    double time = boost::chrono::duration<double, boost::milli>(
+            boost::chrono::steady_clock::now() - start).count();
+
+    size_t released = 0;
+    {
+        boost::mutex::scoped_lock lock(state->mutex);
+        node.time = time;
+        if (!failure.empty() && state->error.empty())
+            state->error = failure;
+        std::vector<size_t>::iterator it = node.successors.begin();
+        for (; it != node.successors.end(); ++it) {
+            if (!failure.empty())
+                skip(*state, *it);
+            else if (--state->nodes[*it].waiting == 0
+                    && !state->nodes[*it].skipped) {
+                state->ready.push_back(*it);
+                ++released;
+            }
+        }
+        --state->remaining;
+    }
+    state->changed.notify_all();
+    // The thread executing this task picks one of the released tasks itself
+    // (or the caller of run does), the others are offered to the pool
+    if (state->pool)
+        for (size_t i = 1; i < released; ++i)
+            state->pool->submit(boost::bind(&TaskGraph::run_ready, state));
+}
+
+/**
+ * Execute the ready tasks, if any is left; this is what is offered to the
+ * pool
+ * 
+ * @param state the state of the graph
+ */
+void TaskGraph::run_ready(boost::shared_ptr<graphState> state) {
+    for (;;) {
+        size_t index;
+        {
+            boost::mutex::scoped_lock lock(state->mutex);
+            if (state->ready.empty())
+                return;
+            index = state->ready.front();
+            state->ready.pop_front();
+        }
+        execute(state, index);
+    }
+}
+
+/**
+ * Execute all the tasks of the graph, returning once they are completed
+ * 
+ * @throws std::runtime_error if any task failed; the tasks depending on the
+ * failed one are skipped, while the others are completed anyway
+ */
+void TaskGraph::run() {
+    size_t roots = 0;
+    {
+        boost::mutex::scoped_lock lock(state->mutex);
+        state->remaining = state->nodes.size();
+        state->error.clear();
+        state->ready.clear();
+        for (size_t i = 0; i < state->nodes.size(); ++i) {
+            state->nodes[i].waiting = state->nodes[i].dependencies;
+            state->nodes[i].skipped = false;
+            if (state->nodes[i].waiting == 0)
+                state->ready.push_back(i);
+        }
+        roots = state->ready.size();
+    }
+    // One ready task is kept for the calling thread, the others are offered
+    // to the pool
+    if (state->pool)
+        for (size_t i = 1; i < roots; ++i)
+            state->pool->submit(boost::bind(&TaskGraph::run_ready, state));
+
+    boost::mutex::scoped_lock lock(state->mutex);
+    while (state->remaining != 0) {
+        if (state->ready.empty()) {
+            state->changed.wait(lock);
+            continue;
+        }
+        size_t index = state->ready.front();
+        state->ready.pop_front();
+        lock.unlock();
+        execute(state, index);
+        lock.lock();
+    }
+    if (!state->error.empty())
+        throw std::runtime_error(state->error);
+}
+
+/**
+ * Get the time taken by each task during the last run
+ * 
+ * @return the name and the time in milliseconds of each task
+ */
+std::vector<std::pair<std::string, double> > TaskGraph::get_timings() const {
+    std::vector<std::pair<std::string, double> > timings;
+    get_timings(timings);
+    return timings;
+}
+
+/**
+ * Get the time taken by each task during the last run, reusing the memory of
+ * the given vector
+ * 
+ * @param timings   the vector in which the name and the time in milliseconds
+ *                  of each task are written
+ */
+void TaskGraph::get_timings(
+        std::vector<std::pair<std::string, double> > &timings) const {
+    timings.clear();
+    std::vector<taskNode>::const_iterator it = state->nodes.begin();
+    for (; it != state->nodes.end(); ++it)
+        timings.push_back(std::make_pair(it->name, it->time));
+}
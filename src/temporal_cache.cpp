@@ -0,0 +1,352 @@
+/*
+ * temporal_cache.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/kdtree/kdtree_flann.h>
+
+#include "supervoxel_clustering/temporal_cache.h"
+
+/**
+ * Constructor for the seeded supervoxel extraction
+ * 
+ * @param voxel_resolution  the resolution of the voxel grid
+ * @param seed_resolution   the distance between initial seeds
+ */
+SeededSupervoxelClustering::SeededSupervoxelClustering(float voxel_resolution,
+        float seed_resolution) :
+pcl::SupervoxelClustering<PointT>(voxel_resolution, seed_resolution) {
+}
+
+/**
+ * Select the voxels to be used as supervoxel seeds. Each previous centroid is 
+ * snapped to its closest voxel; standard seeds are kept only if no previous 
+ * centroid was placed within half the seed resolution from them.
+ * 
+ * @param seed_indices  the indices of the selected voxels
+ */
+void SeededSupervoxelClustering::select_seeds(std::vector<int> &seed_indices) {
+    std::vector<int> standard_seeds;
+    selectInitialSupervoxelSeeds(standard_seeds);
+
+    if (!previous_centroids || previous_centroids->empty()) {
+        seed_indices = standard_seeds;
+        return;
+    }
+
+    float max_dist = seed_resolution_ / 2;
+    std::vector<int> k_indices(1);
+    std::vector<float> k_sqr_dists(1);
+
+    pcl::KdTreeFLANN<PointT> voxel_tree;
+    voxel_tree.setInputCloud(voxel_centroid_cloud_);
+
+    std::set<int> prior_seeds;
+    PointCloudT::Ptr prior_cloud(new PointCloudT);
+    PointCloudT::iterator it = previous_centroids->begin();
+    for (; it != previous_centroids->end(); ++it) {
+        if (voxel_tree.nearestKSearch(*it, 1, k_indices, k_sqr_dists) > 0
+                && k_sqr_dists[0] < max_dist * max_dist
+                && prior_seeds.insert(k_indices[0]).second) {
+            prior_cloud->push_back(voxel_centroid_cloud_->at(k_indices[0]));
+        }
+    }
+
+    seed_indices.assign(prior_seeds.begin(), prior_seeds.end());
+    if (prior_cloud->empty()) {
+        seed_indices = standard_seeds;
+        return;
+    }
+
+    pcl::KdTreeFLANN<PointT> prior_tree;
+    prior_tree.setInputCloud(prior_cloud);
+    std::vector<int>::iterator s_it = standard_seeds.begin();
+    for (; s_it != standard_seeds.end(); ++s_it) {
+        const PointT &seed = voxel_centroid_cloud_->at(*s_it);
+        if (prior_tree.nearestKSearch(seed, 1, k_indices, k_sqr_dists) == 0
+                || k_sqr_dists[0] >= max_dist * max_dist)
+            seed_indices.push_back(*s_it);
+    }
+
+    pcl::console::print_debug("Seeding: %zu from previous frame, %zu new\n",
+            prior_seeds.size(), seed_indices.size() - prior_seeds.size());
+}
+
+/**
+ * Extract the supervoxels. This follows the same steps as 
+ * pcl::SupervoxelClustering::extract, replacing only the seed selection.
+ * 
+ * @param supervoxel_clusters   the extracted supervoxels, each identified by
+ *                              an unique label
+ */
+void SeededSupervoxelClustering::extract(ClusteringT &supervoxel_clusters) {
+    if (!initCompute()) {
+        deinitCompute();
+        return;
+    }
+
+    if (!prepareForSegmentation()) {
+        deinitCompute();
+        return;
+    }
+
+    std::vector<int> seed_indices;
+    select_seeds(seed_indices);
+    createSupervoxelHelpers(seed_indices);
+
+    int max_depth = static_cast<int> (1.8f * seed_resolution_ / resolution_);
+    expandSupervoxels(max_depth);
+
+    makeSupervoxels(supervoxel_clusters);
+    deinitCompute();
+}
+
+/**
+ * Compute the statistics of a supervoxel used to detect changes between frames
+ * 
+ * @param s a supervoxel
+ * 
+ * @return the signature of the supervoxel
+ */
+TemporalCache::supervoxelSignature TemporalCache::signature(
+        SupervoxelT::Ptr s) const {
+    supervoxelSignature sig;
+    sig.centroid = s->centroid_;
+    sig.normal = s->normal_;
+    float * rgb = ColorUtilities::mean_color(s);
+    sig.rgb[0] = rgb[0];
+    sig.rgb[1] = rgb[1];
+    sig.rgb[2] = rgb[2];
+    delete[] rgb;
+    sig.size = s->voxels_->size();
+    return sig;
+}
+
+/**
+ * Check if two supervoxel signatures are within the tolerances of the cache
+ * 
+ * @param s1    the first signature
+ * @param s2    the second signature
+ * 
+ * @return true if the two supervoxels can be considered unchanged
+ */
+bool TemporalCache::similar(const supervoxelSignature &s1,
+        const supervoxelSignature &s2) const {
+    Eigen::Vector3f C = s1.centroid.getVector3fMap()
+            - s2.centroid.getVector3fMap();
+    if (C.norm() > max_distance)
+        return false;
+
+    float rgb1[3] = {s1.rgb[0], s1.rgb[1], s1.rgb[2]};
+    float rgb2[3] = {s2.rgb[0], s2.rgb[1], s2.rgb[2]};
+    if (ColorUtilities::rgb_eucl(rgb1, rgb2) / RGB_RANGE > max_color_diff)
+        return false;
+
+    float cos = s1.normal.getNormalVector3fMap().dot(
+            s2.normal.getNormalVector3fMap());
+    if (cos < min_normal_cos)
+        return false;
+
+    float size1 = s1.size;
+    float size2 = s2.size;
+    float ratio = std::max(size1, size2) / std::max(1.0f, std::min(size1,
+            size2));
+    return ratio <= max_size_ratio;
+}
+
+/**
+ * Build the key of an edge, independent from the order of its two labels
+ * 
+ * @param l1    the first label
+ * @param l2    the second label
+ * 
+ * @return the edge key
+ */
+EdgeT TemporalCache::edge(uint32_t l1, uint32_t l2) {
+    return (l1 < l2) ? EdgeT(l1, l2) : EdgeT(l2, l1);
+}
+
+/**
+ * The default constructor
+ */
+TemporalCache::TemporalCache() {
+    set_tolerances(0.01, 0.02, 10, 1.2);
+    previous_centroids = boost::make_shared<PointCloudT>();
+}
+
+/**
+ * Set the tolerances used to decide if a supervoxel is unchanged from the 
+ * previous frame
+ * 
+ * @param distance      the maximum displacement of the centroid
+ * @param color         the maximum RGB distance of the mean color, 
+ *                      normalized in [0, 1]
+ * @param normal_angle  the maximum angle between normals, in degrees
+ * @param size_ratio    the maximum ratio between the number of voxels
+ */
+void TemporalCache::set_tolerances(float distance, float color,
+        float normal_angle, float size_ratio) {
+    if (distance < 0 || color < 0 || normal_angle < 0 || size_ratio < 1)
+        throw std::invalid_argument("Invalid temporal tolerances");
+    max_distance = distance;
+    max_color_diff = color;
+    min_normal_cos = std::cos(normal_angle * M_PI / 180);
+    max_size_ratio = size_ratio;
+}
+
+/**
+ * Start processing a new frame, matching its supervoxels to the ones of the 
+ * previous frame
+ * 
+ * @param supervoxels   the supervoxels of the new frame
+ */
+void TemporalCache::begin_frame(const ClusteringT &supervoxels) {
+    matches.clear();
+    current_signatures.clear();
+    current_deltas.clear();
+    stats = temporalStats();
+    stats.supervoxels = supervoxels.size();
+
+    PointCloudT::Ptr reference_cloud(new PointCloudT);
+    std::vector<uint32_t> reference_labels;
+    SignatureMapT::iterator s_it = previous_signatures.begin();
+    for (; s_it != previous_signatures.end(); ++s_it) {
+        reference_cloud->push_back(s_it->second.centroid);
+        reference_labels.push_back(s_it->first);
+    }
+
+    pcl::KdTreeFLANN<PointT> tree;
+    if (!reference_cloud->empty())
+        tree.setInputCloud(reference_cloud);
+
+    std::map<uint32_t, std::pair<float, uint32_t> > best;
+    std::vector<int> k_indices(1);
+    std::vector<float> k_sqr_dists(1);
+    ClusteringT::const_iterator it = supervoxels.begin();
+    for (; it != supervoxels.end(); ++it) {
+        supervoxelSignature sig = signature(it->second);
+        current_signatures.insert(
+                std::pair<uint32_t, supervoxelSignature>(it->first, sig));
+        if (reference_cloud->empty()
+                || tree.nearestKSearch(sig.centroid, 1, k_indices,
+                k_sqr_dists) == 0)
+            continue;
+        uint32_t prev_label = reference_labels[k_indices[0]];
+        if (!similar(sig, previous_signatures.at(prev_label)))
+            continue;
+        // Keep the match one-to-one, preferring the closest supervoxel
+        std::map<uint32_t, std::pair<float, uint32_t> >::iterator b_it =
+                best.find(prev_label);
+        if (b_it == best.end() || k_sqr_dists[0] < b_it->second.first)
+            best[prev_label] = std::pair<float, uint32_t>(k_sqr_dists[0],
+                it->first);
+    }
+
+    std::map<uint32_t, std::pair<float, uint32_t> >::iterator b_it =
+            best.begin();
+    for (; b_it != best.end(); ++b_it) {
+        uint32_t curr_label = b_it->second.second;
+        matches.insert(std::pair<uint32_t, uint32_t>(curr_label, b_it->first));
+        current_signatures.at(curr_label) = previous_signatures.at(
+                b_it->first);
+    }
+    stats.matched_supervoxels = matches.size();
+
+    previous_centroids = boost::make_shared<PointCloudT>();
+    for (it = supervoxels.begin(); it != supervoxels.end(); ++it)
+        previous_centroids->push_back(it->second->centroid_);
+}
+
+/**
+ * Look for the distances of an edge of the current frame in the cache
+ * 
+ * @param l1        the label of the first region
+ * @param l2        the label of the second region
+ * @param deltas    if found, the cached color and geometric distances
+ * 
+ * @return true if the distances can be reused, false otherwise
+ */
+bool TemporalCache::lookup(uint32_t l1, uint32_t l2, DeltasT &deltas) {
+    stats.edges++;
+    std::map<uint32_t, uint32_t>::iterator m1 = matches.find(l1);
+    std::map<uint32_t, uint32_t>::iterator m2 = matches.find(l2);
+    if (m1 == matches.end() || m2 == matches.end())
+        return false;
+    DeltasMapT::iterator d = previous_deltas.find(edge(m1->second,
+            m2->second));
+    if (d == previous_deltas.end())
+        return false;
+    deltas = d->second;
+    stats.reused_edges++;
+    return true;
+}
+
+/**
+ * Store the distances of an edge of the current frame, so that they can be 
+ * reused in the next one
+ * 
+ * @param l1        the label of the first region
+ * @param l2        the label of the second region
+ * @param deltas    the color and geometric distances
+ */
+void TemporalCache::store(uint32_t l1, uint32_t l2, DeltasT deltas) {
+    current_deltas[edge(l1, l2)] = deltas;
+}
+
+/**
+ * Conclude the current frame, making it the reference for the next one
+ */
+void TemporalCache::end_frame() {
+    previous_signatures.swap(current_signatures);
+    previous_deltas.swap(current_deltas);
+    current_signatures.clear();
+    current_deltas.clear();
+    matches.clear();
+}
+
+/**
+ * Forget all previous frames
+ */
+void TemporalCache::clear() {
+    previous_signatures.clear();
+    previous_deltas.clear();
+    current_signatures.clear();
+    current_deltas.clear();
+    matches.clear();
+    previous_centroids = boost::make_shared<PointCloudT>();
+    stats = temporalStats();
+}
@@ -53,32 +53,44 @@ void Testing::init_performance() {
 }
 
 /**
- * Converts a segmented pointcloud into a map of segments
+ * Converts a segmented pointcloud into a map of segments. The pointclouds 
+ * already stored in the map are reused, and the points of each segment are 
+ * sorted according to their coordinates.
  * 
  * @param in    the pointcloud to be converted
- * 
- * @return a map where each segment can be accessed by its label
+ * @param map   a map where each segment can be accessed by its label
  */
-labelMapT Testing::label_map(PointLCloudT::Ptr in) {
-    labelMapT map_temp, map;
+void Testing::label_map(PointLCloudT::Ptr in, labelMapT &map) {
+    label_buffer.clear();
     PointLCloudT::iterator it = in->begin();
-    for (; it != in->end(); ++it) {
-        uint32_t l = it->label;
-        if (map_temp.count(l) == 0) {
-            PointLCloudT::Ptr subcloud = extract_label_cloud(in, l);
-            map_temp.insert(
-                    std::pair<uint32_t, PointLCloudT::Ptr>(l, subcloud));
-        }
+    for (; it != in->end(); ++it)
+        label_buffer.push_back(it->label);
+    std::sort(label_buffer.begin(), label_buffer.end());
+    label_buffer.erase(std::unique(label_buffer.begin(), label_buffer.end()),
+            label_buffer.end());
+
+    uint32_t n = label_buffer.size();
+    segment_buffer.resize(n);
+    for (uint32_t l = 0; l < n; l++) {
+        labelMapT::iterator it_m = map.find(l);
+        if (it_m == map.end())
+            it_m = map.insert(std::pair<uint32_t, PointLCloudT::Ptr>(l,
+                boost::make_shared<PointLCloudT>())).first;
+        else
+            it_m->second->clear();
+        segment_buffer[l] = it_m->second.get();
     }
+    map.erase(map.lower_bound(n), map.end());
 
-    uint32_t new_l = 0;
-    labelMapT::iterator it_m = map_temp.begin();
-    for (; it_m != map_temp.end(); ++it_m) {
-        map.insert(std::pair<uint32_t, PointLCloudT::Ptr>(new_l, it_m->second));
-        new_l++;
+    for (it = in->begin(); it != in->end(); ++it) {
+        uint32_t l = std::lower_bound(label_buffer.begin(), label_buffer.end(),
+                it->label) - label_buffer.begin();
+        segment_buffer[l]->push_back(*it);
     }
 
-    return map;
+    compareXYZ cmp;
+    for (uint32_t l = 0; l < n; l++)
+        std::sort(segment_buffer[l]->begin(), segment_buffer[l]->end(), cmp);
 }
 
 /**
@@ -88,22 +100,29 @@ labelMapT Testing::label_map(PointLCloudT::Ptr in) {
 void Testing::compute_intersections() {
     uint32_t n = segm_labels.size();
     uint32_t m = truth_labels.size();
-    inter_matrix = Eigen::Matrix<size_t, Eigen::Dynamic, Eigen::Dynamic>::Zero(
-            n, m);
-    matches = Eigen::Array<int64_t, 1, Eigen::Dynamic>::Zero(1, m) - 1;
-
-    std::map<size_t, uint32_t> t_sizes;
+    inter_matrix.setZero(n, m);
+    matches.setConstant(1, m, -1);
+
+    // Groundtruth segments are matched from the largest, and only the first 
+    // segment of each size is matched
+    size_buffer.clear();
+    uint32_t j = 0;
+    labelMapT::iterator it_t = truth_labels.begin();
+    for (; it_t != truth_labels.end(); ++it_t, ++j)
+        size_buffer.push_back(std::pair<size_t, uint32_t>(
+                it_t->second->size(), j));
+    std::sort(size_buffer.begin(), size_buffer.end(), larger_size);
+    size_buffer.erase(std::unique(size_buffer.begin(), size_buffer.end(),
+            same_size), size_buffer.end());
 
     labelMapT::iterator it_s = segm_labels.begin();
 
     uint32_t i = 0;
     for (; it_s != segm_labels.end(); ++it_s) {
-        uint32_t j = 0;
-        labelMapT::iterator it_t = truth_labels.begin();
+        j = 0;
+        it_t = truth_labels.begin();
 
         for (; it_t != truth_labels.end(); ++it_t) {
-            t_sizes.insert(
-                    std::pair<size_t, uint32_t>(it_t->second->size(), j));
             size_t inter = count_intersect(it_s->second, it_t->second);
             inter_matrix(i, j) = inter;
             j++;
@@ -111,10 +130,11 @@ void Testing::compute_intersections() {
         i++;
     }
 
-    std::map<size_t, uint32_t>::reverse_iterator it_ts = t_sizes.rbegin();
-    for (; it_ts != t_sizes.rend(); ++it_ts) {
-        Eigen::Matrix<size_t, Eigen::Dynamic, 1> col = inter_matrix.col(
-                it_ts->second);
+    std::vector<std::pair<size_t, uint32_t> >::iterator it_ts =
+            size_buffer.begin();
+    for (; it_ts != size_buffer.end(); ++it_ts) {
+        column_buffer = inter_matrix.col(it_ts->second);
+        Eigen::Matrix<size_t, Eigen::Dynamic, 1> &col = column_buffer;
         int64_t row;
         size_t max = col.maxCoeff(&row);
         pcl::console::print_debug("Testing best match: %d - %d - %d\t",
@@ -145,30 +165,11 @@ void Testing::compute_intersections() {
     //std::cout << "Best matches:\n" << matches << "\n";
 }
 
-/**
- * Extract all points corresponding to a region from the segmentation
- * @param c     the segmentation
- * @param label the label of the region to be extracted
- * 
- * @return a pointcloud containing all points corresponding to the given region
- */
-PointLCloudT::Ptr Testing::extract_label_cloud(PointLCloudT::Ptr c,
-        uint32_t label) const {
-    PointLCloudT::Ptr subcloud = boost::make_shared<PointLCloudT>();
-    PointLCloudT::iterator it = c->begin();
-    for (; it != c->end(); ++it) {
-        if (it->label == label)
-            subcloud->push_back(*it);
-    }
-
-    return subcloud;
-}
-
 /**
  * Compute the number of points in the intersection between two regions
  * 
- * @param c1    the first region
- * @param c2    the second region
+ * @param c1    the first region, sorted by coordinates
+ * @param c2    the second region, sorted by coordinates
  * 
  * @return the cardinality of the intersection between the two given regions
  */
@@ -179,43 +180,64 @@ size_t Testing::count_intersect(PointLCloudT::Ptr c1,
 
     compareXYZ cmp;
 
-    PointLVectorT c1s = c1->points;
-    PointLVectorT c2s = c2->points;
-
-    std::sort(c1s.begin(), c1s.end(), cmp);
-    std::sort(c2s.begin(), c2s.end(), cmp);
-
-    PointLVectorT res;
-
-    std::set_intersection(c1s.begin(), c1s.end(), c2s.begin(), c2s.end(),
-            std::back_inserter(res), cmp);
-    return res.size();
+    size_t count = 0;
+    PointLCloudT::const_iterator it1 = c1->begin();
+    PointLCloudT::const_iterator it2 = c2->begin();
+    while (it1 != c1->end() && it2 != c2->end()) {
+        if (cmp(*it1, *it2))
+            ++it1;
+        else if (cmp(*it2, *it1))
+            ++it2;
+        else {
+            count++;
+            ++it1;
+            ++it2;
+        }
+    }
+    return count;
 }
 
 /**
  * Compute the number of points in the union of two regions
  * 
- * @param c1    the first region
- * @param c2    the second region
+ * @param c1    the first region, sorted by coordinates
+ * @param c2    the second region, sorted by coordinates
  * 
  * @return the cardinality of the union of the two given regions
  */
 size_t Testing::count_union(PointLCloudT::Ptr c1, PointLCloudT::Ptr c2) const {
     pcl::console::print_debug("Searching union: %d - %d\n", c1->size(), c2->size());
 
-    compareXYZ cmp;
-
-    PointLVectorT c1s = c1->points;
-    PointLVectorT c2s = c2->points;
-
-    std::sort(c1s.begin(), c1s.end(), cmp);
-    std::sort(c2s.begin(), c2s.end(), cmp);
+    return c1->size() + c2->size() - count_intersect(c1, c2);
+}
 
-    PointLVectorT res;
+/**
+ * Order two groundtruth segments by decreasing size, and by increasing index 
+ * if they have the same size
+ * 
+ * @param s1    the size and the index of the first segment
+ * @param s2    the size and the index of the second segment
+ * 
+ * @return true if the first segment comes before the second
+ */
+bool Testing::larger_size(const std::pair<size_t, uint32_t> &s1,
+        const std::pair<size_t, uint32_t> &s2) {
+    if (s1.first != s2.first)
+        return s1.first > s2.first;
+    return s1.second < s2.second;
+}
 
-    std::set_union(c1s.begin(), c1s.end(), c2s.begin(), c2s.end(),
-            std::back_inserter(res), cmp);
-    return res.size();
+/**
+ * Check whether two groundtruth segments have the same size
+ * 
+ * @param s1    the size and the index of the first segment
+ * @param s2    the size and the index of the second segment
+ * 
+ * @return true if the two segments have the same size
+ */
+bool Testing::same_size(const std::pair<size_t, uint32_t> &s1,
+        const std::pair<size_t, uint32_t> &s2) {
+    return s1.first == s2.first;
 }
 
 /**
@@ -416,7 +438,7 @@ void Testing::set_segm(PointLCloudT::Ptr s) {
             "The pointcloud to be set as 'segm' cannot be empty");
     segm = s;
     init_performance();
-    segm_labels = label_map(s);
+    label_map(s, segm_labels);
     is_set_segm = true;
     if (is_set_truth)
         compute_intersections();
@@ -433,8 +455,22 @@ void Testing::set_truth(PointLCloudT::Ptr t) {
             "The pointcloud to be set as 'truth' cannot be empty");
     truth = t;
     init_performance();
-    truth_labels = label_map(t);
+    label_map(t, truth_labels);
     is_set_truth = true;
     if (is_set_segm)
         compute_intersections();
 }
+
+/**
+ * Set both the segmentation to be tested and the groundtruth, computing their
+ * intersections only once
+ * 
+ * @param s the new segmentation to be tested
+ * @param t the new segmentation to be used as groundtruth
+ */
+void Testing::set_clouds(PointLCloudT::Ptr s, PointLCloudT::Ptr t) {
+    is_set_segm = false;
+    is_set_truth = false;
+    set_segm(s);
+    set_truth(t);
+}
@@ -0,0 +1,236 @@
+/*
+ * thread_pool.cpp
+ *
+ *  Created on: 18/10/2026
+ *      Author: Francesco Verdoja <francesco.verdoja@aalto.fi>
+ *
+ *
+ * BSD 3-Clause License
+ * 
+ * Copyright (c) 2015, Francesco Verdoja
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * 
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * 
+ * * Neither the name of the copyright holder nor the names of its 
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pcl/console/print.h>
+
+#include "supervoxel_clustering/thread_pool.h"
+
+// Pool and queue index of the worker running on the current thread, if any
+static thread_local ThreadPool *current_pool = NULL;
+static thread_local size_t current_index = 0;
+
+/**
+ * Constructor for the ThreadPool class
+ * 
+ * @param threads   the number of worker threads; if 0, one thread for each
+ *                  hardware core is started
+ */
+ThreadPool::ThreadPool(size_t threads) :
+queued(0), pending(0), next_queue(0), stopping(false),
+start_time(boost::chrono::steady_clock::now()) {
+    if (threads == 0)
+        threads = std::max(1u, boost::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; ++i)
+        queues.push_back(boost::shared_ptr<workerQueue>(new workerQueue));
+    for (size_t i = 0; i < threads; ++i)
+        workers.create_thread(boost::bind(&ThreadPool::work, this, i));
+}
+
+/**
+ * Destructor for the ThreadPool class; the tasks already queued are completed
+ * before the workers are stopped
+ */
+ThreadPool::~ThreadPool() {
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+    workers.join_all();
+}
+
+/**
+ * Take a task for a worker: the newest task of its own queue or, if that is 
+ * empty, the oldest task of another queue
+ * 
+ * @param index the index of the worker
+ * @param task  the task taken
+ * 
+ * @return true if a task was taken, false if all queues were empty
+ */
+bool ThreadPool::take(size_t index, TaskT &task) {
+    {
+        workerQueue &own = *queues[index];
+        boost::mutex::scoped_lock lock(own.mutex);
+        if (!own.queue.empty()) {
+            task = own.queue.back();
+            own.queue.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+        workerQueue &victim = *queues[(index + i) % queues.size()];
+        {
+            boost::mutex::scoped_lock lock(victim.mutex);
+            if (victim.queue.empty())
+                continue;
+            task = victim.queue.front();
+            victim.queue.pop_front();
+        }
+        // Only one queue lock is held at a time, so that two workers 
+        // stealing from each other can't deadlock
+        boost::mutex::scoped_lock lock(queues[index]->mutex);
+        ++queues[index]->stolen_tasks;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Loop executed by each worker: take tasks and run them, sleeping while all
+ * queues are empty
+ * 
+ * @param index the index of the worker
+ */
+void ThreadPool::work(size_t index) {
+    current_pool = this;
+    current_index = index;
+    workerQueue &own = *queues[index];
+    for (;;) {
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            while (queued == 0 && !stopping)
+                task_available.wait(lock);
+            if (queued == 0)
+                return;
+        }
+        TaskT task;
+        if (!take(index, task))
+            continue;
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            --queued;
+        }
+
+        boost::chrono::steady_clock::time_point start =
+                boost::chrono::steady_clock::now();
+        try {
+            task();
+        } catch (std::exception &e) {
+            pcl::console::print_error("Task failed: %s\n", e.what());
+        }
+        double time = boost::chrono::duration<double>(
+                boost::chrono::steady_clock::now() - start).count();
+        {
+            boost::mutex::scoped_lock lock(own.mutex);
+            ++own.tasks;
+            own.busy_time += time;
+        }
+        {
+            boost::mutex::scoped_lock lock(mutex);
+            if (--pending == 0)
+                queue_empty.notify_all();
+        }
+    }
+}
+
+/**
+ * Queue a task for execution by one of the workers
+ * 
+ * @param task  the task to be executed
+ */
+void ThreadPool::submit(TaskT task) {
+    size_t index;
+    if (current_pool == this) {
+        index = current_index;
+    } else {
+        boost::mutex::scoped_lock lock(mutex);
+        index = next_queue++ % queues.size();
+    }
+    // The task is counted under the same lock as it is pushed: a worker 
+    // already awake can take it as soon as it is in the queue, and must not 
+    // find it uncounted
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        boost::mutex::scoped_lock queue_lock(queues[index]->mutex);
+        queues[index]->queue.push_back(task);
+        ++queued;
+        ++pending;
+    }
+    task_available.notify_one();
+}
+
+/**
+ * Block until all the submitted tasks have been completed; this must not be
+ * called by a task running on the pool
+ */
+void ThreadPool::wait() {
+    boost::mutex::scoped_lock lock(mutex);
+    while (pending != 0)
+        queue_empty.wait(lock);
+}
+
+/**
+ * Get the number of tasks executed and the share of time the workers spent 
+ * running them since the creation of the pool or the last reset
+ * 
+ * @return the statistics of the pool
+ */
+poolStats ThreadPool::get_stats() {
+    poolStats stats;
+    for (size_t i = 0; i < queues.size(); ++i) {
+        boost::mutex::scoped_lock lock(queues[i]->mutex);
+        stats.tasks += queues[i]->tasks;
+        stats.stolen_tasks += queues[i]->stolen_tasks;
+        stats.busy_time += queues[i]->busy_time;
+    }
+    {
+        boost::mutex::scoped_lock lock(mutex);
+        stats.elapsed_time = boost::chrono::duration<double>(
+                boost::chrono::steady_clock::now() - start_time).count();
+    }
+    if (stats.elapsed_time > 0)
+        stats.utilization = stats.busy_time
+            / (stats.elapsed_time * queues.size());
+    return stats;
+}
+
+/**
+ * Reset the statistics of the pool
+ */
+void ThreadPool::reset_stats() {
+    for (size_t i = 0; i < queues.size(); ++i) {
+        boost::mutex::scoped_lock lock(queues[i]->mutex);
+        queues[i]->tasks = 0;
+        queues[i]->stolen_tasks = 0;
+        queues[i]->busy_time = 0;
+    }
+    boost::mutex::scoped_lock lock(mutex);
+    start_time = boost::chrono::steady_clock::now();
+}